@@ -144,6 +144,13 @@ class BasicCache {
 			return readCategories(packagetree, NULLPTR, NULLPTR);
 		}
 
+		/**
+		Hint that cat_name is read soon (while the current category is read).
+		The cache may ask the kernel to read the corresponding files ahead.
+		**/
+		ATTRIBUTE_NONNULL_ virtual void prefetchCategory(const char * /* cat_name */) {
+		}
+
 		/**
 		Prepare reading Cache for an individual category.
 		If not overloaded, then readCategories() must be overloaded.
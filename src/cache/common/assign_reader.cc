@@ -14,10 +14,12 @@
 #include <cstring>
 #include <ctime>
 
-#include <fstream>
+#include <algorithm>
 #include <string>
 
 #include "cache/base.h"
+#include "cache/common/dir_handle.h"
+#include "eixTk/diagnostics.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
@@ -30,98 +32,174 @@
 
 using std::string;
 
-using std::ifstream;
+/**
+Perfect hash of the keys we use: For each length the first character is unique
+@return KEY_UNKNOWN if the key is not used
+**/
+static AssignReader::Key find_key(const char *key, string::size_type len) {
+	const char *name;
+	AssignReader::Key ret;
+	switch(len) {
+		case 4:
+			switch(*key) {
+				case 'E': name = "EAPI"; ret = AssignReader::KEY_EAPI; break;
+				case 'I': name = "IUSE"; ret = AssignReader::KEY_IUSE; break;
+				case 'S': name = "SLOT"; ret = AssignReader::KEY_SLOT; break;
+				default: return AssignReader::KEY_UNKNOWN;
+			}
+			break;
+		case 5:
+			name = "_md5_"; ret = AssignReader::KEY_MD5;
+			break;
+		case 6:
+			name = "DEPEND"; ret = AssignReader::KEY_DEPEND;
+			break;
+		case 7:
+			switch(*key) {
+				case '_': name = "_mtime_"; ret = AssignReader::KEY_MTIME; break;
+				case 'B': name = "BDEPEND"; ret = AssignReader::KEY_BDEPEND; break;
+				case 'I': name = "IDEPEND"; ret = AssignReader::KEY_IDEPEND; break;
+				case 'L': name = "LICENSE"; ret = AssignReader::KEY_LICENSE; break;
+				case 'P': name = "PDEPEND"; ret = AssignReader::KEY_PDEPEND; break;
+				case 'R': name = "RDEPEND"; ret = AssignReader::KEY_RDEPEND; break;
+				case 'S': name = "SRC_URI"; ret = AssignReader::KEY_SRC_URI; break;
+				default: return AssignReader::KEY_UNKNOWN;
+			}
+			break;
+		case 8:
+			switch(*key) {
+				case 'H': name = "HOMEPAGE"; ret = AssignReader::KEY_HOMEPAGE; break;
+				case 'K': name = "KEYWORDS"; ret = AssignReader::KEY_KEYWORDS; break;
+				case 'R': name = "RESTRICT"; ret = AssignReader::KEY_RESTRICT; break;
+				default: return AssignReader::KEY_UNKNOWN;
+			}
+			break;
+		case 10:
+			name = "PROPERTIES"; ret = AssignReader::KEY_PROPERTIES;
+			break;
+		case 11:
+			name = "DESCRIPTION"; ret = AssignReader::KEY_DESCRIPTION;
+			break;
+		case 12:
+			name = "REQUIRED_USE"; ret = AssignReader::KEY_REQUIRED_USE;
+			break;
+		default:
+			return AssignReader::KEY_UNKNOWN;
+	}
+	return ((std::memcmp(key, name, len) == 0) ? ret : AssignReader::KEY_UNKNOWN);
+}
 
-bool AssignReader::get_map(const string &file) {
+bool AssignReader::get_map(const DirHandle& dir, const string &file) {
 	if(currfile == NULLPTR) {
 		currfile = new string(file);
-		cf = new WordUnorderedMap;
 	} else {
-		if(*currfile == file) {
+		if((currdir == dir.generation()) && (*currfile == file)) {
 			return currstate;
 		}
 		currfile->assign(file);
-		cf->clear();
 	}
+	currdir = dir.generation();
+	std::fill(value_pos, value_pos + KEY_COUNT, string::npos);
 
-	ifstream is(file.c_str());
-	if(unlikely(!is.is_open())) {
+	if(unlikely(!dir.read_file(file, &buffer))) {
 		return (currstate = false);
 	}
 
-	while(likely(is.good())) {
-		string lbuf;
-		getline(is, lbuf);
-		string::size_type p(lbuf.find('='));
-		if(p == string::npos) {
-			continue;
+	string::size_type end(buffer.size());
+	for(string::size_type line(0); likely(line < end); ) {
+		string::size_type eol(buffer.find('\n', line));
+		if(eol == string::npos) {
+			eol = end;
+		} else {
+			buffer[eol] = '\0';
+		}
+		const char *start(buffer.c_str() + line);
+		const char *p(static_cast<const char *>(std::memchr(start, '=', eol - line)));
+		if(p != NULLPTR) {
+GCC_DIAG_OFF(sign-conversion)
+			string::size_type keylen(p - start);
+GCC_DIAG_ON(sign-conversion)
+			Key key(find_key(start, keylen));
+			if(key != KEY_UNKNOWN) {
+				value_pos[key] = line + keylen + 1;
+				value_len[key] = eol - value_pos[key];
+			}
 		}
-		(*cf)[lbuf.substr(0, p)].assign(lbuf, p + 1, string::npos);
+		line = eol + 1;
 	}
-	is.close();
 	return (currstate = true);
 }
 
-const char *AssignReader::get_md5sum(const string &filename) {
-	if(unlikely(!get_map(filename))) {
-		return NULLPTR;
+void AssignReader::get_value(string *s, Key key) const {
+	if(value_pos[key] == string::npos) {
+		s->clear();
+	} else {
+		s->assign(buffer, value_pos[key], value_len[key]);
 	}
-	WordUnorderedMap::const_iterator md5(cf->find("_md5_"));
-	if(md5 == cf->end()) {
+}
+
+const char *AssignReader::get_md5sum(const DirHandle& dir, const string &filename) {
+	if(unlikely(!get_map(dir, filename))) {
 		return NULLPTR;
 	}
-	return md5->second.c_str();
+	return get_value(KEY_MD5);
 }
 
-bool AssignReader::get_mtime(std::time_t *t, const string &filename) {
-	if(unlikely(!get_map(filename))) {
+bool AssignReader::get_mtime(std::time_t *t, const DirHandle& dir, const string &filename) {
+	if(unlikely(!get_map(dir, filename))) {
 		return false;
 	}
-	WordUnorderedMap::const_iterator mt(cf->find("_mtime_"));
-	if(mt == cf->end()) {
+	const char *mt(get_value(KEY_MTIME));
+	if(mt == NULLPTR) {
 		return false;
 	}
-	return likely(((*t) = my_atos(mt->second.c_str())) != 0);
+	return likely(((*t) = my_atos(mt)) != 0);
 }
 
 /**
 Read stability and other data from an "assign type" cache file
 **/
-void AssignReader::get_keywords_slot_iuse_restrict(const string& filename, string *eapi, string *keywords,
+void AssignReader::get_keywords_slot_iuse_restrict(const DirHandle& dir, const string& filename, string *eapi, string *keywords,
 	string *slotname, string *iuse, string *required_use, string *restr,
 	string *props, Depend *dep, string *src_uri) {
-	if(unlikely(!get_map(filename))) {
+	if(unlikely(!get_map(dir, filename))) {
 		m_cache->m_error_callback(eix::format(_("cannot read cache file %s: %s"))
-			% filename % std::strerror(errno));
+			% dir.fullname(filename) % std::strerror(errno));
 		return;
 	}
-	(*eapi)     = (*cf)["EAPI"];
-	(*keywords) = (*cf)["KEYWORDS"];
-	(*slotname) = (*cf)["SLOT"];
-	(*iuse)     = (*cf)["IUSE"];
-	(*restr)    = (*cf)["RESTRICT"];
-	(*props)    = (*cf)["PROPERTIES"];
+	get_value(eapi, KEY_EAPI);
+	get_value(keywords, KEY_KEYWORDS);
+	get_value(slotname, KEY_SLOT);
+	get_value(iuse, KEY_IUSE);
+	get_value(restr, KEY_RESTRICT);
+	get_value(props, KEY_PROPERTIES);
 	if(Version::use_required_use) {
-		(*required_use) = (*cf)["REQUIRED_USE"];
+		get_value(required_use, KEY_REQUIRED_USE);
 	}
 	if(Depend::use_depend) {
-		dep->set((*cf)["DEPEND"], (*cf)["RDEPEND"], (*cf)["PDEPEND"], (*cf)["BDEPEND"], (*cf)["IDEPEND"], false);
+		string depend, rdepend, pdepend, bdepend, idepend;
+		get_value(&depend, KEY_DEPEND);
+		get_value(&rdepend, KEY_RDEPEND);
+		get_value(&pdepend, KEY_PDEPEND);
+		get_value(&bdepend, KEY_BDEPEND);
+		get_value(&idepend, KEY_IDEPEND);
+		dep->set(depend, rdepend, pdepend, bdepend, idepend, false);
 	}
 	if(ExtendedVersion::use_src_uri) {
-		(*src_uri) = (*cf)["SRC_URI"];
+		get_value(src_uri, KEY_SRC_URI);
 	}
 }
 
 /**
 Read an "assign type" cache file
 **/
-void AssignReader::read_file(const string& filename, Package *pkg) {
-	if(unlikely(!get_map(filename))) {
+void AssignReader::read_file(const DirHandle& dir, const string& filename, Package *pkg) {
+	if(unlikely(!get_map(dir, filename))) {
 		m_cache->m_error_callback(eix::format(_("cannot read cache file %s: %s"))
-			% filename % std::strerror(errno));
+			% dir.fullname(filename) % std::strerror(errno));
 		return;
 	}
-	pkg->homepage = (*cf)["HOMEPAGE"];
-	pkg->licenses = (*cf)["LICENSE"];
-	pkg->desc     = (*cf)["DESCRIPTION"];
+	get_value(&(pkg->homepage), KEY_HOMEPAGE);
+	get_value(&(pkg->licenses), KEY_LICENSE);
+	get_value(&(pkg->desc), KEY_DESCRIPTION);
 }
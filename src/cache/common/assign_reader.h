@@ -19,37 +19,67 @@
 #include "cache/common/reader.h"
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
 
 class BasicCache;
 class Depend;
+class DirHandle;
 class Package;
 
 class AssignReader : public BasicReader {
 	public:
 		explicit AssignReader(BasicCache *cache) :
-			BasicReader(cache), currfile(NULLPTR) {
+			BasicReader(cache), currfile(NULLPTR), currdir(0) {
 		}
 
 		~AssignReader() {
-			if(likely(currfile != NULLPTR)) {
-				delete currfile;
-				delete cf;
-			}
+			delete currfile;
 		}
 
-		ATTRIBUTE_NONNULL_ const char *get_md5sum(const std::string &filename) OVERRIDE;
-		ATTRIBUTE_NONNULL_ bool get_mtime(std::time_t *t, const std::string &filename) OVERRIDE;
-		ATTRIBUTE_NONNULL_ void get_keywords_slot_iuse_restrict(const std::string& filename, std::string *eapi, std::string *keywords, std::string *slotname, std::string *iuse, std::string *required_use, std::string *restr, std::string *props, Depend *dep, std::string *src_uri) OVERRIDE;
-		ATTRIBUTE_NONNULL_ void read_file(const std::string& filename, Package *pkg) OVERRIDE;
+		ATTRIBUTE_NONNULL_ const char *get_md5sum(const DirHandle& dir, const std::string &filename) OVERRIDE;
+		ATTRIBUTE_NONNULL_ bool get_mtime(std::time_t *t, const DirHandle& dir, const std::string &filename) OVERRIDE;
+		ATTRIBUTE_NONNULL_ void get_keywords_slot_iuse_restrict(const DirHandle& dir, const std::string& filename, std::string *eapi, std::string *keywords, std::string *slotname, std::string *iuse, std::string *required_use, std::string *restr, std::string *props, Depend *dep, std::string *src_uri) OVERRIDE;
+		ATTRIBUTE_NONNULL_ void read_file(const DirHandle& dir, const std::string& filename, Package *pkg) OVERRIDE;
+
+		/**
+		The keys of the cache file which we actually use
+		**/
+		enum Key {
+			KEY_MD5, KEY_MTIME, KEY_EAPI, KEY_KEYWORDS, KEY_SLOT, KEY_IUSE,
+			KEY_REQUIRED_USE, KEY_RESTRICT, KEY_PROPERTIES,
+			KEY_DEPEND, KEY_RDEPEND, KEY_PDEPEND, KEY_BDEPEND, KEY_IDEPEND,
+			KEY_SRC_URI, KEY_HOMEPAGE, KEY_LICENSE, KEY_DESCRIPTION,
+			KEY_COUNT,
+			KEY_UNKNOWN = KEY_COUNT
+		};
 
 	private:
-		ATTRIBUTE_NONNULL_ bool get_map(const std::string &file);
+		ATTRIBUTE_NONNULL_ bool get_map(const DirHandle& dir, const std::string &file);
+
+		/**
+		@return value of key in the current file or NULLPTR
+		**/
+		const char *get_value(Key key) const {
+			return ((value_pos[key] == std::string::npos) ?
+				NULLPTR : (buffer.c_str() + value_pos[key]));
+		}
+
+		/**
+		Set s to the value of key in the current file (or to empty)
+		**/
+		ATTRIBUTE_NONNULL_ void get_value(std::string *s, Key key) const;
 
 		std::string *currfile;
-		WordUnorderedMap *cf;
+		eix::UNumber currdir;
+		/**
+		The content of the current file. The '\n' after each value is
+		replaced by '\0' so that values can be used in place.
+		**/
+		std::string buffer;
+		std::string::size_type value_pos[KEY_COUNT], value_len[KEY_COUNT];
 		bool currstate;
 };
 
@@ -0,0 +1,205 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "cache/common/dir_handle.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include <algorithm>
+#include <string>
+
+#include "eixTk/diagnostics.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/phasestats.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/stringutils.h"
+#include "eixTk/sysutils.h"
+#include "eixTk/utils.h"
+
+#if defined(HAVE_OPENAT) && defined(HAVE_FSTATAT) && defined(HAVE_FDOPENDIR)
+#define USE_OPENAT 1
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+
+using std::string;
+
+static eix::UNumber dir_handle_generation = 0;
+
+bool DirHandle::open(const string& path) {
+	close();
+#ifdef USE_OPENAT
+	if(unlikely((m_fd = ::open(path.c_str(), O_RDONLY|O_DIRECTORY|O_CLOEXEC)) < 0)) {
+		return false;
+	}
+#else
+	if(unlikely(!is_dir(path.c_str()))) {
+		return false;
+	}
+#endif
+	m_path = path;
+	m_generation = ++dir_handle_generation;
+	return true;
+}
+
+bool DirHandle::open(const DirHandle& parent, const string& name) {
+#ifdef USE_OPENAT
+	if(likely(parent.m_fd >= 0)) {
+		close();
+		if(unlikely((m_fd = openat(parent.m_fd, name.c_str(), O_RDONLY|O_DIRECTORY|O_CLOEXEC)) < 0)) {
+			return false;
+		}
+		m_path = parent.fullname(name);
+		m_generation = ++dir_handle_generation;
+		return true;
+	}
+#endif
+	return open(parent.fullname(name));
+}
+
+void DirHandle::close() {
+	if(m_fd >= 0) {
+		::close(m_fd);
+		m_fd = -1;
+	}
+	m_path.clear();
+}
+
+string DirHandle::fullname(const string& name) const {
+	if(m_path.empty()) {
+		return name;
+	}
+	string ret(m_path);
+	optional_append(&ret, '/');
+	ret.append(name);
+	return ret;
+}
+
+bool DirHandle::scan(WordVec *namelist, select_dirent select) const {
+#ifdef USE_OPENAT
+	if(likely(m_fd >= 0)) {
+		// fdopendir() takes ownership of the descriptor
+		int fd(dup(m_fd));
+		if(unlikely(fd < 0)) {
+			return false;
+		}
+		DIR *dh(fdopendir(fd));
+		if(unlikely(dh == NULLPTR)) {
+			::close(fd);
+			return false;
+		}
+		// The duplicate shares the offset with m_fd
+		rewinddir(dh);
+		namelist->clear();
+		struct dirent *d;
+		while(likely((d = readdir(dh)) != NULLPTR)) {  // NOLINT(runtime/threadsafe_fn)
+			const char *name(d->d_name);
+			// Omit "." and ".." since we must not rely on their existence anyway
+			if(likely(std::strcmp(name, ".") && std::strcmp(name, "..") && (*select)(d))) {
+				namelist->PUSH_BACK(MOVE(name));
+			}
+		}
+		closedir(dh);
+		std::sort(namelist->begin(), namelist->end());
+		return true;
+	}
+#endif
+	return scandir_cc(m_path, namelist, select);
+}
+
+int DirHandle::open_file(const string& name) const {
+#ifdef USE_OPENAT
+	if(likely(m_fd >= 0)) {
+		return openat(m_fd, name.c_str(), O_RDONLY|O_CLOEXEC);
+	}
+#endif
+	return ::open(fullname(name).c_str(), O_RDONLY|O_CLOEXEC);
+}
+
+bool DirHandle::read_file(const string& name, string *contents) const {
+	contents->clear();
+	int fd(open_file(name));
+	if(unlikely(fd < 0)) {
+		return false;
+	}
+	struct stat st;
+	if(likely(fstat(fd, &st) == 0) && likely(st.st_size > 0)) {
+GCC_DIAG_OFF(sign-conversion)
+		contents->reserve(st.st_size);
+GCC_DIAG_ON(sign-conversion)
+	}
+	char buf[8192];
+	for(;;) {
+		ssize_t len(read(fd, buf, sizeof(buf)));
+		if(len > 0) {
+GCC_DIAG_OFF(sign-conversion)
+			contents->append(buf, len);
+GCC_DIAG_ON(sign-conversion)
+			continue;
+		}
+		if(likely(len == 0)) {
+			break;
+		}
+		if(errno == EINTR) {
+			continue;
+		}
+		int saved_errno(errno);
+		::close(fd);
+		errno = saved_errno;
+		return false;
+	}
+	::close(fd);
+	PhaseStats::count_file(static_cast<eix::OffsetType>(contents->size()));
+	return true;
+}
+
+bool DirHandle::get_mtime(std::time_t *t, const string& name) const {
+#ifdef USE_OPENAT
+	if(likely(m_fd >= 0)) {
+		struct stat st;
+		if(unlikely(fstatat(m_fd, name.c_str(), &st, 0) != 0)) {
+			return false;
+		}
+		*t = st.st_mtime;
+		return true;
+	}
+#endif
+	return ::get_mtime(t, fullname(name).c_str());
+}
+
+#ifdef HAVE_POSIX_FADVISE
+void DirHandle::prefetch(const WordVec& names) const {
+	for(WordVec::const_iterator it(names.begin());
+		likely(it != names.end()); ++it) {
+		int fd(open_file(*it));
+		if(likely(fd >= 0)) {
+			posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+			::close(fd);
+		}
+	}
+}
+#else
+void DirHandle::prefetch(const WordVec& /* names */) const {
+}
+#endif
@@ -0,0 +1,100 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_CACHE_COMMON_DIR_HANDLE_H_
+#define SRC_CACHE_COMMON_DIR_HANDLE_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <ctime>
+
+#include <string>
+
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/utils.h"
+
+/**
+A directory which is kept open so that the files in it are accessed
+relative to it (openat() and friends) instead of resolving the full path
+for every single file.
+If the handle is not opened, names are used unchanged (i.e. they must be
+full paths then). If openat() is not available, full paths are used
+internally as a fallback.
+**/
+class DirHandle {
+	private:
+		int m_fd;
+		std::string m_path;
+		eix::UNumber m_generation;
+
+		DirHandle(const DirHandle& s) ASSIGN_DELETE;
+		DirHandle& operator=(const DirHandle& s) ASSIGN_DELETE;
+
+	public:
+		DirHandle() : m_fd(-1), m_generation(0) {
+		}
+
+		~DirHandle() {
+			close();
+		}
+
+		/**
+		@return false if path is not an accessible directory
+		**/
+		bool open(const std::string& path);
+
+		/**
+		Open the subdirectory name of parent
+		**/
+		bool open(const DirHandle& parent, const std::string& name);
+
+		void close();
+
+		/**
+		@return a number which differs after each successful open()
+		**/
+		eix::UNumber generation() const {
+			return m_generation;
+		}
+
+		const std::string& path() const {
+			return m_path;
+		}
+
+		/**
+		@return full path of name (for error messages or external tools)
+		**/
+		std::string fullname(const std::string& name) const;
+
+		/**
+		Like scandir_cc() for this directory
+		**/
+		ATTRIBUTE_NONNULL_ bool scan(WordVec *namelist, select_dirent select) const;
+
+		/**
+		@return file descriptor of name (opened read-only) or -1
+		**/
+		int open_file(const std::string& name) const;
+
+		/**
+		Replace contents by the content of the file name
+		@return false if the file cannot be read
+		**/
+		ATTRIBUTE_NONNULL_ bool read_file(const std::string& name, std::string *contents) const;
+
+		ATTRIBUTE_NONNULL_ bool get_mtime(std::time_t *t, const std::string& name) const;
+
+		/**
+		Ask the kernel to read the given files ahead in the background
+		**/
+		void prefetch(const WordVec& names) const;
+};
+
+#endif  // SRC_CACHE_COMMON_DIR_HANDLE_H_
@@ -30,6 +30,7 @@
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/phasestats.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "eixTk/sysutils.h"
@@ -312,6 +313,7 @@ string *EbuildExec::make_cachefile(const char *name, const string& dir, const Pa
 		_exit(EXECLE_FAILED);
 	}
 	while(waitpid(child, &exec_status, 0) != child ) { }
+	PhaseStats::count_ebuild();
 
 	// Free memory needed only for the child process:
 	delete[] c_env;
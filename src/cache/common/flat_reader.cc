@@ -13,11 +13,10 @@
 #include <cerrno>
 #include <cstring>
 
-#include <fstream>
-#include <limits>
 #include <string>
 
 #include "cache/base.h"
+#include "cache/common/dir_handle.h"
 #include "eixTk/eixint.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
@@ -28,16 +27,38 @@
 
 using std::string;
 
-using std::ifstream;
+bool FlatReader::open(const DirHandle& dir, const string& filename) {
+	pos = 0;
+	if(likely(dir.read_file(filename, &buffer))) {
+		return true;
+	}
+	m_cache->m_error_callback(eix::format(_("cannot open %s: %s"))
+		% dir.fullname(filename) % std::strerror(errno));
+	return false;
+}
 
-bool FlatReader::skip_lines(const eix::TinyUnsigned nr, ifstream *is, const string& filename) const {
+void FlatReader::getline(string *line) {
+	if(unlikely(pos >= buffer.size())) {
+		line->clear();
+		return;
+	}
+	string::size_type eol(buffer.find('\n', pos));
+	if(unlikely(eol == string::npos)) {
+		eol = buffer.size();
+	}
+	line->assign(buffer, pos, eol - pos);
+	pos = eol + 1;
+}
+
+bool FlatReader::skip_lines(const eix::TinyUnsigned nr, const DirHandle& dir, const string& filename) {
 	for(eix::TinyUnsigned i(nr); likely(i != 0); --i) {
-		is->ignore(std::numeric_limits<int>::max(), '\n');
-		if(is->fail()) {
+		if(unlikely(pos >= buffer.size())) {
 			m_cache->m_error_callback(eix::format(_("cannot read cache file %s: %s"))
-				% filename % std::strerror(errno));
+				% dir.fullname(filename) % _("unexpected end of file"));
 			return false;
 		}
+		string::size_type eol(buffer.find('\n', pos));
+		pos = ((eol == string::npos) ? buffer.size() : (eol + 1));
 	}
 	return true;
 }
@@ -45,81 +66,63 @@ bool FlatReader::skip_lines(const eix::TinyUnsigned nr, ifstream *is, const stri
 /**
 Read the keywords and slot from a flat cache file
 **/
-void FlatReader::get_keywords_slot_iuse_restrict(const string& filename, string *eapi, string *keywords, string *slotname, string *iuse, string *required_use, string *restr, string *props, Depend *dep, string *src_uri) {
-	ifstream is(filename.c_str());
-	if(!is.is_open()) {
-		m_cache->m_error_callback(eix::format(_("cannot open %s: %s"))
-			% filename % std::strerror(errno));
+void FlatReader::get_keywords_slot_iuse_restrict(const DirHandle& dir, const string& filename, string *eapi, string *keywords, string *slotname, string *iuse, string *required_use, string *restr, string *props, Depend *dep, string *src_uri) {
+	if(unlikely(!open(dir, filename))) {
+		return;
 	}
 	string depend, rdepend, idepend;
 	bool use_dep(Depend::use_depend);
 	if(use_dep) {
-		getline(is, depend);
-		getline(is, rdepend);
+		getline(&depend);
+		getline(&rdepend);
 	} else {
-		skip_lines(2, &is, filename);
+		skip_lines(2, dir, filename);
 	}
-	getline(is, *slotname);
+	getline(slotname);
 	if(ExtendedVersion::use_src_uri) {
-		getline(is, *src_uri);
+		getline(src_uri);
 	} else {
-		skip_lines(1, &is, filename);
+		skip_lines(1, dir, filename);
 	}
-	getline(is, *restr);
-	skip_lines(3, &is, filename);
-	getline(is, *keywords);
+	getline(restr);
+	skip_lines(3, dir, filename);
+	getline(keywords);
 	if(use_dep) {
-		getline(is, idepend);
+		getline(&idepend);
 	} else {
-		skip_lines(1, &is, filename);
+		skip_lines(1, dir, filename);
 	}
-	getline(is, *iuse);
+	getline(iuse);
 	bool use_required_use(Version::use_required_use);
 	if(use_required_use) {
-		getline(is, *required_use);
+		getline(required_use);
 	}
 	if(use_dep) {
 		if(!use_required_use) {
-			skip_lines(1, &is, filename);
+			skip_lines(1, dir, filename);
 		}
 		string pdepend, bdepend;
-		getline(is, pdepend);
-		getline(is, bdepend);
+		getline(&pdepend);
+		getline(&bdepend);
 		dep->set(depend, rdepend, pdepend, bdepend, idepend, false);
 	} else {
-		skip_lines((use_required_use ? 2 : 3), &is, filename);
+		skip_lines((use_required_use ? 2 : 3), dir, filename);
 	}
-	getline(is, *eapi);
-	getline(is, *props);
-	is.close();
+	getline(eapi);
+	getline(props);
 }
 
 /**
 Read a flat cache file
 **/
-void FlatReader::read_file(const string& filename, Package *pkg) {
-	ifstream is(filename.c_str());
-	if(!is.is_open()) {
-		m_cache->m_error_callback(eix::format(_("cannot open %s: %s"))
-			% filename % std::strerror(errno));
+void FlatReader::read_file(const DirHandle& dir, const string& filename, Package *pkg) {
+	if(unlikely(!open(dir, filename))) {
+		return;
 	}
-	skip_lines(5, &is, filename);
-	string linebuf;
-	// Read the rest
-	for(eix::TinyUnsigned linenr(5); is.good(); ++linenr) {
-		getline(is, linebuf);
-		switch(linenr) {
-			case 5:  pkg->homepage = linebuf;
-			         break;
-			case 6:  pkg->licenses = linebuf;
-			         break;
-			case 7:  pkg->desc     = linebuf;
-			         is.close();
-			         return;
-			default:
-				break;
-		}
+	if(unlikely(!skip_lines(5, dir, filename))) {
+		return;
 	}
-	// We should never get here. However, we do not spit errors if we do...
-	is.close();
+	getline(&(pkg->homepage));
+	getline(&(pkg->licenses));
+	getline(&(pkg->desc));
 }
@@ -12,7 +12,6 @@
 
 #include <config.h>  // IWYU pragma: keep
 
-#include <fstream>
 #include <string>
 
 #include "cache/common/reader.h"
@@ -22,18 +21,24 @@
 
 class BasicCache;
 class Depend;
+class DirHandle;
 class Package;
 
 class FlatReader : public BasicReader {
 	public:
-		explicit FlatReader(BasicCache *cache) : BasicReader(cache) {
+		explicit FlatReader(BasicCache *cache) : BasicReader(cache), pos(0) {
 		}
 
-		ATTRIBUTE_NONNULL_ void get_keywords_slot_iuse_restrict(const std::string& filename, std::string *eapi, std::string *keywords, std::string *slotname, std::string *iuse, std::string *required_use, std::string *restr, std::string *props, Depend *dep, std::string *src_uri) OVERRIDE;
-		ATTRIBUTE_NONNULL_ void read_file(const std::string& filename, Package *pkg) OVERRIDE;
+		ATTRIBUTE_NONNULL_ void get_keywords_slot_iuse_restrict(const DirHandle& dir, const std::string& filename, std::string *eapi, std::string *keywords, std::string *slotname, std::string *iuse, std::string *required_use, std::string *restr, std::string *props, Depend *dep, std::string *src_uri) OVERRIDE;
+		ATTRIBUTE_NONNULL_ void read_file(const DirHandle& dir, const std::string& filename, Package *pkg) OVERRIDE;
 
 	private:
-		ATTRIBUTE_NONNULL_ bool skip_lines(const eix::TinyUnsigned nr, std::ifstream *is, const std::string& filename) const;
+		std::string buffer;
+		std::string::size_type pos;
+
+		ATTRIBUTE_NONNULL_ bool open(const DirHandle& dir, const std::string& filename);
+		ATTRIBUTE_NONNULL_ void getline(std::string *line);
+		bool skip_lines(const eix::TinyUnsigned nr, const DirHandle& dir, const std::string& filename);
 };
 
 #endif  // SRC_CACHE_COMMON_FLAT_READER_H_
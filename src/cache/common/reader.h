@@ -20,6 +20,7 @@
 
 class BasicCache;
 class Depend;
+class DirHandle;
 class Package;
 
 /**
@@ -36,17 +37,20 @@ class BasicReader {
 		virtual ~BasicReader() {
 		}
 
-		ATTRIBUTE_NONNULL_ virtual const char *get_md5sum(const std::string& /* filename */) {
+		/**
+		All functions read the file filename relative to the directory dir
+		**/
+		ATTRIBUTE_NONNULL_ virtual const char *get_md5sum(const DirHandle& /* dir */, const std::string& /* filename */) {
 			return NULLPTR;
 		}
 
-		ATTRIBUTE_NONNULL_ virtual bool get_mtime(std::time_t * /* time */, const std::string& /* filename */) {
+		ATTRIBUTE_NONNULL_ virtual bool get_mtime(std::time_t * /* time */, const DirHandle& /* dir */, const std::string& /* filename */) {
 			return false;
 		}
 
-		ATTRIBUTE_NONNULL_ virtual void get_keywords_slot_iuse_restrict(const std::string& filename, std::string *eapi, std::string *keywords, std::string *slotname, std::string *iuse, std::string *required_use, std::string *restr, std::string *props, Depend *dep, std::string *src_uri) = 0;
+		ATTRIBUTE_NONNULL_ virtual void get_keywords_slot_iuse_restrict(const DirHandle& dir, const std::string& filename, std::string *eapi, std::string *keywords, std::string *slotname, std::string *iuse, std::string *required_use, std::string *restr, std::string *props, Depend *dep, std::string *src_uri) = 0;
 
-		ATTRIBUTE_NONNULL_ virtual void read_file(const std::string& filename, Package *pkg) = 0;
+		ATTRIBUTE_NONNULL_ virtual void read_file(const DirHandle& dir, const std::string& filename, Package *pkg) = 0;
 
 	public:
 		BasicCache *m_cache;
@@ -145,20 +145,26 @@ bool EixCache::get_overlaydat(const DBHeader& header) {
 	return true;
 }
 
-bool EixCache::get_destcat(PackageTree *packagetree, const char *cat_name, Category *category, const string& pcat) {
+bool EixCache::get_destcat(PackageTree *packagetree, const char *cat_name, Category *category, const PackageReader& reader) {
 	if(likely(err_msg.empty())) {
+		const string& pcat(reader.category());
 		if(unlikely(packagetree == NULLPTR)) {
 			if(unlikely(pcat == cat_name)) {
 				dest_cat = category;
-				return true;
+			} else {
+				dest_cat = NULLPTR;
 			}
 		} else if(never_add_categories) {
 			dest_cat = packagetree->find(pcat);
-			return (dest_cat != NULLPTR);
 		} else {
 			dest_cat = &((*packagetree)[pcat]);
-			return true;
 		}
+		// Use the category index to skip categories without our overlay
+		if((dest_cat != NULLPTR) && m_only_overlay &&
+			(!reader.category_has_overlay(m_get_overlay))) {
+			dest_cat = NULLPTR;
+		}
+		return (dest_cat != NULLPTR);
 	}
 	dest_cat = NULLPTR;
 	return false;
@@ -178,7 +184,7 @@ void EixCache::get_package(Package *p) {
 		Version *version(new Version);
 		*static_cast<BasicVersion *>(version) = *static_cast<BasicVersion *>(*it);
 		version->overlay_key = m_overlay_key;
-		version->set_full_keywords(it->get_full_keywords());
+		version->set_full_keywords(it->get_shared_keywords());
 		version->slotname = it->slotname;
 		version->subslotname = it->subslotname;
 		version->restrictFlags = it->restrictFlags;
@@ -264,25 +270,27 @@ bool EixCache::readCategories(PackageTree *packagetree, const char *cat_name, Ca
 
 	PackageReader reader(&db, header);
 	for(; reader.next(); reader.skip()) {
-		if(unlikely(!reader.read(PackageReader::NAME))) {
-			break;
-		}
-		Package *p(reader.get());
-
-		success = false;
-		for(CachesList::const_iterator sl(slaves.begin());
-			unlikely(sl != slaves.end()); ++sl) {
-			if(sl->get_destcat(packagetree, cat_name, category, p->category)) {
-				success = true;
+		// The destination depends only on the category, so decide it
+		// once per category and skip unwanted categories as a whole
+		if(reader.new_category()) {
+			success = false;
+			for(CachesList::const_iterator sl(slaves.begin());
+				unlikely(sl != slaves.end()); ++sl) {
+				if(sl->get_destcat(packagetree, cat_name, category, reader)) {
+					success = true;
+				}
 			}
 		}
 		if(!success) {
+			if(unlikely(!reader.skip_category())) {
+				break;
+			}
 			continue;
 		}
 		if(unlikely(!reader.read())) {
 			break;
 		}
-		p = reader.get();
+		Package *p(reader.get());
 		for(CachesList::const_iterator sl(slaves.begin());
 			unlikely(sl != slaves.end()); ++sl) {
 			sl->get_package(p);
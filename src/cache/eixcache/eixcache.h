@@ -22,6 +22,7 @@
 class Category;
 class DBHeader;
 class Package;
+class PackageReader;
 class PackageTree;
 
 class EixCache FINAL : public BasicCache {
@@ -41,7 +42,7 @@ class EixCache FINAL : public BasicCache {
 		void allerrors(const CachesList& slaves, const std::string& msg);
 		void thiserror(const std::string& msg);
 		bool get_overlaydat(const DBHeader& header);
-		bool get_destcat(PackageTree *packagetree, const char *cat_name, Category *category, const std::string& pcat);
+		bool get_destcat(PackageTree *packagetree, const char *cat_name, Category *category, const PackageReader& reader);
 		ATTRIBUTE_NONNULL_ void get_package(Package *p);
 
 	public:
@@ -18,6 +18,7 @@
 #include <string>
 
 #include "cache/common/assign_reader.h"
+#include "cache/common/dir_handle.h"
 #include "cache/common/flat_reader.h"
 #include "cache/common/reader.h"
 #include "eixTk/formated.h"
@@ -163,28 +164,28 @@ static int cachefiles_selector(SCANDIR_ARG3 dent) {
 			&& (std::strchr(dent->d_name, '-') != NULLPTR));
 }
 
-bool MetadataCache::readCategoryPrepare(const char *cat_name) {
-	string alt;
-	m_catname = cat_name;
+void MetadataCache::get_catpath(string *catpath, string *alt, const char *cat_name) const {
 	if(have_override_path) {
-		m_catpath = override_path;
+		*catpath = override_path;
 	} else {
-		m_catpath = m_prefix;
+		*catpath = m_prefix;
 		switch(path_type) {
 			case PATH_METADATA:
 			case PATH_METADATAMD5:
 			case PATH_METADATAMD5OR:
 				// m_scheme is actually the portdir
-				m_catpath.append(m_scheme);
-				optional_append(&m_catpath, '/');
+				catpath->append(m_scheme);
+				optional_append(catpath, '/');
 				if(path_type == PATH_METADATA) {
-					m_catpath.append(METADATA_PATH);
+					catpath->append(METADATA_PATH);
 				} else if(path_type == PATH_METADATAMD5) {
-					m_catpath.append(METADATAMD5_PATH);
+					catpath->append(METADATAMD5_PATH);
 				} else {
-					alt = m_catpath;
-					m_catpath.append(METADATAMD5_PATH);
-					alt.append(METADATA_PATH);
+					*alt = *catpath;
+					catpath->append(METADATAMD5_PATH);
+					alt->append(METADATA_PATH);
+					optional_append(alt, '/');
+					alt->append(cat_name);
 				}
 				break;
 /*
@@ -192,35 +193,35 @@ bool MetadataCache::readCategoryPrepare(const char *cat_name) {
 			case PATH_FULL:
 */
 			default:
-				m_catpath = m_prefix;
-				optional_append(&m_catpath, '/');
-				m_catpath.append(PORTAGE_CACHE_PATH);
+				*catpath = m_prefix;
+				optional_append(catpath, '/');
+				catpath->append(PORTAGE_CACHE_PATH);
 				break;
 		}
 	}
 	switch(path_type) {
 		case PATH_FULL:
-			m_catpath.append(m_scheme);
+			catpath->append(m_scheme);
 			break;
 		case PATH_REPOSITORY:
-			optional_append(&m_catpath, '/');
+			optional_append(catpath, '/');
 			if(m_overlay_name.empty()) {
 				// Paludis' way of resolving missing repo_name:
-				m_catpath.append("x-");
+				catpath->append("x-");
 				string::size_type p(m_scheme.size());
 				while(p) {
 					string::size_type c(m_scheme.rfind('/', p));
 					if(c == string::npos) {
-						m_catpath.append(m_scheme, 0, p);
+						catpath->append(m_scheme, 0, p);
 						break;
 					}
 					if(c == --p)
 						continue;
-					m_catpath.append(m_scheme, c + 1, p - c);
+					catpath->append(m_scheme, c + 1, p - c);
 					break;
 				}
 			} else {
-				m_catpath.append(m_overlay_name);
+				catpath->append(m_overlay_name);
 			}
 			break;
 /*
@@ -231,10 +232,32 @@ bool MetadataCache::readCategoryPrepare(const char *cat_name) {
 		default:
 			break;
 	}
-	optional_append(&m_catpath, '/');
-	m_catpath.append(cat_name);
+	optional_append(catpath, '/');
+	catpath->append(cat_name);
+}
 
-	bool r(scandir_cc(m_catpath, &names, cachefiles_selector));
+void MetadataCache::prefetchCategory(const char *cat_name) {
+	string catpath, alt;
+	get_catpath(&catpath, &alt, cat_name);
+	DirHandle catdir;
+	if(!catdir.open(catpath)) {
+		if((path_type != PATH_METADATAMD5OR) || (!catdir.open(alt))) {
+			return;
+		}
+	}
+	WordVec files;
+	if(catdir.scan(&files, cachefiles_selector)) {
+		catdir.prefetch(files);
+	}
+}
+
+bool MetadataCache::readCategoryPrepare(const char *cat_name) {
+	string catpath, alt;
+	m_catname = cat_name;
+	names.clear();
+	get_catpath(&catpath, &alt, cat_name);
+
+	bool r(m_catdir.open(catpath) && m_catdir.scan(&names, cachefiles_selector));
 	if(path_type != PATH_METADATAMD5OR) {
 		return r;
 	}
@@ -246,36 +269,32 @@ bool MetadataCache::readCategoryPrepare(const char *cat_name) {
 		return true;
 	}
 	// We choose metadata-flat or metadata-assign:
-	m_catpath = alt;
-	optional_append(&m_catpath, '/');
-	m_catpath.append(cat_name);
 	if(flat) {  // We "jump" to flat PATH_METADATA mode:
 		setFlat(true);
 	}
-	return scandir_cc(m_catpath, &names, cachefiles_selector);
+	return (m_catdir.open(alt) && m_catdir.scan(&names, cachefiles_selector));
 }
 
 void MetadataCache::readCategoryFinalize() {
 	m_catname.clear();
-	m_catpath.clear();
+	m_catdir.close();
 	names.clear();
 }
+
 const char *MetadataCache::get_md5sum(const string &pkg_name, const string &ver_name) const {
-	return (reader->get_md5sum)(m_catpath + "/" + pkg_name + "-" + ver_name);
+	return (reader->get_md5sum)(m_catdir, pkg_name + "-" + ver_name);
 }
 
 bool MetadataCache::get_time(std::time_t *t, const string &pkg_name, const string &ver_name) const {
-	return (reader->get_mtime)(t, m_catpath + "/" + pkg_name + "-" + ver_name);
+	return (reader->get_mtime)(t, m_catdir, pkg_name + "-" + ver_name);
 }
 
 void MetadataCache::get_version_info(const string &pkg_name, const string &ver_name, Version *version) const {
 	string eapi, keywords, iuse, required_use, restr, props, slot;
-	string path(m_catpath);
-	path.append(1, '/');
-	path.append(pkg_name);
-	path.append(1, '-');
-	path.append(ver_name);
-	(reader->get_keywords_slot_iuse_restrict)(path, &eapi, &keywords, &slot, &iuse, &required_use, &restr, &props, &(version->depend), &(version->src_uri));
+	string name(pkg_name);
+	name.append(1, '-');
+	name.append(ver_name);
+	(reader->get_keywords_slot_iuse_restrict)(m_catdir, name, &eapi, &keywords, &slot, &iuse, &required_use, &restr, &props, &(version->depend), &(version->src_uri));
 	version->eapi.assign(eapi);
 	version->set_slotname(slot);
 	version->set_full_keywords(keywords);
@@ -287,7 +306,7 @@ void MetadataCache::get_version_info(const string &pkg_name, const string &ver_n
 }
 
 void MetadataCache::get_common_info(const string &pkg_name, const string &ver_name, Package *pkg) const {
-	(reader->read_file)(m_catpath + "/" + pkg_name + "-" + ver_name, pkg);
+	(reader->read_file)(m_catdir, pkg_name + "-" + ver_name, pkg);
 }
 
 bool MetadataCache::readCategory(Category *cat) {
@@ -17,6 +17,7 @@
 #include <string>
 
 #include "cache/base.h"
+#include "cache/common/dir_handle.h"
 #include "cache/common/reader.h"
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
@@ -42,7 +43,7 @@ class MetadataCache FINAL : public BasicCache {
 		bool flat, have_override_path;
 		std::string override_path;
 		std::string m_type;
-		std::string m_catpath;
+		DirHandle m_catdir;
 		WordVec names;
 
 		BasicReader *reader;
@@ -50,6 +51,12 @@ class MetadataCache FINAL : public BasicCache {
 		void setType(PathType set_path_type, bool set_flat);
 		void setFlat(bool set_flat);
 
+		/**
+		Calculate the directory of the category.
+		alt is only calculated for PATH_METADATAMD5OR
+		**/
+		ATTRIBUTE_NONNULL_ void get_catpath(std::string *catpath, std::string *alt, const char *cat_name) const;
+
 	public:
 		MetadataCache() : reader(NULLPTR) {
 		}
@@ -60,6 +67,7 @@ class MetadataCache FINAL : public BasicCache {
 
 		bool initialize(const std::string& name);
 
+		ATTRIBUTE_NONNULL_ void prefetchCategory(const char *cat_name) OVERRIDE;
 		ATTRIBUTE_NONNULL_ bool readCategoryPrepare(const char *cat_name) OVERRIDE;
 		ATTRIBUTE_NONNULL_ bool readCategory(Category *cat) OVERRIDE;
 		void readCategoryFinalize() OVERRIDE;
@@ -15,6 +15,7 @@
 #include <string>
 
 #include "cache/base.h"
+#include "cache/common/dir_handle.h"
 #include "cache/common/ebuild_exec.h"
 #include "cache/common/flat_reader.h"
 #include "cache/common/selectors.h"
@@ -263,8 +264,9 @@ void ParseCache::parse_exec(const char *fullpath, const string& dirpath, bool re
 		string *cachefile(ebuild_exec->make_cachefile(fullpath, dirpath, *pkg, *version, eapi));
 		if(likely(cachefile != NULLPTR)) {
 			FlatReader reader(this);
-			reader.get_keywords_slot_iuse_restrict(*cachefile, &eapi, &keywords, &slot, &iuse, &required_use, &restr, &props, &(version->depend), &(version->src_uri));
-			reader.read_file(*cachefile, pkg);
+			DirHandle no_dir;  // cachefile is a full path
+			reader.get_keywords_slot_iuse_restrict(no_dir, *cachefile, &eapi, &keywords, &slot, &iuse, &required_use, &restr, &props, &(version->depend), &(version->src_uri));
+			reader.read_file(no_dir, *cachefile, pkg);
 			ebuild_exec->delete_cachefile();
 		} else {
 			m_error_callback(eix::format(_("cannot properly execute %s")) % fullpath);
@@ -280,7 +282,7 @@ void ParseCache::parse_exec(const char *fullpath, const string& dirpath, bool re
 	pkg->addVersionFinalize(version);
 }
 
-void ParseCache::readPackage(Category *cat, const string& pkg_name, const string& directory_path, const WordVec& files) {
+void ParseCache::readPackage(Category *cat, const string& pkg_name, const DirHandle& pkg_dir, const WordVec& files) {
 	bool have_onetime_info, have_pkg;
 
 	Package *pkg(cat->findPackage(pkg_name));
@@ -302,7 +304,7 @@ void ParseCache::readPackage(Category *cat, const string& pkg_name, const string
 		string curr_version;
 		if(unlikely(!ExplodeAtom::split_version(&curr_version, fileit->substr(0, pos).c_str()))) {
 			m_error_callback(eix::format(_("cannot split filename of ebuild %s/%s")) %
-				directory_path % (*fileit));
+				pkg_dir.path() % (*fileit));
 			continue;
 		}
 
@@ -320,7 +322,7 @@ void ParseCache::readPackage(Category *cat, const string& pkg_name, const string
 		version->overlay_key = m_overlay_key;
 		pkg->addVersionStart(version);
 
-		string full_path(directory_path + '/' + (*fileit));
+		string full_path(pkg_dir.fullname(*fileit));
 
 		/* For the latest version read/change corresponding data */
 		bool read_onetime_info(true);
@@ -345,7 +347,7 @@ void ParseCache::readPackage(Category *cat, const string& pkg_name, const string
 			if((*it)->get_time(&t, pkg_name, curr_version)) {
 				if(!know_ebuild_time) {
 					know_ebuild_time = true;
-					have_ebuild_time = get_mtime(&ebuild_time, full_path.c_str());
+					have_ebuild_time = pkg_dir.get_mtime(&ebuild_time, *fileit);
 				}
 				if(unlikely(!have_ebuild_time)) {
 					break;
@@ -356,7 +358,7 @@ void ParseCache::readPackage(Category *cat, const string& pkg_name, const string
 			}
 		}
 		if(it == further.end()) {
-			parse_exec(full_path.c_str(), directory_path, read_onetime_info, &have_onetime_info, pkg, version);
+			parse_exec(full_path.c_str(), pkg_dir.path(), read_onetime_info, &have_onetime_info, pkg, version);
 		} else {
 			if(verbose) {
 				m_error_callback(eix::format("%s/%s-%s: %s") %
@@ -380,6 +382,13 @@ void ParseCache::readPackage(Category *cat, const string& pkg_name, const string
 	}
 }
 
+void ParseCache::prefetchCategory(const char *cat_name) {
+	for(FurtherCaches::iterator it(further.begin());
+		likely(it != further.end()); ++it) {
+		(*it)->prefetchCategory(cat_name);
+	}
+}
+
 bool ParseCache::readCategoryPrepare(const char *cat_name) {
 	m_catname = cat_name;
 	further_works.clear();
@@ -387,8 +396,9 @@ bool ParseCache::readCategoryPrepare(const char *cat_name) {
 		likely(it != further.end()); ++it) {
 		further_works.PUSH_BACK((*it)->readCategoryPrepare(cat_name));
 	}
-	m_catpath = m_prefix + m_scheme + '/' + cat_name;
-	return scandir_cc(m_catpath, &m_packages, package_selector);
+	m_packages.clear();
+	return (m_catdir.open(m_prefix + m_scheme + '/' + cat_name) &&
+		m_catdir.scan(&m_packages, package_selector));
 }
 
 void ParseCache::readCategoryFinalize() {
@@ -398,17 +408,17 @@ void ParseCache::readCategoryFinalize() {
 		(*it)->readCategoryFinalize();
 	}
 	m_catname.clear();
-	m_catpath.clear();
+	m_catdir.close();
 	m_packages.clear();
 }
 
 bool ParseCache::readCategory(Category *cat) {
 	for(WordVec::const_iterator pit(m_packages.begin());
 		likely(pit != m_packages.end()); ++pit) {
-		string pkg_path(m_catpath + '/' + (*pit));
+		DirHandle pkg_dir;
 		WordVec files;
-		if(scandir_cc(pkg_path, &files, ebuild_selector)) {
-			readPackage(cat, *pit, pkg_path, files);
+		if(pkg_dir.open(m_catdir, *pit) && pkg_dir.scan(&files, ebuild_selector)) {
+			readPackage(cat, *pit, pkg_dir, files);
 		}
 	}
 	return true;
@@ -16,6 +16,7 @@
 #include <vector>
 
 #include "cache/base.h"
+#include "cache/common/dir_handle.h"
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
 #include "eixTk/null.h"
@@ -37,7 +38,7 @@ class ParseCache FINAL : public BasicCache {
 		bool try_parse, nosubst, ebuild_sh;
 		EbuildExec *ebuild_exec;
 		WordVec m_packages;
-		std::string m_catpath;
+		DirHandle m_catdir;
 
 		ATTRIBUTE_NONNULL((2, 3)) void set_checking(std::string *str, const char *item, const VarsReader& ebuild, bool *ok);
 		ATTRIBUTE_NONNULL_ void set_checking(std::string *str, const char *item, const VarsReader& ebuild) {
@@ -45,7 +46,7 @@ class ParseCache FINAL : public BasicCache {
 		}
 
 		ATTRIBUTE_NONNULL_ void parse_exec(const char *fullpath, const std::string& dirpath, bool read_onetime_info, bool *have_onetime_info, Package *pkg, Version *version);
-		ATTRIBUTE_NONNULL_ void readPackage(Category *cat, const std::string& pkg_name, const std::string& directory_path, const WordVec& files);
+		ATTRIBUTE_NONNULL_ void readPackage(Category *cat, const std::string& pkg_name, const DirHandle& pkg_dir, const WordVec& files);
 
 	public:
 		ParseCache() : BasicCache(), verbose(false), ebuild_exec(NULLPTR) {
@@ -64,6 +65,7 @@ class ParseCache FINAL : public BasicCache {
 			verbose = true;
 		}
 
+		ATTRIBUTE_NONNULL_ void prefetchCategory(const char *cat_name) OVERRIDE;
 		ATTRIBUTE_NONNULL_ bool readCategoryPrepare(const char *cat_name) OVERRIDE;
 		ATTRIBUTE_NONNULL_ bool readCategory(Category *cat) OVERRIDE;
 		void readCategoryFinalize() OVERRIDE;
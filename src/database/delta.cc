@@ -0,0 +1,646 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "database/delta.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <unistd.h>
+
+#include <cstdio>
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "database/header.h"
+#include "database/io.h"
+#include "eixTk/diagnostics.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/likely.h"
+#include "eixTk/md5.h"
+#include "eixTk/null.h"
+#include "eixTk/stringutils.h"
+#include "portage/basicversion.h"
+#include "portage/depend.h"
+#include "portage/extendedversion.h"
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+const char DBDelta::magic[] = "eixdelta\n";
+
+const eix::UNumber DBDelta::current;
+
+const DBDelta::RecordType
+	DBDelta::RECORD_COPY,
+	DBDelta::RECORD_DATA,
+	DBDelta::RECORD_PACKAGES,
+	DBDelta::RECORD_REMAP;
+
+const DBDelta::CategoryRecord *DBDelta::DatabaseIndex::find(const string& name) const {
+	map<string, vector<CategoryRecord>::size_type>::const_iterator it(category_index.find(name));
+	if(it == category_index.end()) {
+		return NULLPTR;
+	}
+	return &(categories[it->second]);
+}
+
+void DBDelta::calc_hash_remap(const StringHash& old_hash, const StringHash& new_hash, HashRemap *map) {
+	std::map<string, eix::UNumber> new_index;
+	for(StringHash::size_type i(0); likely(i != new_hash.size()); ++i) {
+		new_index[new_hash[i]] = i + 1;
+	}
+	map->resize(old_hash.size());
+	for(StringHash::size_type i(0); likely(i != old_hash.size()); ++i) {
+		std::map<string, eix::UNumber>::const_iterator it(new_index.find(old_hash[i]));
+		(*map)[i] = ((it == new_index.end()) ? 0 : it->second);
+	}
+}
+
+void DBDelta::calc_remap(const DBHeader& old_hdr, const DBHeader& new_hdr, HeaderRemap *remap) {
+	// The format of the packages must be the same
+	remap->usable = ((old_hdr.version == DBHeader::current) &&
+		(new_hdr.version == DBHeader::current) &&
+		!old_hdr.compressed && !new_hdr.compressed &&
+		(old_hdr.use_depend == new_hdr.use_depend) &&
+		(old_hdr.use_required_use == new_hdr.use_required_use) &&
+		(old_hdr.use_src_uri == new_hdr.use_src_uri));
+	if(!remap->usable) {
+		return;
+	}
+	calc_hash_remap(old_hdr.eapi_hash, new_hdr.eapi_hash, &(remap->eapi));
+	calc_hash_remap(old_hdr.license_hash, new_hdr.license_hash, &(remap->license));
+	calc_hash_remap(old_hdr.keywords_hash, new_hdr.keywords_hash, &(remap->keywords));
+	calc_hash_remap(old_hdr.iuse_hash, new_hdr.iuse_hash, &(remap->iuse));
+	calc_hash_remap(old_hdr.slot_hash, new_hdr.slot_hash, &(remap->slot));
+	calc_hash_remap(old_hdr.depend_hash, new_hdr.depend_hash, &(remap->depend));
+}
+
+bool DBDelta::write_hash_remap(const HashRemap& map, Database *delta, string *errtext) {
+	typedef std::pair<eix::UNumber, eix::UNumber> Run;
+	vector<Run> runs;
+	for(HashRemap::const_iterator it(map.begin());
+		likely(it != map.end()); ++it) {
+		if(!runs.empty()) {
+			Run& run(runs.back());
+			eix::UNumber next((run.second == 0) ? 0 : (run.second + run.first));
+			if(*it == next) {
+				++(run.first);
+				continue;
+			}
+		}
+		runs.PUSH_BACK(Run(1, *it));
+	}
+	if(unlikely(!delta->write_num(runs.size(), errtext))) {
+		return false;
+	}
+	for(vector<Run>::const_iterator it(runs.begin());
+		likely(it != runs.end()); ++it) {
+		if(unlikely(!delta->write_num(it->first, errtext)) ||
+			unlikely(!delta->write_num(it->second, errtext))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DBDelta::read_hash_remap(HashRemap *map, Database *delta, string *errtext) {
+	map->clear();
+	eix::UNumber runs;
+	if(unlikely(!delta->read_num(&runs, errtext))) {
+		return false;
+	}
+	for(; likely(runs != 0); --runs) {
+		eix::UNumber length, first;
+		if(unlikely(!delta->read_num(&length, errtext)) ||
+			unlikely(!delta->read_num(&first, errtext))) {
+			return false;
+		}
+		for(; likely(length != 0); --length) {
+			map->PUSH_BACK(first);
+			if(first != 0) {
+				++first;
+			}
+		}
+	}
+	return true;
+}
+
+bool DBDelta::write_remap(const HeaderRemap& remap, Database *delta, string *errtext) {
+	if(!remap.usable) {
+		return delta->write_num(eix::UNumber(0), errtext);
+	}
+	return (likely(delta->write_num(eix::UNumber(1), errtext)) &&
+		likely(write_hash_remap(remap.eapi, delta, errtext)) &&
+		likely(write_hash_remap(remap.license, delta, errtext)) &&
+		likely(write_hash_remap(remap.keywords, delta, errtext)) &&
+		likely(write_hash_remap(remap.iuse, delta, errtext)) &&
+		likely(write_hash_remap(remap.slot, delta, errtext)) &&
+		likely(write_hash_remap(remap.depend, delta, errtext)));
+}
+
+bool DBDelta::read_remap(HeaderRemap *remap, Database *delta, string *errtext) {
+	eix::UNumber usable;
+	if(unlikely(!delta->read_num(&usable, errtext))) {
+		return false;
+	}
+	remap->usable = (usable != 0);
+	if(!remap->usable) {
+		return true;
+	}
+	return (likely(read_hash_remap(&(remap->eapi), delta, errtext)) &&
+		likely(read_hash_remap(&(remap->license), delta, errtext)) &&
+		likely(read_hash_remap(&(remap->keywords), delta, errtext)) &&
+		likely(read_hash_remap(&(remap->iuse), delta, errtext)) &&
+		likely(read_hash_remap(&(remap->slot), delta, errtext)) &&
+		likely(read_hash_remap(&(remap->depend), delta, errtext)));
+}
+
+bool DBDelta::remap_num(Database *src, const HashRemap& map, Database *dest, bool *complete, string *errtext) {
+	eix::UNumber i;
+	if(unlikely(!src->read_num(&i, errtext))) {
+		return false;
+	}
+	if(unlikely(i >= map.size()) || unlikely(map[i] == 0)) {
+		*complete = false;
+		return dest->write_num(i, errtext);
+	}
+	return dest->write_num(map[i] - 1, errtext);
+}
+
+bool DBDelta::remap_words(Database *src, const HashRemap& map, Database *dest, bool *complete, string *errtext) {
+	eix::UNumber count;
+	if(unlikely(!src->read_num(&count, errtext)) ||
+		unlikely(!dest->write_num(count, errtext))) {
+		return false;
+	}
+	for(; likely(count != 0); --count) {
+		if(unlikely(!remap_num(src, map, dest, complete, errtext))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DBDelta::copy_num(Database *src, Database *dest, string *errtext) {
+	eix::UNumber n;
+	return (likely(src->read_num(&n, errtext)) &&
+		likely(dest->write_num(n, errtext)));
+}
+
+bool DBDelta::copy_string(Database *src, Database *dest, string *errtext) {
+	string s;
+	return (likely(src->read_string(&s, errtext)) &&
+		likely(dest->write_string(s, errtext)));
+}
+
+bool DBDelta::remap_depend(Database *src, const HeaderRemap& remap, Database *dest, bool *complete, string *errtext) {
+	// The length changes with the indices and is recalculated
+	eix::UNumber len;
+	if(unlikely(!src->read_num(&len, errtext))) {
+		return false;
+	}
+	string *wbuf_save(dest->written_to());
+	string buf;
+	dest->write_to(&buf);
+	bool ok(true);
+	// DEPEND, RDEPEND, PDEPEND, BDEPEND, IDEPEND
+	for(int i(0); likely(ok) && likely(i != 5); ++i) {
+		ok = remap_words(src, remap.depend, dest, complete, errtext);
+	}
+	dest->write_to(wbuf_save);
+	return (likely(ok) &&
+		likely(dest->write_num(buf.size(), errtext)) &&
+		likely(dest->write_string_plain(buf, errtext)));
+}
+
+bool DBDelta::remap_versions(Database *src, const DBHeader& hdr, const HeaderRemap& remap, Database *dest, bool *complete, string *errtext) {
+	eix::UNumber count;
+	if(unlikely(!src->read_num(&count, errtext)) ||
+		unlikely(!dest->write_num(count, errtext))) {
+		return false;
+	}
+	for(; likely(count != 0); --count) {
+		eix::UChar properties;
+		eix::UNumber parts;
+		// EAPI, mask, properties, restrict, keywords
+		if(unlikely(!remap_num(src, remap.eapi, dest, complete, errtext)) ||
+			unlikely(!copy_num(src, dest, errtext)) ||
+			unlikely(!src->readUChar(&properties, errtext)) ||
+			unlikely(!dest->writeUChar(properties, errtext)) ||
+			unlikely(!copy_num(src, dest, errtext)) ||
+			unlikely(!remap_words(src, remap.keywords, dest, complete, errtext)) ||
+			unlikely(!src->read_num(&parts, errtext)) ||
+			unlikely(!dest->write_num(parts, errtext))) {
+			return false;
+		}
+		for(; likely(parts != 0); --parts) {
+			string::size_type len;
+			if(unlikely(!src->read_num(&len, errtext)) ||
+				unlikely(!dest->write_num(len, errtext))) {
+				return false;
+			}
+			len /= BasicPart::max_type;
+			if(len != 0) {
+				string part(len, '\0');
+				if(unlikely(!src->read_string_plain(&(part[0]), len, errtext)) ||
+					unlikely(!dest->write_string_plain(part, errtext))) {
+					return false;
+				}
+			}
+		}
+		// SLOT, overlay, IUSE
+		if(unlikely(!remap_num(src, remap.slot, dest, complete, errtext)) ||
+			unlikely(!copy_num(src, dest, errtext)) ||
+			unlikely(!remap_words(src, remap.iuse, dest, complete, errtext))) {
+			return false;
+		}
+		if(hdr.use_required_use &&
+			unlikely(!remap_words(src, remap.iuse, dest, complete, errtext))) {
+			return false;
+		}
+		if(hdr.use_depend &&
+			unlikely(!remap_depend(src, remap, dest, complete, errtext))) {
+			return false;
+		}
+		if(hdr.use_src_uri &&
+			unlikely(!copy_string(src, dest, errtext))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DBDelta::remap_package(Database *src, const PackageRecord& pkg, const DBHeader& hdr, const HeaderRemap& remap, Database *dest, bool *complete, string *errtext) {
+	eix::UNumber len;
+	if(unlikely(!src->seekabs(pkg.offset, errtext)) ||
+		unlikely(!src->read_num(&len, errtext))) {
+		return false;
+	}
+	string *wbuf_save(dest->written_to());
+	string buf;
+	dest->write_to(&buf);
+	// name, description, homepage, licenses, versions
+	bool ok(likely(copy_string(src, dest, errtext)) &&
+		likely(copy_string(src, dest, errtext)) &&
+		likely(copy_string(src, dest, errtext)) &&
+		likely(remap_num(src, remap.license, dest, complete, errtext)) &&
+		likely(remap_versions(src, hdr, remap, dest, complete, errtext)));
+	dest->write_to(wbuf_save);
+	return (likely(ok) &&
+		likely(dest->write_num(buf.size(), errtext)) &&
+		likely(dest->write_string_plain(buf, errtext)));
+}
+
+bool DBDelta::open_index(const char *file, Database *db, DatabaseIndex *index, string *errtext) {
+	if(unlikely(!db->openread(file))) {
+		*errtext = eix::format(_("cannot open database file %s for reading (mode = 'rb')")) % file;
+		return false;
+	}
+	// We need the category lengths of version 40
+	DBHeader& hdr(index->hdr);
+	// We need the depend hash for remapping
+	bool use_depend(Depend::use_depend);
+	Depend::use_depend = true;
+	bool ok(db->read_header(&hdr, errtext, 40));
+	Depend::use_depend = use_depend;
+	if(unlikely(!ok)) {
+		*errtext = eix::format(_("error in database file %s: %s")) % file % (*errtext);
+		return false;
+	}
+	index->header.offset = 0;
+	index->header.size = db->tell();
+	index->categories.resize(hdr.size);
+	for(vector<CategoryRecord>::size_type i(0); likely(i != hdr.size); ++i) {
+		CategoryRecord& cat(index->categories[i]);
+		cat.offset = db->tell();
+		eix::Treesize count;
+		set<ExtendedVersion::Overlay> overlays;
+		eix::OffsetType end;
+		if(unlikely(!db->read_category_header(&(cat.name), &count, &overlays, &end, hdr, errtext))) {
+			return false;
+		}
+		cat.head_size = db->tell() - cat.offset;
+		cat.size = end - cat.offset;
+		index->category_index[cat.name] = i;
+		if(hdr.compressed) {
+			// Compressed categories are compared only as a whole
+			db->discard_block();
+		} else {
+			cat.packages.resize(count);
+			for(vector<PackageRecord>::size_type j(0); likely(j != count); ++j) {
+				PackageRecord& pkg(cat.packages[j]);
+				pkg.offset = db->tell();
+				eix::OffsetType len;
+				if(unlikely(!db->read_num(&len, errtext))) {
+					return false;
+				}
+				pkg.size = db->tell() + len - pkg.offset;
+				if(unlikely(!db->read_string(&(pkg.name), errtext)) ||
+					unlikely(!db->seekabs(pkg.offset + pkg.size, errtext))) {
+					return false;
+				}
+				cat.package_index[pkg.name] = j;
+			}
+		}
+		if(unlikely(!db->seekabs(end, errtext))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DBDelta::read_bytes(Database *db, const Record& record, string *dest, string *errtext) {
+GCC_DIAG_OFF(sign-conversion)
+	dest->resize(record.size);
+GCC_DIAG_ON(sign-conversion)
+	if(unlikely(dest->empty())) {
+		return true;
+	}
+	return (likely(db->seekabs(record.offset, errtext)) &&
+		likely(db->read_string_plain(&((*dest)[0]), dest->size(), errtext)));
+}
+
+bool DBDelta::copy_bytes(Database *src, const Record& record, Database *dest, string *buf, string *errtext) {
+	return (likely(read_bytes(src, record, buf, errtext)) &&
+		likely(dest->write_string_plain(*buf, errtext)));
+}
+
+bool DBDelta::read_data(Database *db, string *dest, string *errtext) {
+	string::size_type len;
+	if(unlikely(!db->read_num(&len, errtext))) {
+		return false;
+	}
+	dest->resize(len);
+	if(unlikely(len == 0)) {
+		return true;
+	}
+	return db->read_string_plain(&((*dest)[0]), len, errtext);
+}
+
+bool DBDelta::write_category(const CategoryRecord& cat, const CategoryRecord *old_cat, const DBHeader& old_hdr, const HeaderRemap& remap, Database *new_db, Database *old_db, Database *delta, string *errtext) {
+	if(unlikely(!delta->write_string(cat.name, errtext))) {
+		return false;
+	}
+	string data;
+	if(unlikely(!read_bytes(new_db, cat, &data, errtext))) {
+		return false;
+	}
+	string old_data;
+	if(old_cat != NULLPTR) {
+		if(unlikely(!read_bytes(old_db, *old_cat, &old_data, errtext))) {
+			return false;
+		}
+		if(data == old_data) {
+			return delta->write_num(RECORD_COPY, errtext);
+		}
+	}
+	if((old_cat == NULLPTR) || cat.packages.empty() ||
+		old_cat->packages.empty()) {
+		return (likely(delta->write_num(RECORD_DATA, errtext)) &&
+			likely(delta->write_string(data, errtext)));
+	}
+	// The header of the category changes with every package
+GCC_DIAG_OFF(sign-conversion)
+	if(unlikely(!delta->write_num(RECORD_PACKAGES, errtext)) ||
+		unlikely(!delta->write_string(data.substr(0, cat.head_size), errtext)) ||
+		unlikely(!delta->write_num(cat.packages.size(), errtext))) {
+		return false;
+	}
+	Database scratch;
+	string remapped;
+	for(vector<PackageRecord>::const_iterator it(cat.packages.begin());
+		likely(it != cat.packages.end()); ++it) {
+		string::size_type pos(it->offset - cat.offset);
+		map<string, vector<PackageRecord>::size_type>::const_iterator
+			old(old_cat->package_index.find(it->name));
+		if(old != old_cat->package_index.end()) {
+			const PackageRecord& old_pkg(old_cat->packages[old->second]);
+			RecordType type(RECORD_DATA);
+			if((old_pkg.size == it->size) &&
+				(data.compare(pos, it->size, old_data,
+					old_pkg.offset - old_cat->offset, old_pkg.size) == 0)) {
+				type = RECORD_COPY;
+			} else if(remap.usable) {
+				// Maybe only the hash indices have changed
+				bool complete(true);
+				remapped.clear();
+				scratch.write_to(&remapped);
+				if(unlikely(!remap_package(old_db, old_pkg, old_hdr, remap, &scratch, &complete, errtext))) {
+					return false;
+				}
+				if(complete && (static_cast<eix::OffsetType>(remapped.size()) == it->size) &&
+					(data.compare(pos, it->size, remapped) == 0)) {
+					type = RECORD_REMAP;
+				}
+			}
+			if(type != RECORD_DATA) {
+				if(unlikely(!delta->write_num(type, errtext)) ||
+					unlikely(!delta->write_string(it->name, errtext))) {
+					return false;
+				}
+				continue;
+			}
+		}
+		if(unlikely(!delta->write_num(RECORD_DATA, errtext)) ||
+			unlikely(!delta->write_string(data.substr(pos, it->size), errtext))) {
+			return false;
+		}
+	}
+GCC_DIAG_ON(sign-conversion)
+	return true;
+}
+
+bool DBDelta::create(const char *old_file, const char *new_file, const char *delta_file, string *errtext) {
+	string old_md5, new_md5;
+	if(unlikely(!get_md5sum(old_file, &old_md5))) {
+		*errtext = eix::format(_("cannot read %s")) % old_file;
+		return false;
+	}
+	if(unlikely(!get_md5sum(new_file, &new_md5))) {
+		*errtext = eix::format(_("cannot read %s")) % new_file;
+		return false;
+	}
+	Database old_db, new_db;
+	DatabaseIndex old_index, new_index;
+	if(unlikely(!open_index(old_file, &old_db, &old_index, errtext)) ||
+		unlikely(!open_index(new_file, &new_db, &new_index, errtext))) {
+		return false;
+	}
+	Database delta;
+	if(unlikely(!delta.openwrite(delta_file))) {
+		*errtext = eix::format(_("cannot open %s for writing")) % delta_file;
+		return false;
+	}
+	string header;
+	if(unlikely(!delta.write_string_plain(magic, errtext)) ||
+		unlikely(!delta.write_num(current, errtext)) ||
+		unlikely(!delta.write_string(old_md5, errtext)) ||
+		unlikely(!delta.write_string(new_md5, errtext)) ||
+		unlikely(!read_bytes(&new_db, new_index.header, &header, errtext)) ||
+		unlikely(!delta.write_string(header, errtext))) {
+		return false;
+	}
+	HeaderRemap remap;
+	calc_remap(old_index.hdr, new_index.hdr, &remap);
+	if(unlikely(!write_remap(remap, &delta, errtext)) ||
+		unlikely(!delta.write_num(new_index.categories.size(), errtext))) {
+		return false;
+	}
+	for(vector<CategoryRecord>::const_iterator it(new_index.categories.begin());
+		likely(it != new_index.categories.end()); ++it) {
+		if(unlikely(!write_category(*it, old_index.find(it->name),
+			old_index.hdr, remap, &new_db, &old_db, &delta, errtext))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DBDelta::apply_category(const DatabaseIndex& old_index, const HeaderRemap& remap, Database *old_db, Database *delta, Database *dest, string *errtext) {
+	string name;
+	RecordType type;
+	if(unlikely(!delta->read_string(&name, errtext)) ||
+		unlikely(!delta->read_num(&type, errtext))) {
+		return false;
+	}
+	const CategoryRecord *old_cat(old_index.find(name));
+	string buf;
+	if(type == RECORD_DATA) {
+		return (likely(read_data(delta, &buf, errtext)) &&
+			likely(dest->write_string_plain(buf, errtext)));
+	}
+	if(unlikely(old_cat == NULLPTR)) {
+		*errtext = eix::format(_("category %s is missing in the old database")) % name;
+		return false;
+	}
+	if(type == RECORD_COPY) {
+		return copy_bytes(old_db, *old_cat, dest, &buf, errtext);
+	}
+	eix::Treesize count;
+	if(unlikely(type != RECORD_PACKAGES) ||
+		unlikely(!read_data(delta, &buf, errtext)) ||
+		unlikely(!dest->write_string_plain(buf, errtext)) ||
+		unlikely(!delta->read_num(&count, errtext))) {
+		return false;
+	}
+	for(; likely(count != 0); --count) {
+		if(unlikely(!delta->read_num(&type, errtext))) {
+			return false;
+		}
+		if(type == RECORD_DATA) {
+			if(unlikely(!read_data(delta, &buf, errtext)) ||
+				unlikely(!dest->write_string_plain(buf, errtext))) {
+				return false;
+			}
+			continue;
+		}
+		if(unlikely(!delta->read_string(&name, errtext))) {
+			return false;
+		}
+		map<string, vector<PackageRecord>::size_type>::const_iterator
+			old(old_cat->package_index.find(name));
+		if(unlikely(old == old_cat->package_index.end())) {
+			*errtext = eix::format(_("package %s/%s is missing in the old database")) % old_cat->name % name;
+			return false;
+		}
+		const PackageRecord& old_pkg(old_cat->packages[old->second]);
+		if(type == RECORD_COPY) {
+			if(unlikely(!copy_bytes(old_db, old_pkg, dest, &buf, errtext))) {
+				return false;
+			}
+			continue;
+		}
+		bool complete(true);
+		if(unlikely(type != RECORD_REMAP) || unlikely(!remap.usable) ||
+			unlikely(!remap_package(old_db, old_pkg, old_index.hdr, remap, dest, &complete, errtext))) {
+			return false;
+		}
+		if(unlikely(!complete)) {
+			*errtext = eix::format(_("cannot remap package %s/%s")) % old_cat->name % name;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DBDelta::apply(const char *old_file, const char *delta_file, const char *new_file, string *errtext) {
+	Database delta;
+	if(unlikely(!delta.openread(delta_file))) {
+		*errtext = eix::format(_("cannot open %s for reading")) % delta_file;
+		return false;
+	}
+	string::size_type magic_len(sizeof(magic) - 1);
+	string buf(magic_len, '\0');
+	eix::UNumber version;
+	if(unlikely(!delta.read_string_plain(&(buf[0]), magic_len, errtext)) ||
+		unlikely(buf != magic) ||
+		unlikely(!delta.read_num(&version, errtext)) ||
+		unlikely(version != current)) {
+		*errtext = eix::format(_("%s is not an eix database delta of format %s")) % delta_file % current;
+		return false;
+	}
+	string old_md5, new_md5, md5;
+	if(unlikely(!delta.read_string(&old_md5, errtext)) ||
+		unlikely(!delta.read_string(&new_md5, errtext))) {
+		return false;
+	}
+	if(unlikely(!get_md5sum(old_file, &md5))) {
+		*errtext = eix::format(_("cannot read %s")) % old_file;
+		return false;
+	}
+	if(unlikely(md5 != old_md5)) {
+		*errtext = eix::format(_("%s does not fit to the delta %s")) % old_file % delta_file;
+		return false;
+	}
+	Database old_db;
+	DatabaseIndex old_index;
+	if(unlikely(!open_index(old_file, &old_db, &old_index, errtext))) {
+		return false;
+	}
+	// Write to a temporary file first, so that new_file may be old_file
+	string temp_file(new_file);
+	temp_file.append(".delta");
+	bool ok(true); {
+		Database dest;
+		if(unlikely(!dest.openwrite(temp_file.c_str()))) {
+			*errtext = eix::format(_("cannot open %s for writing")) % temp_file;
+			return false;
+		}
+		eix::Catsize count(0);
+		HeaderRemap remap;
+		if(unlikely(!read_data(&delta, &buf, errtext)) ||
+			unlikely(!dest.write_string_plain(buf, errtext)) ||
+			unlikely(!read_remap(&remap, &delta, errtext)) ||
+			unlikely(!delta.read_num(&count, errtext))) {
+			ok = false;
+		}
+		for(; likely(ok) && likely(count != 0); --count) {
+			ok = apply_category(old_index, remap, &old_db, &delta, &dest, errtext);
+		}
+	}
+	if(likely(ok)) {
+		if(unlikely(!get_md5sum(temp_file.c_str(), &md5)) ||
+			unlikely(md5 != new_md5)) {
+			*errtext = eix::format(_("applying %s gives a wrong md5sum")) % delta_file;
+			ok = false;
+		} else if(unlikely(std::rename(temp_file.c_str(), new_file) != 0)) {
+			*errtext = eix::format(_("cannot rename %s to %s")) % temp_file % new_file;
+			ok = false;
+		}
+	}
+	if(unlikely(!ok)) {
+		unlink(temp_file.c_str());
+	}
+	return ok;
+}
@@ -0,0 +1,157 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_DATABASE_DELTA_H_
+#define SRC_DATABASE_DELTA_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "database/header.h"
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/stringutils.h"
+
+class Database;
+
+/**
+Binary delta between two eix databases on the level of category and
+package records. A delta contains the md5sums of both databases, the
+header of the new database, and for every category of the new database
+either a reference to an identical record of the old database or the
+new data. Since the hash indices of the header are renumbered whenever
+a string is added to a hash, a package whose only change is such a
+renumbering is stored as a reference, too, together with a table which
+maps the hash indices of the old database to those of the new one.
+Applying the delta to the old database gives a byte-identical copy of
+the new database.
+**/
+class DBDelta {
+	public:
+		static const char magic[];
+		static CONSTEXPR const eix::UNumber current = 2;
+
+		/**
+		Write the delta which transforms old_file into new_file
+		**/
+		ATTRIBUTE_NONNULL((1, 2, 3)) static bool create(const char *old_file, const char *new_file, const char *delta_file, std::string *errtext);
+
+		/**
+		Apply delta_file to old_file and write the result to new_file
+		(which may be the same as old_file)
+		**/
+		ATTRIBUTE_NONNULL((1, 2, 3)) static bool apply(const char *old_file, const char *delta_file, const char *new_file, std::string *errtext);
+
+	private:
+		typedef eix::UNumber RecordType;
+		static CONSTEXPR const RecordType
+			RECORD_COPY     = 0,
+			RECORD_DATA     = 1,
+			RECORD_PACKAGES = 2,
+			RECORD_REMAP    = 3;
+
+		class Record {
+			public:
+				eix::OffsetType offset, size;
+		};
+
+		class PackageRecord : public Record {
+			public:
+				std::string name;
+		};
+
+		class CategoryRecord : public Record {
+			public:
+				std::string name;
+				/**
+				Size of the category header; packages start thereafter
+				**/
+				eix::OffsetType head_size;
+				/**
+				Empty for compressed categories
+				**/
+				std::vector<PackageRecord> packages;
+				std::map<std::string, std::vector<PackageRecord>::size_type> package_index;
+		};
+
+		class DatabaseIndex {
+			public:
+				DBHeader hdr;
+				Record header;
+				std::vector<CategoryRecord> categories;
+				std::map<std::string, std::vector<CategoryRecord>::size_type> category_index;
+
+				ATTRIBUTE_PURE const CategoryRecord *find(const std::string& name) const;
+		};
+
+		/**
+		Index i of a hash of the old database is mapped to entry i
+		which is 0 if the string is missing in the new database and
+		the index in the new database plus 1 otherwise
+		**/
+		typedef std::vector<eix::UNumber> HashRemap;
+
+		class HeaderRemap {
+			public:
+				/**
+				false if the databases differ in the format of the
+				packages so that the hash indices cannot be remapped
+				**/
+				bool usable;
+				HashRemap eapi, license, keywords, iuse, slot, depend;
+
+				HeaderRemap() : usable(false) {
+				}
+		};
+
+		ATTRIBUTE_NONNULL_ static void calc_hash_remap(const StringHash& old_hash, const StringHash& new_hash, HashRemap *map);
+		ATTRIBUTE_NONNULL_ static void calc_remap(const DBHeader& old_hdr, const DBHeader& new_hdr, HeaderRemap *remap);
+		/**
+		A map is stored as a list of runs: the length of the run and the
+		first entry. The following entries of a run are consecutive
+		(or all 0).
+		**/
+		ATTRIBUTE_NONNULL_ static bool write_hash_remap(const HashRemap& map, Database *delta, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool read_hash_remap(HashRemap *map, Database *delta, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool write_remap(const HeaderRemap& remap, Database *delta, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool read_remap(HeaderRemap *remap, Database *delta, std::string *errtext);
+
+		/**
+		Copy the package record from src to dest, mapping the hash indices
+		with remap.
+		@param complete set to false if an index cannot be mapped
+		**/
+		ATTRIBUTE_NONNULL_ static bool remap_package(Database *src, const PackageRecord& pkg, const DBHeader& hdr, const HeaderRemap& remap, Database *dest, bool *complete, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool remap_versions(Database *src, const DBHeader& hdr, const HeaderRemap& remap, Database *dest, bool *complete, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool remap_depend(Database *src, const HeaderRemap& remap, Database *dest, bool *complete, std::string *errtext);
+		/**
+		Copy a number or string unchanged
+		**/
+		ATTRIBUTE_NONNULL_ static bool copy_num(Database *src, Database *dest, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool copy_string(Database *src, Database *dest, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool remap_num(Database *src, const HashRemap& map, Database *dest, bool *complete, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool remap_words(Database *src, const HashRemap& map, Database *dest, bool *complete, std::string *errtext);
+
+		ATTRIBUTE_NONNULL_ static bool open_index(const char *file, Database *db, DatabaseIndex *index, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool read_bytes(Database *db, const Record& record, std::string *dest, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool copy_bytes(Database *src, const Record& record, Database *dest, std::string *buf, std::string *errtext);
+
+		/**
+		Read data which was written with write_string(); unlike
+		read_string() this is safe for binary data
+		**/
+		ATTRIBUTE_NONNULL_ static bool read_data(Database *db, std::string *dest, std::string *errtext);
+
+		ATTRIBUTE_NONNULL((5, 6, 7, 8)) static bool write_category(const CategoryRecord& cat, const CategoryRecord *old_cat, const DBHeader& old_hdr, const HeaderRemap& remap, Database *new_db, Database *old_db, Database *delta, std::string *errtext);
+		ATTRIBUTE_NONNULL_ static bool apply_category(const DatabaseIndex& old_index, const HeaderRemap& remap, Database *old_db, Database *delta, Database *dest, std::string *errtext);
+};
+
+#endif  // SRC_DATABASE_DELTA_H_
@@ -17,6 +17,8 @@
 #include "eixTk/filenames.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/sharedstring.h"
+#include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "portage/extendedversion.h"
 
@@ -27,7 +29,8 @@ const DBHeader::SaveBitmask
 	DBHeader::SAVE_BITMASK_NONE,
 	DBHeader::SAVE_BITMASK_DEP,
 	DBHeader::SAVE_BITMASK_REQUIRED_USE,
-	DBHeader::SAVE_BITMASK_SRC_URI;
+	DBHeader::SAVE_BITMASK_SRC_URI,
+	DBHeader::SAVE_BITMASK_COMPRESSED;
 
 const DBHeader::OverlayTest
 	DBHeader::OVTEST_NONE,
@@ -48,12 +51,34 @@ practically sure the first match should be it; if not, the second.
 The remainder is meant for museum systems.)
 **/
 const DBHeader::DBVersion DBHeader::accept[] = {
-	DBHeader::current, 38, 37, 36, 35, 34, 33, 32, 31,
+	DBHeader::current, 40, 39, 38, 37, 36, 35, 34, 33, 32, 31,
 	0
 };
 
 const char DBHeader::magic[] = "eix\n";
 
+static void share_hash(SharedWords::WordList *shared, const StringHash& hash);
+
+static void share_hash(SharedWords::WordList *shared, const StringHash& hash) {
+	shared->resize(hash.size());
+	for(StringHash::size_type i(0); likely(i != hash.size()); ++i) {
+		(*shared)[i].assign(hash[i]);
+	}
+}
+
+void DBHeader::share_hashs() {
+	slot_shared.resize(slot_hash.size());
+	for(StringHash::size_type i(0); likely(i != slot_hash.size()); ++i) {
+		string slot, subslot;
+		slot_subslot(slot_hash[i], &slot, &subslot);
+		slot_shared[i].first.assign(slot);
+		slot_shared[i].second.assign(subslot);
+	}
+	share_hash(&keywords_shared, keywords_hash);
+	share_hash(&iuse_shared, iuse_hash);
+	share_hash(&depend_shared, depend_hash);
+}
+
 /**
 Get overlay for key from table
 **/
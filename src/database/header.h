@@ -14,10 +14,13 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
 #include "eixTk/eixint.h"
+#include "eixTk/sharedstring.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "portage/extendedversion.h"
@@ -46,15 +49,33 @@ class DBHeader {
 			slot_hash,
 			depend_hash;
 
+		/**
+		The entries of the hashes resolved to the global pools, with the
+		same indices. They are filled by share_hashs() when the header is
+		read, so that reading a version needs no string copy or lookup.
+		**/
+		typedef std::pair<SharedString, SharedString> SlotSubslot;
+		std::vector<SlotSubslot> slot_shared;
+		SharedWords::WordList keywords_shared, iuse_shared, depend_shared;
+
+		void share_hashs();
+
 		typedef  eix::UNumber SaveBitmask;
 		static CONSTEXPR const SaveBitmask
 			SAVE_BITMASK_NONE         = 0x00U,
 			SAVE_BITMASK_DEP          = 0x01U,
 			SAVE_BITMASK_REQUIRED_USE = 0x02U,
-			SAVE_BITMASK_SRC_URI      = 0x04U;
+			SAVE_BITMASK_SRC_URI      = 0x04U,
+			SAVE_BITMASK_COMPRESSED   = 0x08U;
 
 		bool use_depend, use_required_use, use_src_uri;
 
+		/**
+		Whether the packages of each category are stored as one
+		independently zlib-compressed block
+		**/
+		bool compressed;
+
 		WordVec world_sets;
 
 		typedef  eix::UNumber DBVersion;
@@ -75,7 +96,7 @@ class DBHeader {
 		/**
 		Current version of database-format and what we accept
 		**/
-		static CONSTEXPR const DBVersion current = 39;
+		static CONSTEXPR const DBVersion current = 41;
 		static const DBHeader::DBVersion accept[];
 
 		/**
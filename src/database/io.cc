@@ -8,7 +8,14 @@
 #include "database/io.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
 #include <cstdio>
+#include <cstring>
 
 #include <string>
 
@@ -16,6 +23,10 @@
 #include <sys/file.h>
 #endif
 
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
 #include "database/header.h"
 #include "eixTk/auto_array.h"
 #include "eixTk/diagnostics.h"
@@ -23,6 +34,7 @@
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/sharedstring.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 
@@ -34,25 +46,76 @@ bool File::openread(const char *name) {
 	}
 #ifdef HAVE_FILENO
 #ifdef HAVE_FLOCK
-	flock(fileno(fp), LOCK_SH);
+	int fd(fileno(fp));
+	flock(fd, LOCK_SH);
+	// The file is truncated only with an exclusive lock (see openwrite()),
+	// so a mapping is safe as long as we hold our lock
+	map_file(fd);
 #endif
 #endif
 	return true;
 }
 
+bool File::get_stat(struct stat *st) const {
+#ifdef HAVE_FILENO
+	return ((fp != NULLPTR) && (fstat(fileno(fp), st) == 0));
+#else
+	return false;
+#endif
+}
+
+/**
+Map the file read-only; if this fails, we silently read with stdio
+**/
+void File::map_file(int fd) {
+	struct stat st;
+	if(unlikely(fstat(fd, &st) != 0) || unlikely(st.st_size <= 0)) {
+		return;
+	}
+GCC_DIAG_OFF(sign-conversion)
+	void *buffer(mmap(NULLPTR, st.st_size, PROT_READ, MAP_SHARED, fd, 0));
+GCC_DIAG_ON(sign-conversion)
+GCC_DIAG_OFF(old-style-cast)
+	if(unlikely(buffer == MAP_FAILED)) {
+GCC_DIAG_ON(old-style-cast)
+		return;
+	}
+	m_map = static_cast<const char *>(buffer);
+	m_map_size = st.st_size;
+	m_map_pos = 0;
+}
+
 bool File::openwrite(const char *name) {
+#ifdef HAVE_FLOCK
+	// Truncate only after we got the lock: readers might have mapped the file
+	int fd(open(name, O_WRONLY | O_CREAT, 0666));
+	if(unlikely(fd < 0)) {
+		return false;
+	}
+	flock(fd, LOCK_EX);
+	if(unlikely(ftruncate(fd, 0) != 0) ||
+		unlikely((fp = fdopen(fd, "wb")) == NULLPTR)) {
+		close(fd);
+		return false;
+	}
+#else
 	if((fp = std::fopen(name, "wb")) == NULLPTR) {
 		return false;
 	}
-#ifdef HAVE_FILENO
-#ifdef HAVE_FLOCK
-	flock(fileno(fp), LOCK_EX);
-#endif
 #endif
 	return true;
 }
 
 void File::destroy() {
+	if(m_map != NULLPTR) {
+		// Without a file, the data is not mapped by us (see openmem())
+		if(fp != NULLPTR) {
+GCC_DIAG_OFF(sign-conversion)
+			munmap(const_cast<char *>(m_map), m_map_size);
+GCC_DIAG_ON(sign-conversion)
+		}
+		m_map = NULLPTR;
+	}
 	if(unlikely(fp == NULLPTR)) {
 		return;
 	}
@@ -66,13 +129,58 @@ void File::destroy() {
 	std::fclose(fp);
 }
 
+bool File::read_rest(string *data) {
+	if(likely(m_map != NULLPTR)) {
+GCC_DIAG_OFF(sign-conversion)
+		data->append(m_map + m_map_pos, m_map_size - m_map_pos);
+GCC_DIAG_ON(sign-conversion)
+		m_map_pos = m_map_size;
+		return true;
+	}
+	char buf[4096];
+	string::size_type len;
+	while((len = std::fread(buf, sizeof(*buf), sizeof(buf), fp)) != 0) {
+		data->append(buf, len);
+	}
+	return (std::ferror(fp) == 0);
+}
+
 bool File::seek(eix::OffsetType offset, int whence, string *errtext) {
+	if(unlikely(m_in_block)) {
+		if(whence == SEEK_CUR) {
+GCC_DIAG_OFF(sign-conversion)
+			offset += m_block_base + m_block_pos;
+GCC_DIAG_ON(sign-conversion)
+			whence = SEEK_SET;
+		}
+		if(likely(offset >= m_block_base)) {
+GCC_DIAG_OFF(sign-conversion)
+			string::size_type pos(offset - m_block_base);
+GCC_DIAG_ON(sign-conversion)
+			if(likely(pos <= m_block_size)) {
+				m_block_pos = pos;
+				return true;
+			}
+		}
+		m_in_block = false;
+	}
+	if(likely(m_map != NULLPTR)) {
+		if(whence == SEEK_CUR) {
+			offset += m_map_pos;
+		}
+		if(likely(offset >= 0)) {
+			m_map_pos = offset;
+			return true;
+		}
+	} else {
 #ifdef HAVE_FSEEKO
-	if(likely(fseeko(fp, offset, whence) == 0))
+		if(likely(fseeko(fp, offset, whence) == 0)) {
 #else
-	if(likely(std::fseek(fp, offset, whence) == 0))
+		if(likely(std::fseek(fp, offset, whence) == 0)) {
 #endif
-		return true;
+			return true;
+		}
+	}
 	if(errtext != NULLPTR) {
 		*errtext = _("fseek failed");
 	}
@@ -80,6 +188,14 @@ bool File::seek(eix::OffsetType offset, int whence, string *errtext) {
 }
 
 eix::OffsetType File::tell() {
+	if(unlikely(m_in_block)) {
+GCC_DIAG_OFF(sign-conversion)
+		return m_block_base + m_block_pos;
+GCC_DIAG_ON(sign-conversion)
+	}
+	if(likely(m_map != NULLPTR)) {
+		return m_map_pos;
+	}
 #ifdef HAVE_FSEEKO
 	// We rely on autoconf whose documentation states:
 	// All systems with fseeko() also supply ftello()
@@ -89,6 +205,89 @@ eix::OffsetType File::tell() {
 #endif
 }
 
+void File::begin_block(eix::OffsetType len, string::size_type size) {
+	m_block_base = tell();
+	m_block_len = len;
+	m_block_size = size;
+	m_block_pos = 0;
+	m_in_block = true;
+	m_block_pending = true;
+}
+
+/**
+Inflate the current block. The file position is still at its start
+since we did not read anything since begin_block()
+**/
+bool File::fill_block() {
+	m_block_pending = false;
+#ifdef WITH_ZLIB
+GCC_DIAG_OFF(sign-conversion)
+	m_zbuf.resize(m_block_len);
+GCC_DIAG_ON(sign-conversion)
+	m_block.resize(m_block_size);
+	uLongf dest_len(m_block_size);
+	if(likely((m_block_len == 0) ||
+		raw_read(&(m_zbuf[0]), m_zbuf.size())) &&
+		likely((m_block_size == 0) ||
+		((uncompress(reinterpret_cast<Bytef *>(&(m_block[0])), &dest_len,
+			reinterpret_cast<const Bytef *>(m_zbuf.data()), m_zbuf.size()) == Z_OK) &&
+		(dest_len == m_block_size)))) {
+		return true;
+	}
+#endif
+	m_block_error = true;
+	m_in_block = false;
+	return false;
+}
+
+/**
+Continue reading from the file after the end of the current block
+**/
+bool File::leave_block() {
+	m_in_block = false;
+	if(!m_block_pending) {
+		return true;
+	}
+	m_block_pending = false;
+	return seek(m_block_base + m_block_len, SEEK_SET, NULLPTR);
+}
+
+int File::block_getch() {
+	if(unlikely(m_block_pos == m_block_size)) {
+		if(unlikely(!leave_block())) {
+			return EOF;
+		}
+		return raw_getch();
+	}
+	if(unlikely(m_block_pending) && unlikely(!fill_block())) {
+		return EOF;
+	}
+	return static_cast<eix::UChar>(m_block[m_block_pos++]);
+}
+
+bool File::block_read(char *s, string::size_type len) {
+	// An empty string at the end must not leave the block
+	if(unlikely(len == 0)) {
+		return true;
+	}
+	if(unlikely(m_block_pos == m_block_size)) {
+		if(unlikely(!leave_block())) {
+			return false;
+		}
+		return raw_read(s, len);
+	}
+	if(unlikely(m_block_pending) && unlikely(!fill_block())) {
+		return false;
+	}
+	if(unlikely(len > m_block_size - m_block_pos)) {
+		m_block_error = true;
+		return false;
+	}
+	std::memcpy(s, m_block.data() + m_block_pos, len);
+	m_block_pos += len;
+	return true;
+}
+
 bool File::read_string_plain(char *s, string::size_type len, string *errtext) {
 	if(likely(read(s, len))) {
 		return true;
@@ -106,8 +305,13 @@ bool File::write_string_plain(const string& str, string *errtext) {
 }
 
 void File::readError(string *errtext) {
-	if(errtext != NULLPTR) {
-		*errtext = (feof(fp) ?
+	if(errtext == NULLPTR) {
+		return;
+	}
+	if(unlikely(m_block_error)) {
+		*errtext = _("error while decompressing database");
+	} else {
+		*errtext = (((m_map != NULLPTR) ? (m_map_pos >= m_map_size) : feof(fp)) ?
 			_("error while reading from database: end of file") :
 			_("error while reading from database"));
 	}
@@ -130,25 +334,13 @@ bool Database::readUChar(eix::UChar *c, string *errtext) {
 }
 
 bool Database::writeUChar(eix::UChar c, string *errtext) {
-	if(counting) {
-		++counter;
-	} else if(unlikely(!putch(c))) {
+	if(unlikely(!putch(c))) {
 		writeError(errtext);
 		return false;
 	}
 	return true;
 }
 
-bool Database::write_string_plain(const string& str, string *errtext) {
-	if(counting) {
-GCC_DIAG_OFF(sign-conversion)
-		counter += str.size();
-GCC_DIAG_ON(sign-conversion)
-		return true;
-	}
-	return File::write_string_plain(str, errtext);
-}
-
 bool Database::read_string(string *s, string *errtext) {
 	string::size_type len;
 	if(unlikely(!read_num(&len, errtext))) {
@@ -209,25 +401,49 @@ bool Database::read_hash_words(const StringHash& hash, WordVec *s, string *errte
 	return true;
 }
 
-bool Database::read_hash_words(const StringHash& hash, string *s, string *errtext) {
-	s->clear();
-	WordVec::size_type e;
-	if(unlikely(!read_num(&e, errtext))) {
+bool Database::write_hash_words(const StringHash& hash, const SharedWords& words, string *errtext) {
+	const SharedWords::WordList& list(words.words());
+	if(unlikely(!write_num(list.size(), errtext))) {
 		return false;
 	}
-	for(; e != 0; --e) {
-		string r;
-		if(unlikely(!read_hash_string(hash, &r, errtext))) {
+	for(SharedWords::WordList::const_iterator i(list.begin()); likely(i != list.end()); ++i) {
+		if(unlikely(!write_hash_string(hash, i->get(), errtext))) {
 			return false;
 		}
-		if(!s->empty()) {
-			s->append(1, ' ');
+	}
+	return true;
+}
+
+bool Database::read_hash_words(const SharedWords::WordList& table, SharedWords *s, string *errtext) {
+	SharedWords::WordList::size_type e;
+	if(unlikely(!read_num(&e, errtext))) {
+		return false;
+	}
+	words_buf.resize(e);
+	for(SharedWords::WordList::size_type i(0); likely(i != e); ++i) {
+		StringHash::size_type index;
+		if(unlikely(!read_hash_index(table.size(), &index, errtext))) {
+			return false;
 		}
-		s->append(r);
+		words_buf[i] = table[index];
 	}
+	s->assign(&words_buf);
 	return true;
 }
 
+bool Database::read_hash_index(StringHash::size_type size, StringHash::size_type *i, string *errtext) {
+	if(unlikely(!read_num(i, errtext))) {
+		return false;
+	}
+	if(likely(*i < size)) {
+		return true;
+	}
+	if(errtext != NULLPTR) {
+		*errtext = _("database corrupt: nonexistent hash required");
+	}
+	return false;
+}
+
 bool Database::read_hash_words(string *errtext) {
 	WordVec::size_type e;
 	if(unlikely(!read_num(&e, errtext))) {
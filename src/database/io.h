@@ -11,7 +11,9 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <cstdio>
+#include <cstring>
 
+#include <set>
 #include <string>
 
 #include "database/header.h"
@@ -21,32 +23,92 @@
 #include "eixTk/eixint.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/sharedstring.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "portage/extendedversion.h"
 
 // check_includes: include "portage/basicversion.h"
 
 class BasicPart;
+class Category;
+class DBDelta;
 class IUseSet;
 class Package;
 class PackageReader;
 class PackageTree;
 class PortageSettings;
+class DBSegment;
 class Depend;
 class Version;
+struct stat;
 
 #define MAGICNUMCHAR 0xFFU
 
 class File {
 	private:
 		FILE *fp;
+
+		/**
+		If not NULLPTR, the file is read through this read-only shared
+		mapping: concurrent readers then share the pages of the file
+		instead of copying them into private stdio buffers.
+		**/
+		const char *m_map;
+		eix::OffsetType m_map_size, m_map_pos;
+
+		/**
+		If not NULLPTR, putch() and write() append to this buffer
+		**/
+		std::string *m_wbuf;
+
+		/**
+		Block mode: reading is served from the decompressed m_block.
+		The block is inflated only on first access so that seeking over
+		it is cheap. Offsets inside the block are reported as
+		m_block_base + position in the uncompressed data.
+		**/
+		bool m_in_block, m_block_pending, m_block_error;
+		eix::OffsetType m_block_base, m_block_len;
+		std::string::size_type m_block_size, m_block_pos;
+		std::string m_block, m_zbuf;
+
 		bool seek(eix::OffsetType offset, int whence, std::string *errtext);
+		void map_file(int fd);
+
+		int raw_getch() {
+			if(likely(m_map != NULLPTR)) {
+				if(likely(m_map_pos < m_map_size)) {
+					return static_cast<eix::UChar>(m_map[m_map_pos++]);
+				}
+				return EOF;
+			}
+			return std::fgetc(fp);
+		}
+
+		bool raw_read(char *s, std::string::size_type len) {
+			if(likely(m_map != NULLPTR)) {
+				if(unlikely(static_cast<eix::OffsetType>(len) > m_map_size - m_map_pos)) {
+					m_map_pos = m_map_size;
+					return false;
+				}
+				std::memcpy(s, m_map + m_map_pos, len);
+				m_map_pos += static_cast<eix::OffsetType>(len);
+				return true;
+			}
+			return (std::fread(s, sizeof(*s), len, fp) == len);
+		}
+
+		bool fill_block();
+		bool leave_block();
+		int block_getch();
+		bool block_read(char *s, std::string::size_type len);
 
 		File(const File& s) ASSIGN_DELETE;
 		File& operator=(const File& s) ASSIGN_DELETE;
 
 	public:
-		File() : fp(NULLPTR) {
+		File() : fp(NULLPTR), m_map(NULLPTR), m_map_size(0), m_map_pos(0), m_wbuf(NULLPTR), m_in_block(false), m_block_pending(false), m_block_error(false) {
 		}
 
 		~File() {
@@ -54,38 +116,108 @@ class File {
 		}
 
 #ifdef HAVE_MOVE
-		File(File&& s) NOEXCEPT : fp(s.fp) {
+		File(File&& s) NOEXCEPT : fp(s.fp), m_map(s.m_map), m_map_size(s.m_map_size), m_map_pos(s.m_map_pos), m_wbuf(NULLPTR), m_in_block(false), m_block_pending(false), m_block_error(false) {
 			s.fp = NULLPTR;
+			s.m_map = NULLPTR;
 		}
 
 		File& operator=(File&& s) NOEXCEPT {
 			destroy();
 			fp = s.fp;
 			s.fp = NULLPTR;
+			m_map = s.m_map;
+			m_map_size = s.m_map_size;
+			m_map_pos = s.m_map_pos;
+			s.m_map = NULLPTR;
+			m_in_block = false;
 			return *this;
 		}
 #endif
 		void destroy();
 
 		ATTRIBUTE_NONNULL_ bool openread(const char *name);
+
+		/**
+		Get the status of the opened file
+		**/
+		ATTRIBUTE_NONNULL_ bool get_stat(struct stat *st) const;
+
+		/**
+		Read from the size bytes at data (which must stay valid)
+		instead of from a file
+		**/
+		ATTRIBUTE_NONNULL_ void openmem(const char *data, eix::OffsetType size) {
+			m_map = data;
+			m_map_size = size;
+			m_map_pos = 0;
+		}
+
+		/**
+		Append everything from the current position to the end to data
+		**/
+		ATTRIBUTE_NONNULL_ bool read_rest(std::string *data);
 		ATTRIBUTE_NONNULL_ bool openwrite(const char *name);
 
 		int getch() {
-			return std::fgetc(fp);
+			if(likely(!m_in_block)) {
+				return raw_getch();
+			}
+			return block_getch();
 		}
 
 		bool putch(eix::UChar c) {
+			if(m_wbuf != NULLPTR) {
+				m_wbuf->append(1, c);
+				return true;
+			}
 			return (std::fputc(c, fp) != EOF);
 		}
 
 		bool read(char *s, std::string::size_type len) {
-			return (std::fread(s, sizeof(*s), len, fp) == len);
+			if(likely(!m_in_block)) {
+				return raw_read(s, len);
+			}
+			return block_read(s, len);
 		}
 
 		bool write(const std::string str) {
+			if(m_wbuf != NULLPTR) {
+				m_wbuf->append(str);
+				return true;
+			}
 			return (std::fwrite(static_cast<const void *>(str.c_str()), sizeof(*(str.c_str())), str.size(), fp) == str.size());
 		}
 
+		/**
+		Let putch() and write() append to buf instead of writing to the file
+		(or write to the file again if buf is NULLPTR)
+		**/
+		void write_to(std::string *buf) {
+			m_wbuf = buf;
+		}
+
+		/**
+		@return the buffer passed to write_to()
+		**/
+		std::string *written_to() const {
+			return m_wbuf;
+		}
+
+		/**
+		The next len bytes of the file are a zlib-compressed block with
+		size bytes of uncompressed data. Reading is redirected into this
+		block until it is exhausted or left by seeking.
+		**/
+		void begin_block(eix::OffsetType len, std::string::size_type size);
+
+		/**
+		Stop reading from the current block without inflating it.
+		The file position must be set with seekabs() afterwards.
+		**/
+		void discard_block() {
+			m_in_block = false;
+		}
+
 		ATTRIBUTE_NONNULL((2)) bool read_string_plain(char *s, std::string::size_type len, std::string *errtext);
 		bool write_string_plain(const std::string& str, std::string *errtext);
 
@@ -104,15 +236,28 @@ class File {
 };
 
 class Database : public File {
+		friend class DBDelta;
+		friend class DBSegment;
 		friend class PackageReader;
 
 	private:
-		bool counting;
-		eix::OffsetType counter;
+		/**
+		If not NULLPTR, read_header() and PackageReader use this segment
+		**/
+		const DBSegment *m_segment;
+
+		/**
+		The offset of the world sets in the last header read
+		**/
+		eix::OffsetType m_sets_offset;
+
+		/**
+		Buffer for read_hash_words()
+		**/
+		SharedWords::WordList words_buf;
 
 		ATTRIBUTE_NONNULL((2)) bool read_Part(BasicPart *b, std::string *errtext);
 		bool write_Part(const BasicPart& n, std::string *errtext);
-		bool write_string_plain(const std::string& str, std::string *errtext);
 
 	protected:
 		bool readUChar(eix::UChar *c, std::string *errtext);
@@ -136,10 +281,23 @@ class Database : public File {
 			return write_num(hash.get_index(s), errtext);
 		}
 
-		ATTRIBUTE_NONNULL((3)) bool read_hash_string(const StringHash& hash, std::string *s, std::string *errtext) {
+		/**
+		Let s point to the string stored in hash (instead of copying it).
+		The pointer is valid as long as hash is not modified.
+		**/
+		ATTRIBUTE_NONNULL((3)) bool read_hash_ref(const StringHash& hash, const std::string **s, std::string *errtext) {
 			StringHash::size_type i;
 			if(likely(read_num(&i, errtext))) {
-				*s = hash[i];
+				*s = &(hash[i]);
+				return true;
+			}
+			return false;
+		}
+
+		ATTRIBUTE_NONNULL((3)) bool read_hash_string(const StringHash& hash, std::string *s, std::string *errtext) {
+			const std::string *r;
+			if(likely(read_hash_ref(hash, &r, errtext))) {
+				*s = *r;
 				return true;
 			}
 			return false;
@@ -153,10 +311,22 @@ class Database : public File {
 			return write_hash_words(hash, word_vec, errtext);
 		}
 
+		bool write_hash_words(const StringHash& hash, const SharedWords& words, std::string *errtext);
+
 		ATTRIBUTE_NONNULL((3)) bool read_hash_words(const StringHash& hash, WordVec *s, std::string *errtext);
-		ATTRIBUTE_NONNULL((3)) bool read_hash_words(const StringHash& hash, std::string *s, std::string *errtext);
+
+		/**
+		Read the words as indices into table, one of the hashes of
+		DBHeader resolved to pooled strings
+		**/
+		ATTRIBUTE_NONNULL((3)) bool read_hash_words(const SharedWords::WordList& table, SharedWords *s, std::string *errtext);
 		bool read_hash_words(std::string *errtext);
 
+		/**
+		Read an index into a hash or table with size entries
+		**/
+		ATTRIBUTE_NONNULL((3)) bool read_hash_index(StringHash::size_type size, StringHash::size_type *i, std::string *errtext);
+
 		ATTRIBUTE_NONNULL((3)) bool read_iuse(const StringHash& hash, IUseSet *iuse, std::string *errtext);
 
 		ATTRIBUTE_NONNULL((2)) bool read_version(Version *v, const DBHeader& hdr, std::string *errtext);
@@ -165,8 +335,25 @@ class Database : public File {
 		ATTRIBUTE_NONNULL((2)) bool read_depend(Depend *dep, const DBHeader& hdr, std::string *errtext);
 		bool write_depend(const Depend& dep, const DBHeader& hdr, std::string *errtext);
 
-		ATTRIBUTE_NONNULL((2, 3)) bool read_category_header(std::string *name, eix::Treesize *h, std::string *errtext);
-		bool write_category_header(const std::string& name, eix::Treesize size, std::string *errtext);
+		/**
+		Read the category header. Since database version 40 this contains
+		the overlays occurring in the category and the byte length of the
+		package vector, so that a reader can seek over the whole category:
+		end is set to the file offset after the category.
+		For older formats, overlays is cleared and end is set to 0.
+		If hdr.compressed, the subsequent reads are served from the
+		(lazily inflated) block of the category.
+		**/
+		ATTRIBUTE_NONNULL((2, 3, 4, 5)) bool read_category_header(std::string *name, eix::Treesize *h, std::set<ExtendedVersion::Overlay> *overlays, eix::OffsetType *end, const DBHeader& hdr, std::string *errtext);
+		bool write_category_header(const std::string& name, const std::set<ExtendedVersion::Overlay>& overlays, std::string *errtext);
+		bool write_category(const Category& cat, const DBHeader& hdr, std::string *errtext);
+
+		/**
+		Write the packages of cat as one zlib-compressed block preceded
+		by its total length, the number of packages, and the
+		uncompressed size
+		**/
+		bool write_category_compressed(const Category& cat, const DBHeader& hdr, std::string *errtext);
 
 		bool write_package(const Package& pkg, const DBHeader& hdr, std::string *errtext);
 		bool write_package_pure(const Package& pkg, const DBHeader& hdr, std::string *errtext);
@@ -175,7 +362,16 @@ class Database : public File {
 		ATTRIBUTE_NONNULL((2)) bool read_hash(StringHash *hash, std::string *errtext);
 
 	public:
-		Database() : counting(false), counter(0) {
+		Database() : m_segment(NULLPTR), m_sets_offset(0) {
+		}
+
+		/**
+		Use segment (which must be made for this database and stay mapped)
+		when reading, or stop using a segment if segment is NULLPTR.
+		If the header read does not fit to segment, it is not used.
+		**/
+		void use_segment(const DBSegment *segment) {
+			m_segment = segment;
 		}
 
 		ATTRIBUTE_NONNULL_ static void prep_header_hashs(DBHeader *hdr, const PackageTree& tree);
@@ -234,14 +430,6 @@ GCC_DIAG_OFF(sign-conversion)
 GCC_DIAG_ON(sign-conversion)
 	// Test the most common case explicitly to speed up:
 	if(t == static_cast<m_Tp>(c)) {
-		if(counting) {
-			if(unlikely(c == MAGICNUMCHAR)) {
-				counter += 2;
-			} else {
-				++counter;
-			}
-			return true;
-		}
 		if(likely(putch(c))) {
 			if(likely(c != MAGICNUMCHAR)) {
 				return true;
@@ -262,13 +450,6 @@ GCC_DIAG_ON(sign-conversion)
 			++count;
 		} while((t & mask) != t);
 		// We have count > 0 here
-		if(counting) {
-GCC_DIAG_OFF(sign-conversion)
-			eix::UChar d((t >> (8*count)) & 0xFFU);
-			counter += ((unlikely(d == MAGICNUMCHAR)) ? 2 : 1) + (2 * count);
-GCC_DIAG_ON(sign-conversion)
-			return true;
-		}
 		for(unsigned int r(count); ;) {
 			if(unlikely(!putch(MAGICNUMCHAR))) {
 				break;
@@ -16,6 +16,7 @@
 
 #include "database/header.h"
 #include "database/io.h"
+#include "database/segment.h"
 #include "eixTk/auto_array.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
@@ -68,6 +69,9 @@ GCC_DIAG_ON(sign-conversion)
 	if(unlikely(!read_num(&(hdr->size), errtext))) {
 		return false;
 	}
+	if((m_segment != NULLPTR) && unlikely(!m_segment->fits(*hdr))) {
+		m_segment = NULLPTR;
+	}
 
 	ExtendedVersion::Overlay overlay_sz;
 	if(unlikely(!read_num(&(overlay_sz), errtext))) {
@@ -85,23 +89,36 @@ GCC_DIAG_ON(sign-conversion)
 		hdr->addOverlay(OverlayIdent(path.c_str(), ov.c_str()));
 	}
 
-	if(likely(hdr->version >= 36)) {
-		if(unlikely(!read_hash(&(hdr->eapi_hash), errtext))) {
+	if(m_segment != NULLPTR) {
+		// The segment has the decoded hashes
+		m_segment->get_table(DBSegment::TABLE_EAPI, &(hdr->eapi_hash));
+		m_segment->get_table(DBSegment::TABLE_LICENSE, &(hdr->license_hash));
+		m_segment->get_table(DBSegment::TABLE_KEYWORDS, &(hdr->keywords_hash));
+		m_segment->get_table(DBSegment::TABLE_IUSE, &(hdr->iuse_hash));
+		m_segment->get_table(DBSegment::TABLE_SLOT, &(hdr->slot_hash));
+		if(unlikely(!seekabs(m_segment->sets_offset(), errtext))) {
+			return false;
+		}
+	} else {
+		if(likely(hdr->version >= 36)) {
+			if(unlikely(!read_hash(&(hdr->eapi_hash), errtext))) {
+				return false;
+			}
+		}
+		if(unlikely(!read_hash(&(hdr->license_hash), errtext))) {
+			return false;
+		}
+		if(unlikely(!read_hash(&(hdr->keywords_hash), errtext))) {
+			return false;
+		}
+		if(unlikely(!read_hash(&(hdr->iuse_hash), errtext))) {
+			return false;
+		}
+		if(unlikely(!read_hash(&(hdr->slot_hash), errtext))) {
 			return false;
 		}
 	}
-	if(unlikely(!read_hash(&(hdr->license_hash), errtext))) {
-		return false;
-	}
-	if(unlikely(!read_hash(&(hdr->keywords_hash), errtext))) {
-		return false;
-	}
-	if(unlikely(!read_hash(&(hdr->iuse_hash), errtext))) {
-		return false;
-	}
-	if(unlikely(!read_hash(&(hdr->slot_hash), errtext))) {
-		return false;
-	}
+	m_sets_offset = tell();
 
 	vector<string>::size_type sets_sz;
 	if(unlikely(!read_num(&sets_sz, errtext))) {
@@ -121,12 +138,27 @@ GCC_DIAG_ON(sign-conversion)
 	}
 	hdr->use_required_use = ((save_bitmask & DBHeader::SAVE_BITMASK_REQUIRED_USE) != DBHeader::SAVE_BITMASK_NONE);
 	hdr->use_src_uri = ((save_bitmask & DBHeader::SAVE_BITMASK_SRC_URI) != DBHeader::SAVE_BITMASK_NONE);
+	hdr->compressed = ((save_bitmask & DBHeader::SAVE_BITMASK_COMPRESSED) != DBHeader::SAVE_BITMASK_NONE);
+#ifndef WITH_ZLIB
+	if(unlikely(hdr->compressed)) {
+		if(errtext != NULLPTR) {
+			*errtext = _("cachefile is compressed, but eix was built without zlib");
+		}
+		return false;
+	}
+#endif
 	if((hdr->use_depend = ((save_bitmask & DBHeader::SAVE_BITMASK_DEP) != DBHeader::SAVE_BITMASK_NONE))) {
 		eix::OffsetType len;
 		if(unlikely(!read_num(&len, errtext))) {
 			return false;
 		}
-		if(Depend::use_depend) {
+		if(Depend::use_depend && (m_segment != NULLPTR) &&
+			m_segment->have_table(DBSegment::TABLE_DEPEND)) {
+			m_segment->get_table(DBSegment::TABLE_DEPEND, &(hdr->depend_hash));
+			if(unlikely(!seekrel(len, errtext))) {
+				return false;
+			}
+		} else if(Depend::use_depend) {
 			if(unlikely(!read_hash(&(hdr->depend_hash), errtext))) {
 				return false;
 			}
@@ -136,6 +168,7 @@ GCC_DIAG_ON(sign-conversion)
 			}
 		}
 	}
+	hdr->share_hashs();
 	return true;
 }
 
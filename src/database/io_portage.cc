@@ -8,16 +8,24 @@
 #include "database/io.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <set>
 #include <string>
 
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
 #include "database/header.h"
 #include "database/package_reader.h"
+#include "eixTk/attribute.h"
 #include "eixTk/auto_array.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
 #include "eixTk/eixint.h"
+#include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/sharedstring.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "portage/basicversion.h"
@@ -29,18 +37,21 @@
 #include "portage/packagetree.h"
 #include "portage/version.h"
 
+using std::set;
 using std::string;
 
-#define WRITE_COUNTER(f) do { \
-	eix::OffsetType counter_save(counter); \
-	counter = 0; \
-	bool counting_save(counting); \
-	counting = true; \
-	f; \
-	counting = counting_save; \
-	eix::OffsetType counter_diff(counter); \
-	counter = counter_save; \
-	if(unlikely(!write_num(counter_diff, errtext))) { \
+/**
+Render f once into a buffer and write its length followed by the buffer
+**/
+#define WRITE_WITH_LENGTH(f) do { \
+	string *wbuf_save(written_to()); \
+	string wbuf; \
+	write_to(&wbuf); \
+	bool wbuf_ok(f); \
+	write_to(wbuf_save); \
+	if(unlikely(!wbuf_ok) || \
+		unlikely(!write_num(wbuf.size(), errtext)) || \
+		unlikely(!write_string_plain(wbuf, errtext))) { \
 		return false; \
 	} \
 } while(0)
@@ -72,11 +83,11 @@ bool Database::read_iuse(const StringHash& hash, IUseSet *iuse, string *errtext)
 		return false;
 	}
 	for(; e; --e) {
-		string s;
-		if(unlikely(!read_hash_string(hash, &s, errtext))) {
+		const string *s;
+		if(unlikely(!read_hash_ref(hash, &s, errtext))) {
 			return false;
 		}
-		iuse->insert_fast(s);
+		iuse->insert_fast(*s);
 	}
 	return true;
 }
@@ -84,9 +95,9 @@ bool Database::read_iuse(const StringHash& hash, IUseSet *iuse, string *errtext)
 bool Database::read_version(Version *v, const DBHeader& hdr, string *errtext) {
 	// read EAPI
 	if(likely(hdr.version >= 36)) {
-		string eapi;
-		if(likely(read_hash_string(hdr.eapi_hash, &eapi, errtext))) {
-			v->eapi.assign(eapi);
+		const string *eapi;
+		if(likely(read_hash_ref(hdr.eapi_hash, &eapi, errtext))) {
+			v->eapi.assign(*eapi);
 		} else {
 			return false;
 		}
@@ -104,7 +115,7 @@ bool Database::read_version(Version *v, const DBHeader& hdr, string *errtext) {
 	if(unlikely(!read_num(&(v->restrictFlags), errtext))) {
 		return false;
 	}
-	if(unlikely(!read_hash_words(hdr.keywords_hash, &(v->full_keywords), errtext))) {
+	if(unlikely(!read_hash_words(hdr.keywords_shared, &(v->full_keywords), errtext))) {
 		return false;
 	}
 
@@ -122,11 +133,12 @@ bool Database::read_version(Version *v, const DBHeader& hdr, string *errtext) {
 		v->m_parts.PUSH_BACK(MOVE(b));
 	}
 
-	string fullslot;
-	if(unlikely(!read_hash_string(hdr.slot_hash, &fullslot, errtext))) {
+	StringHash::size_type slot;
+	if(unlikely(!read_hash_index(hdr.slot_shared.size(), &slot, errtext))) {
 		return false;
 	}
-	v->set_slotname(fullslot);
+	v->slotname = hdr.slot_shared[slot].first;
+	v->subslotname = hdr.slot_shared[slot].second;
 	if(unlikely(!read_num(&(v->overlay_key), errtext))) {
 		return false;
 	}
@@ -139,7 +151,7 @@ bool Database::read_version(Version *v, const DBHeader& hdr, string *errtext) {
 	}
 	if(hdr.use_required_use) {
 		if(Version::use_required_use) {
-			if(unlikely(!read_hash_words(hdr.iuse_hash, &(v->required_use), errtext))) {
+			if(unlikely(!read_hash_words(hdr.iuse_shared, &(v->required_use), errtext))) {
 				return false;
 			}
 		} else if(unlikely(!read_hash_words(errtext))) {
@@ -201,7 +213,7 @@ bool Database::write_version(const Version *v, const DBHeader& hdr, string *errt
 	}
 
 	// write full keywords
-	if(unlikely(!write_hash_words(hdr.keywords_hash, v->get_full_keywords(), errtext))) {
+	if(unlikely(!write_hash_words(hdr.keywords_hash, v->full_keywords, errtext))) {
 		return false;
 	}
 
@@ -232,10 +244,7 @@ bool Database::write_version(const Version *v, const DBHeader& hdr, string *errt
 		}
 	}
 	if(hdr.use_depend) {
-		WRITE_COUNTER(write_depend(v->depend, hdr, NULLPTR));
-		if(unlikely(!write_depend(v->depend, hdr, errtext))) {
-			return false;
-		}
+		WRITE_WITH_LENGTH(write_depend(v->depend, hdr, errtext));
 	}
 	if(hdr.use_src_uri) {
 		if(unlikely(!write_string(v->src_uri, errtext))) {
@@ -251,23 +260,23 @@ bool Database::read_depend(Depend *dep, const DBHeader& hdr, string *errtext) {
 		return false;
 	}
 	if(Depend::use_depend) {
-		if(unlikely(!read_hash_words(hdr.depend_hash, &(dep->m_depend), errtext))) {
+		if(unlikely(!read_hash_words(hdr.depend_shared, &(dep->m_depend), errtext))) {
 			return false;
 		}
-		if(unlikely(!read_hash_words(hdr.depend_hash, &(dep->m_rdepend), errtext))) {
+		if(unlikely(!read_hash_words(hdr.depend_shared, &(dep->m_rdepend), errtext))) {
 			return false;
 		}
-		if(unlikely(!read_hash_words(hdr.depend_hash, &(dep->m_pdepend), errtext))) {
+		if(unlikely(!read_hash_words(hdr.depend_shared, &(dep->m_pdepend), errtext))) {
 			return false;
 		}
 		if(hdr.version <= 31) {
 			dep->m_bdepend.clear();
-		} else if(unlikely(!read_hash_words(hdr.depend_hash, &(dep->m_bdepend), errtext))) {
+		} else if(unlikely(!read_hash_words(hdr.depend_shared, &(dep->m_bdepend), errtext))) {
 			return false;
 		}
 		if(hdr.version <= 38) {
 			dep->m_idepend.clear();
-		} else if(unlikely(!read_hash_words(hdr.depend_hash, &(dep->m_idepend), errtext))) {
+		} else if(unlikely(!read_hash_words(hdr.depend_shared, &(dep->m_idepend), errtext))) {
 			return false;
 		}
 		dep->obsolete = (hdr.version <= 32);
@@ -290,15 +299,114 @@ bool Database::write_depend(const Depend& dep, const DBHeader& hdr, string *errt
 		likely(write_hash_words(hdr.depend_hash, dep.m_idepend, errtext)));
 }
 
-bool Database::read_category_header(string *name, eix::Treesize *h, string *errtext) {
-	return (likely(read_string(name, errtext)) &&
-		likely(read_num(h, errtext)));
+bool Database::read_category_header(string *name, eix::Treesize *h, set<ExtendedVersion::Overlay> *overlays, eix::OffsetType *end, const DBHeader& hdr, string *errtext) {
+	if(unlikely(!read_string(name, errtext))) {
+		return false;
+	}
+	overlays->clear();
+	if(hdr.version <= 39) {
+		*end = 0;
+		return read_num(h, errtext);
+	}
+	ExtendedVersion::Overlay e;
+	if(unlikely(!read_num(&e, errtext))) {
+		return false;
+	}
+	for(; likely(e != 0); --e) {
+		ExtendedVersion::Overlay key;
+		if(unlikely(!read_num(&key, errtext))) {
+			return false;
+		}
+		overlays->INSERT(key);
+	}
+	eix::OffsetType len;
+	if(unlikely(!read_num(&len, errtext))) {
+		return false;
+	}
+	*end = tell() + len;
+	if(unlikely(!read_num(h, errtext))) {
+		return false;
+	}
+	if(!hdr.compressed) {
+		return true;
+	}
+	string::size_type size;
+	if(unlikely(!read_num(&size, errtext))) {
+		return false;
+	}
+	begin_block(*end - tell(), size);
+	return true;
+}
+
+bool Database::write_category_header(const string& name, const set<ExtendedVersion::Overlay>& overlays, string *errtext) {
+	if(unlikely(!write_string(name, errtext))) {
+		return false;
+	}
+	if(unlikely(!write_num(overlays.size(), errtext))) {
+		return false;
+	}
+	for(set<ExtendedVersion::Overlay>::const_iterator it(overlays.begin());
+		likely(it != overlays.end()); ++it) {
+		if(unlikely(!write_num(*it, errtext))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Database::write_category(const Category& cat, const DBHeader& hdr, string *errtext) {
+	if(unlikely(!write_num(eix::Treesize(cat.size()), errtext))) {
+		return false;
+	}
+	for(Category::const_iterator p(cat.begin()); likely(p != cat.end()); ++p) {
+		// write package to fp
+		if(unlikely(!write_package(**p, hdr, errtext))) {
+			return false;
+		}
+	}
+	return true;
 }
 
-bool Database::write_category_header(const string& name, eix::Treesize size, string *errtext) {
-	return (likely(write_string(name, errtext)) &&
-		likely(write_num(size, errtext)));
+#ifdef WITH_ZLIB
+bool Database::write_category_compressed(const Category& cat, const DBHeader& hdr, string *errtext) {
+	string *wbuf_save(written_to());
+	string raw;
+	write_to(&raw);
+	for(Category::const_iterator p(cat.begin()); likely(p != cat.end()); ++p) {
+		if(unlikely(!write_package(**p, hdr, errtext))) {
+			write_to(wbuf_save);
+			return false;
+		}
+	}
+	uLongf zlen(compressBound(raw.size()));
+	string zdata;
+	zdata.resize(zlen);
+	if(unlikely(compress(reinterpret_cast<Bytef *>(&(zdata[0])), &zlen,
+		reinterpret_cast<const Bytef *>(raw.data()), raw.size()) != Z_OK)) {
+		write_to(wbuf_save);
+		*errtext = _("error while compressing database");
+		return false;
+	}
+	zdata.resize(zlen);
+	// The package count and the uncompressed size precede the block
+	string head;
+	write_to(&head);
+	if(unlikely(!write_num(eix::Treesize(cat.size()), errtext)) ||
+		unlikely(!write_num(raw.size(), errtext))) {
+		write_to(wbuf_save);
+		return false;
+	}
+	write_to(wbuf_save);
+	return (likely(write_num(head.size() + zdata.size(), errtext)) &&
+		likely(write_string_plain(head, errtext)) &&
+		likely(write_string_plain(zdata, errtext)));
+}
+#else  /* WITH_ZLIB */
+bool Database::write_category_compressed(const Category& /* cat */, const DBHeader& /* hdr */, string *errtext) {
+	*errtext = _("cannot write compressed database without zlib");
+	return false;
 }
+#endif  /* WITH_ZLIB */
 
 bool Database::write_package_pure(const Package& pkg, const DBHeader& hdr, string *errtext) {
 	if(unlikely(!write_string(pkg.name, errtext))) {
@@ -328,8 +436,8 @@ bool Database::write_package_pure(const Package& pkg, const DBHeader& hdr, strin
 }
 
 bool Database::write_package(const Package& pkg, const DBHeader& hdr, string *errtext) {
-	WRITE_COUNTER(write_package_pure(pkg, hdr, NULLPTR));
-	return write_package_pure(pkg, hdr, errtext);
+	WRITE_WITH_LENGTH(write_package_pure(pkg, hdr, errtext));
+	return true;
 }
 
 bool Database::write_hash(const StringHash& hash, string *errtext) {
@@ -345,6 +453,15 @@ bool Database::write_hash(const StringHash& hash, string *errtext) {
 	return true;
 }
 
+ATTRIBUTE_NONNULL_ static void hash_words(StringHash *hash, const SharedWords& words);
+
+static void hash_words(StringHash *hash, const SharedWords& words) {
+	const SharedWords::WordList& list(words.words());
+	for(SharedWords::WordList::const_iterator i(list.begin()); likely(i != list.end()); ++i) {
+		hash->hash_string(i->get());
+	}
+}
+
 void Database::prep_header_hashs(DBHeader *hdr, const PackageTree& tree) {
 	hdr->eapi_hash.init(true);
 	hdr->license_hash.init(true);
@@ -365,19 +482,19 @@ void Database::prep_header_hashs(DBHeader *hdr, const PackageTree& tree) {
 			hdr->license_hash.hash_string(p->licenses);
 			for(Package::iterator v(p->begin()); likely(v != p->end()); ++v) {
 				hdr->eapi_hash.hash_string(v->eapi.get());
-				hdr->keywords_hash.hash_words(v->get_full_keywords());
+				hash_words(&(hdr->keywords_hash), v->full_keywords);
 				hdr->iuse_hash.hash_words(v->iuse.asVector());
 				if(use_required_use) {
-					hdr->iuse_hash.hash_words(v->required_use);
+					hash_words(&(hdr->iuse_hash), v->required_use);
 				}
 				hdr->slot_hash.hash_string(v->get_shortfullslot());
 				if(use_dep) {
 					const Depend& dep(v->depend);
-					hdr->depend_hash.hash_words(dep.m_depend);
-					hdr->depend_hash.hash_words(dep.m_rdepend);
-					hdr->depend_hash.hash_words(dep.m_pdepend);
-					hdr->depend_hash.hash_words(dep.m_bdepend);
-					hdr->depend_hash.hash_words(dep.m_idepend);
+					hash_words(&(hdr->depend_hash), dep.m_depend);
+					hash_words(&(hdr->depend_hash), dep.m_rdepend);
+					hash_words(&(hdr->depend_hash), dep.m_pdepend);
+					hash_words(&(hdr->depend_hash), dep.m_bdepend);
+					hash_words(&(hdr->depend_hash), dep.m_idepend);
 				}
 			}
 		}
@@ -451,30 +568,40 @@ bool Database::write_header(const DBHeader& hdr, string *errtext) {
 	if(hdr.use_required_use) {
 		save_bitmask |= DBHeader::SAVE_BITMASK_REQUIRED_USE;
 	}
+	if(hdr.compressed) {
+		save_bitmask |= DBHeader::SAVE_BITMASK_COMPRESSED;
+	}
 	if(unlikely(!write_num(save_bitmask, errtext))) {
 		return false;
 	}
 	if(!hdr.use_depend) {
 		return true;
 	}
-	WRITE_COUNTER(write_hash(hdr.depend_hash, NULLPTR));
-	return write_hash(hdr.depend_hash, errtext);
+	WRITE_WITH_LENGTH(write_hash(hdr.depend_hash, errtext));
+	return true;
 }
 
 bool Database::write_packagetree(const PackageTree& tree, const DBHeader& hdr, string *errtext) {
 	for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
-		Category *ci(c->second);
+		const Category *ci(c->second);
+		// Collect the overlays for the category index
+		set<ExtendedVersion::Overlay> overlays;
+		for(Category::const_iterator p(ci->begin()); likely(p != ci->end()); ++p) {
+			for(Package::const_iterator v(p->begin()); likely(v != p->end()); ++v) {
+				overlays.INSERT(v->overlay_key);
+			}
+		}
 		// Write category-header followed by a list of the packages.
-		if(unlikely(!write_category_header(c->first, eix::Treesize(ci->size()), errtext))) {
+		if(unlikely(!write_category_header(c->first, overlays, errtext))) {
 			return false;
 		}
-
-		for(Category::iterator p(ci->begin()); likely(p != ci->end()); ++p) {
-			// write package to fp
-			if(unlikely(!write_package(**p, hdr, errtext))) {
+		if(hdr.compressed) {
+			if(unlikely(!write_category_compressed(*ci, hdr, errtext))) {
 				return false;
 			}
+			continue;
 		}
+		WRITE_WITH_LENGTH(write_category(*ci, hdr, errtext));
 	}
 	return true;
 }
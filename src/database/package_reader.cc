@@ -11,6 +11,7 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include "database/io.h"
+#include "database/segment.h"
 #include "eixTk/attribute.h"
 #include "eixTk/eixint.h"
 #include "eixTk/likely.h"
@@ -19,6 +20,20 @@
 #include "portage/package.h"
 #include "portage/version.h"
 
+bool PackageReader::collect_stats = false;
+eix::UNumber PackageReader::decoded[ALL + 1];
+eix::UNumber PackageReader::categories_skipped = 0;
+eix::OffsetType PackageReader::bytes_decoded = 0;
+eix::OffsetType PackageReader::bytes_skipped = 0;
+
+PackageReader::PackageReader(Database *db, const DBHeader& hdr, PortageSettings *ps)
+	: m_db(db), m_segment(db->m_segment), m_frames(hdr.size), m_cat_size(0), m_cat_end(0), m_new_cat(false), m_len_pending(false), m_seek_pending(false), m_pkg(NULLPTR), header(&hdr), m_portagesettings(ps), m_error(false) {
+}
+
+PackageReader::PackageReader(Database *db, const DBHeader& hdr)
+	: m_db(db), m_segment(db->m_segment), m_frames(hdr.size), m_cat_size(0), m_cat_end(0), m_new_cat(false), m_len_pending(false), m_seek_pending(false), m_pkg(NULLPTR), header(&hdr), m_portagesettings(NULLPTR), m_error(false) {
+}
+
 PackageReader::~PackageReader() {
 	delete m_pkg;
 }
@@ -28,6 +43,20 @@ bool PackageReader::read(Attributes need) {
 		return true;
 	}
 
+	if(unlikely(!read_length())) {
+		return false;
+	}
+	if(unlikely(m_seek_pending)) {
+		m_seek_pending = false;
+		if(unlikely(!m_db->seekabs(m_data, &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+	}
+	eix::OffsetType start(0);
+	if(unlikely(collect_stats)) {
+		start = m_db->tell();
+	}
 	switch(m_have) {
 		case NONE:
 			if(unlikely(!m_db->read_string(&(m_pkg->name), &m_errtext))) {
@@ -91,13 +120,37 @@ bool PackageReader::read(Attributes need) {
 		// case ALL:
 			break;
 	}
+	if(unlikely(collect_stats)) {
+		bytes_decoded += m_db->tell() - start;
+		++decoded[need];
+	}
 	m_have = need;
 	return true;
 }
 
+bool PackageReader::read_length() {
+	if(likely(!m_len_pending)) {
+		return true;
+	}
+	m_len_pending = false;
+	eix::OffsetType len;
+	if(unlikely(!m_db->read_num(&len, &m_errtext))) {
+		m_error = true;
+		return false;
+	}
+	m_next = m_db->tell() + len;
+	return true;
+}
+
 bool PackageReader::skip() {
 	// only seek if needed
 	if(m_have != ALL) {
+		if(unlikely(!read_length())) {
+			return false;
+		}
+		if(unlikely(collect_stats)) {
+			bytes_skipped += m_next - m_db->tell();
+		}
 		if(unlikely(!m_db->seekabs(m_next, &m_errtext))) {
 			m_error = true;
 			return false;
@@ -119,29 +172,79 @@ Package *PackageReader::release() {
 	return r;
 }
 
+bool PackageReader::skip_category() {
+	if(likely(m_cat_end != 0)) {
+		// Jump over the rest of the category without inflating its block
+		m_db->discard_block();
+		if(unlikely(collect_stats)) {
+			bytes_skipped += m_cat_end - m_db->tell();
+		}
+		if(unlikely(!m_db->seekabs(m_cat_end, &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+		m_len_pending = false;
+		m_next = m_cat_end;
+	} else {
+		// Old database format: follow the package offsets
+		if(unlikely(!read_length())) {
+			return false;
+		}
+		for(; m_cat_size != 0; --m_cat_size) {
+			eix::OffsetType len;
+			if(unlikely((!m_db->seekabs(m_next, &m_errtext)) ||
+				(!m_db->read_num(&len, &m_errtext)))) {
+				m_error = true;
+				return false;
+			}
+			m_next = m_db->tell() + len;
+		}
+	}
+	if(unlikely(collect_stats)) {
+		++categories_skipped;
+	}
+	m_cat_size = 0;
+	m_have = NONE;
+	return true;
+}
+
 bool PackageReader::next() {
-	if(unlikely(m_cat_size-- == 0)) {
-		if(unlikely(m_frames-- == 0)) {
+	m_new_cat = false;
+	while(unlikely(m_cat_size == 0)) {
+		if(unlikely(m_frames == 0)) {
 			return false;
 		}
-		if(unlikely(!m_db->read_category_header(&m_cat_name, &m_cat_size, &m_errtext))) {
+		--m_frames;
+		if(unlikely(!m_db->read_category_header(&m_cat_name, &m_cat_size,
+			&m_cat_overlays, &m_cat_end, *header, &m_errtext))) {
 			m_error = true;
 			return false;
 		}
-		return next();
+		m_new_cat = true;
+		if((m_segment != NULLPTR) &&
+			unlikely(!m_segment->check_category(header->size - m_frames - 1,
+				m_cat_name, m_cat_size, &m_segment_package))) {
+			m_segment = NULLPTR;
+		}
 	}
+	--m_cat_size;
 
-	eix::OffsetType len;
-	if(unlikely(!m_db->read_num(&len, &m_errtext))) {
-		m_error = true;
-		return false;
-	}
-	m_next = m_db->tell() + len;
 	m_have = NONE;
 	delete m_pkg;
 	m_pkg = new Package;
 	m_pkg->category = m_cat_name;
+	if(m_segment != NULLPTR) {
+		// The file is not touched unless more than the name is needed
+		m_segment->get_package(m_segment_package++, &(m_pkg->name), &m_data, &m_next);
+		m_len_pending = false;
+		m_seek_pending = true;
+		m_have = NAME;
+		return true;
+	}
 
+	// Reading the length would already inflate a compressed block
+	m_len_pending = true;
+	m_seek_pending = false;
 	return true;
 }
 
@@ -151,7 +254,8 @@ bool PackageReader::nextCategory() {
 		return false;
 	}
 
-	if(likely(m_db->read_category_header(&m_cat_name, &m_cat_size, &m_errtext))) {
+	if(likely(m_db->read_category_header(&m_cat_name, &m_cat_size,
+		&m_cat_overlays, &m_cat_end, *header, &m_errtext))) {
 		return true;
 	}
 	m_error = true;
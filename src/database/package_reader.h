@@ -15,12 +15,15 @@
 #include <sys/types.h>
 
 #include <memory>
+#include <set>
 #include <string>
 
 #include "database/header.h"
 #include "eixTk/eixint.h"
 #include "eixTk/null.h"
+#include "portage/extendedversion.h"
 
+class DBSegment;
 class Database;
 class DBHeader;
 class Package;
@@ -30,6 +33,8 @@ class PortageSettings;
 Forward-iterate for packages stored in the cachefile
 **/
 class PackageReader {
+		friend class DBSegment;
+
 	public:
 		enum Attributes {
 			NONE = 0,
@@ -41,13 +46,9 @@ class PackageReader {
 		Initialize with file-stream and number of packages.
 		@arg ps is used to define the local package sets while version reading
 		**/
-		PackageReader(Database *db, const DBHeader& hdr, PortageSettings *ps)
-			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(ps), m_error(false) {
-		}
+		PackageReader(Database *db, const DBHeader& hdr, PortageSettings *ps);
 
-		PackageReader(Database *db, const DBHeader& hdr)
-			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(NULLPTR), m_error(false) {
-		}
+		PackageReader(Database *db, const DBHeader& hdr);
 
 		~PackageReader();
 
@@ -107,17 +108,76 @@ class PackageReader {
 			return m_cat_name;
 		}
 
+		/**
+		@return true if the current package is the first of its category
+		**/
+		bool new_category() const {
+			return m_new_cat;
+		}
+
+		/**
+		@return false only if the category index guarantees that
+		no version of the current category is from overlay key
+		**/
+		bool category_has_overlay(ExtendedVersion::Overlay key) const {
+			return ((m_cat_end == 0) ||
+				(m_cat_overlays.find(key) != m_cat_overlays.end()));
+		}
+
+		/**
+		Skip the remainder of the current category.
+		If the database knows where the category ends, the file pointer is
+		moved there without inflating a compressed block; otherwise, the
+		subsequent skip() moves it. The current package must not be read anymore.
+		**/
+		bool skip_category();
+
 		const char *get_errtext() const {
 			return (m_error ? m_errtext.c_str() : NULLPTR);
 		}
 
+		/**
+		Statistics for eix --stats, summed over all readers.
+		They are only collected if collect_stats is true.
+		decoded[a] counts how often reading up to attribute a was needed.
+		**/
+		static bool collect_stats;
+		static eix::UNumber decoded[ALL + 1];
+		static eix::UNumber categories_skipped;
+		static eix::OffsetType bytes_decoded, bytes_skipped;
+
+	private:
+		bool read_length();
+
 	protected:
 		Database         *m_db;
 
+		/**
+		If not NULLPTR, the names and offsets of the packages are taken
+		from this segment; m_segment_package is the number of the next one
+		**/
+		const DBSegment  *m_segment;
+		eix::Treesize     m_segment_package;
+
 		eix::Treesize     m_frames;
 		eix::Treesize     m_cat_size;
 		std::string       m_cat_name;
+		std::set<ExtendedVersion::Overlay> m_cat_overlays;
+		eix::OffsetType   m_cat_end;
+		bool              m_new_cat;
+
+		/**
+		The length of the current package is not read yet
+		(so that skip_category() need not touch a compressed block)
+		**/
+		bool              m_len_pending;
 
+		/**
+		The name is taken from the segment: before reading further,
+		the file pointer must be moved to m_data
+		**/
+		bool              m_seek_pending;
+		off_t             m_data;
 		off_t             m_next;
 		Attributes        m_have;
 		Package          *m_pkg;
@@ -0,0 +1,200 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "database/segment.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "database/header.h"
+#include "database/io.h"
+#include "eixTk/diagnostics.h"
+#include "eixTk/eixint.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringutils.h"
+
+using std::string;
+
+void DBSegment::set_identity(Word *head, const struct stat& st) {
+	head[HEAD_DEV] = static_cast<Word>(st.st_dev);
+	head[HEAD_INO] = static_cast<Word>(st.st_ino);
+	head[HEAD_SIZE] = st.st_size;
+	head[HEAD_MTIME] = static_cast<Word>(st.st_mtime);
+	head[HEAD_CTIME] = static_cast<Word>(st.st_ctime);
+}
+
+bool DBSegment::open(const char *name, const File& db) {
+	close();
+	struct stat st;
+	if(unlikely(!db.get_stat(&st))) {
+		return false;
+	}
+	int fd(::open(name, O_RDONLY));
+	if(fd < 0) {
+		return false;
+	}
+	struct stat seg;
+	if(unlikely(fstat(fd, &seg) != 0) ||
+		unlikely(seg.st_size < static_cast<off_t>(HEAD_WORDS * sizeof(Word)))) {
+		::close(fd);
+		return false;
+	}
+GCC_DIAG_OFF(sign-conversion)
+	void *buffer(mmap(NULLPTR, seg.st_size, PROT_READ, MAP_SHARED, fd, 0));
+GCC_DIAG_ON(sign-conversion)
+	::close(fd);
+GCC_DIAG_OFF(old-style-cast)
+	if(unlikely(buffer == MAP_FAILED)) {
+GCC_DIAG_ON(old-style-cast)
+		return false;
+	}
+	m_map = static_cast<const Word *>(buffer);
+	m_words = seg.st_size / static_cast<Word>(sizeof(Word));
+	m_strings_size = 0;
+	Word head[HEAD_WORDS];
+	set_identity(head, st);
+	Word strings(m_map[HEAD_STRINGS]);
+	if(likely(m_map[HEAD_MAGIC] == magic) &&
+		likely(m_map[HEAD_FORMAT] == ((format << 8) | static_cast<Word>(sizeof(Word)))) &&
+		likely(m_map[HEAD_DEV] == head[HEAD_DEV]) &&
+		likely(m_map[HEAD_INO] == head[HEAD_INO]) &&
+		likely(m_map[HEAD_SIZE] == head[HEAD_SIZE]) &&
+		likely(m_map[HEAD_MTIME] == head[HEAD_MTIME]) &&
+		likely(m_map[HEAD_CTIME] == head[HEAD_CTIME]) &&
+		likely(strings >= HEAD_WORDS) && likely(strings < m_words)) {
+		m_strings = reinterpret_cast<const char *>(m_map + strings);
+		m_strings_size = seg.st_size - strings * static_cast<Word>(sizeof(Word));
+		// The last string must be terminated
+		if(likely(m_strings[m_strings_size - 1] == '\0') && likely(validate())) {
+			return true;
+		}
+	}
+	close();
+	return false;
+}
+
+void DBSegment::close() {
+	if(m_map == NULLPTR) {
+		return;
+	}
+GCC_DIAG_OFF(sign-conversion)
+	munmap(const_cast<Word *>(m_map), m_words * sizeof(Word));
+GCC_DIAG_ON(sign-conversion)
+	m_map = NULLPTR;
+	m_words = 0;
+}
+
+/**
+@return true if count entries of size words at index are inside the words
+**/
+bool DBSegment::valid_range(Word index, Word count, Word size) const {
+	Word strings(m_map[HEAD_STRINGS]);
+	return ((index >= HEAD_WORDS) && (index <= strings) && (count >= 0) &&
+		(count <= (strings - index) / size));
+}
+
+/**
+Check all offsets once, so that the accessors need no checks
+**/
+bool DBSegment::validate() const {
+	for(Word t(0); likely(t != TABLE_COUNT); ++t) {
+		Word index(m_map[HEAD_TABLES + t]);
+		if(index == 0) {
+			continue;
+		}
+		if(unlikely(!valid_range(index, 1, 1))) {
+			return false;
+		}
+		Word count(m_map[index++]);
+		if(unlikely(!valid_range(index, count, 1))) {
+			return false;
+		}
+		for(; likely(count != 0); --count) {
+			if(unlikely(!valid_string(m_map[index++]))) {
+				return false;
+			}
+		}
+	}
+	Word packages(m_map[HEAD_PACKAGES]);
+	Word package_count(m_map[HEAD_PACKAGE_COUNT]);
+	if(unlikely(!valid_range(packages, package_count, package_words))) {
+		return false;
+	}
+	for(Word i(packages), end(packages + package_count * package_words);
+		likely(i != end); i += package_words) {
+		if(unlikely(!valid_string(m_map[i])) ||
+			unlikely(m_map[i + 1] < 0) || unlikely(m_map[i + 2] < m_map[i + 1])) {
+			return false;
+		}
+	}
+	Word categories(m_map[HEAD_CATINDEX]);
+	Word category_count(m_map[HEAD_CATEGORIES]);
+	if(unlikely(!valid_range(categories, category_count, category_words))) {
+		return false;
+	}
+	for(Word i(categories), end(categories + category_count * category_words);
+		likely(i != end); i += category_words) {
+		Word first(m_map[i + 1]);
+		Word count(m_map[i + 2]);
+		if(unlikely(!valid_string(m_map[i])) || unlikely(first < 0) ||
+			unlikely(count < 0) || unlikely(count > package_count - first)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DBSegment::fits(const DBHeader& hdr) const {
+	return ((m_map[HEAD_VERSION] == static_cast<Word>(hdr.version)) &&
+		(m_map[HEAD_CATEGORIES] == static_cast<Word>(hdr.size)));
+}
+
+eix::OffsetType DBSegment::sets_offset() const {
+	return m_map[HEAD_SETS];
+}
+
+bool DBSegment::have_table(Table table) const {
+	return (m_map[table_word(table)] != 0);
+}
+
+void DBSegment::get_table(Table table, StringHash *hash) const {
+	hash->init(false);
+	Word index(m_map[table_word(table)]);
+	if(index != 0) {
+		for(Word count(m_map[index++]); likely(count != 0); --count) {
+			hash->store_string(string_at(m_map[index++]));
+		}
+	}
+	hash->finalize();
+}
+
+bool DBSegment::check_category(eix::Catsize i, const string& name, eix::Treesize count, eix::Treesize *first) const {
+	if(unlikely(static_cast<Word>(i) >= m_map[HEAD_CATEGORIES])) {
+		return false;
+	}
+	const Word *category(m_map + m_map[HEAD_CATINDEX] + static_cast<Word>(i) * category_words);
+	if(unlikely(category[2] != static_cast<Word>(count)) ||
+		unlikely(name != string_at(category[0]))) {
+		return false;
+	}
+	*first = static_cast<eix::Treesize>(category[1]);
+	return true;
+}
+
+void DBSegment::get_package(eix::Treesize j, string *name, eix::OffsetType *data, eix::OffsetType *end) const {
+	const Word *package(m_map + m_map[HEAD_PACKAGES] + static_cast<Word>(j) * package_words);
+	name->assign(string_at(package[0]));
+	*data = package[1];
+	*end = package[2];
+}
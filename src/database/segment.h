@@ -0,0 +1,153 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_DATABASE_SEGMENT_H_
+#define SRC_DATABASE_SEGMENT_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+
+#include "database/header.h"
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/null.h"
+#include "eixTk/stringutils.h"
+
+class File;
+struct stat;
+
+/**
+An index of an eix database which is written by eix-update to a separate
+file and mapped read-only by eix, so that all eix processes share its pages.
+It contains the string tables of the database header, an index of the
+categories, and for each package its name and the offsets of its data in
+the database. With it, eix need not decode the string tables, and packages
+can be matched by name without reading (or inflating) their categories.
+All references in the segment are offsets, so it can be mapped anywhere.
+The segment is only used if it was made for the currently opened database.
+**/
+class DBSegment {
+	public:
+		/**
+		The string tables of DBHeader in the segment
+		**/
+		enum Table {
+			TABLE_EAPI, TABLE_LICENSE, TABLE_KEYWORDS, TABLE_IUSE,
+			TABLE_SLOT, TABLE_DEPEND,
+			TABLE_COUNT
+		};
+
+		DBSegment() : m_map(NULLPTR), m_words(0), m_strings(NULLPTR), m_strings_size(0) {
+		}
+
+		~DBSegment() {
+			close();
+		}
+
+		/**
+		Map the segment name if it was made for the opened database db
+		@return false if there is no such segment
+		**/
+		ATTRIBUTE_NONNULL_ bool open(const char *name, const File& db);
+
+		void close();
+
+		/**
+		Write the segment name for the database dbname
+		**/
+		ATTRIBUTE_NONNULL((1, 2)) static bool write(const char *name, const char *dbname, std::string *errtext);
+
+		/**
+		@return true if hdr has the version and size of the indexed database
+		**/
+		ATTRIBUTE_PURE bool fits(const DBHeader& hdr) const;
+
+		/**
+		@return the database offset of the world sets (after the hashes
+		which precede them)
+		**/
+		ATTRIBUTE_PURE eix::OffsetType sets_offset() const;
+
+		/**
+		@return false if the table was not stored
+		**/
+		ATTRIBUTE_PURE bool have_table(Table table) const;
+
+		ATTRIBUTE_NONNULL_ void get_table(Table table, StringHash *hash) const;
+
+		/**
+		@return true if category i of the database has the name and count
+		packages. Then *first is the number of its first package.
+		**/
+		ATTRIBUTE_NONNULL_ bool check_category(eix::Catsize i, const std::string& name, eix::Treesize count, eix::Treesize *first) const;
+
+		/**
+		Get the name of package number j, the offset of its data after
+		the name, and the offset after its data
+		**/
+		ATTRIBUTE_NONNULL_ void get_package(eix::Treesize j, std::string *name, eix::OffsetType *data, eix::OffsetType *end) const;
+
+	private:
+		typedef eix::OffsetType Word;
+
+		/**
+		The words at the beginning of the segment. Each table is stored as
+		the number of strings followed by their offsets; the category index
+		as name, first package, and number of packages for each category;
+		the packages as name, data offset, and end offset for each package.
+		**/
+		enum Head {
+			HEAD_MAGIC, HEAD_FORMAT,
+			HEAD_DEV, HEAD_INO, HEAD_SIZE, HEAD_MTIME, HEAD_CTIME,
+			HEAD_VERSION, HEAD_CATEGORIES, HEAD_SETS,
+			HEAD_TABLES,
+			HEAD_CATINDEX = HEAD_TABLES + TABLE_COUNT,
+			HEAD_PACKAGES, HEAD_PACKAGE_COUNT, HEAD_STRINGS,
+			HEAD_WORDS
+		};
+		static CONSTEXPR const Word
+			magic = 0x65697853,  // "eixS"
+			format = 1;
+		static CONSTEXPR const Word
+			category_words = 3,
+			package_words = 3;
+
+		/**
+		Store the identity of the database file in the head
+		**/
+		ATTRIBUTE_NONNULL_ static void set_identity(Word *head, const struct stat& st);
+
+		static Word table_word(Table table) {
+			return (HEAD_TABLES + static_cast<Word>(table));
+		}
+
+		const Word *m_map;
+		Word m_words;
+
+		/**
+		The strings are NUL-terminated and follow the words
+		**/
+		const char *m_strings;
+		Word m_strings_size;
+
+		ATTRIBUTE_PURE bool valid_range(Word index, Word count, Word size) const;
+		bool valid_string(Word offset) const {
+			return ((offset >= 0) && (offset < m_strings_size));
+		}
+		ATTRIBUTE_PURE bool validate() const;
+
+		const char *string_at(Word offset) const {
+			return m_strings + offset;
+		}
+
+		DBSegment(const DBSegment& s) ASSIGN_DELETE;
+		DBSegment& operator=(const DBSegment& s) ASSIGN_DELETE;
+};
+
+#endif  // SRC_DATABASE_SEGMENT_H_
@@ -0,0 +1,177 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "database/segment.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "database/header.h"
+#include "database/io.h"
+#include "database/package_reader.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringutils.h"
+#include "portage/package.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+/**
+The data of a segment while it is written
+**/
+class SegmentData {
+	public:
+		typedef eix::OffsetType Word;
+
+		vector<Word> words;
+		string strings;
+
+		SegmentData() : strings(1, '\0') {
+		}
+
+		/**
+		@return the offset of s in the strings
+		**/
+		Word add_string(const string& s);
+
+		/**
+		Append the table and @return its index
+		**/
+		Word add_table(const StringHash& hash);
+
+		bool write(const char *name) const;
+
+	private:
+		typedef map<string, Word> Offsets;
+		Offsets offsets;
+};
+
+SegmentData::Word SegmentData::add_string(const string& s) {
+	if(s.empty()) {
+		return 0;
+	}
+	Offsets::const_iterator it(offsets.find(s));
+	if(it != offsets.end()) {
+		return it->second;
+	}
+	Word offset(static_cast<Word>(strings.size()));
+	strings.append(s);
+	strings.append(1, '\0');
+	offsets[s] = offset;
+	return offset;
+}
+
+SegmentData::Word SegmentData::add_table(const StringHash& hash) {
+	Word index(static_cast<Word>(words.size()));
+	words.PUSH_BACK(static_cast<Word>(hash.size()));
+	for(StringHash::const_iterator it(hash.begin()); likely(it != hash.end()); ++it) {
+		words.PUSH_BACK(add_string(*it));
+	}
+	return index;
+}
+
+bool SegmentData::write(const char *name) const {
+	FILE *fp(std::fopen(name, "wb"));
+	if(unlikely(fp == NULLPTR)) {
+		return false;
+	}
+	bool ok((std::fwrite(&(words[0]), sizeof(Word), words.size(), fp) == words.size()) &&
+		(std::fwrite(strings.data(), sizeof(char), strings.size(), fp) == strings.size()));
+	return ((std::fclose(fp) == 0) && ok);
+}
+
+bool DBSegment::write(const char *name, const char *dbname, string *errtext) {
+	Database db;
+	struct stat st;
+	if(unlikely(!db.openread(dbname)) || unlikely(!db.get_stat(&st))) {
+		*errtext = eix::format(_("cannot read %s")) % dbname;
+		return false;
+	}
+	DBHeader hdr;
+	if(unlikely(!db.read_header(&hdr, errtext, 0))) {
+		return false;
+	}
+	SegmentData data;
+	vector<Word>& words(data.words);
+	words.resize(HEAD_WORDS);
+	words[HEAD_MAGIC] = magic;
+	words[HEAD_FORMAT] = ((format << 8) | static_cast<Word>(sizeof(Word)));
+	set_identity(&(words[0]), st);
+	words[HEAD_VERSION] = static_cast<Word>(hdr.version);
+	words[HEAD_CATEGORIES] = static_cast<Word>(hdr.size);
+	words[HEAD_SETS] = db.m_sets_offset;
+	words[table_word(TABLE_EAPI)] = data.add_table(hdr.eapi_hash);
+	words[table_word(TABLE_LICENSE)] = data.add_table(hdr.license_hash);
+	words[table_word(TABLE_KEYWORDS)] = data.add_table(hdr.keywords_hash);
+	words[table_word(TABLE_IUSE)] = data.add_table(hdr.iuse_hash);
+	words[table_word(TABLE_SLOT)] = data.add_table(hdr.slot_hash);
+	// The depend table is only read (and thus stored) if we use it
+	if(hdr.use_depend && !hdr.depend_hash.empty()) {
+		words[table_word(TABLE_DEPEND)] = data.add_table(hdr.depend_hash);
+	}
+
+	// Collect the packages first: only then we know all categories
+	vector<Word> categories(hdr.size * category_words, 0);
+	vector<Word> packages;
+	{
+		PackageReader reader(&db, hdr);
+		while(likely(reader.next())) {
+			if(unlikely(!reader.read(PackageReader::NAME))) {
+				break;
+			}
+			Word package(static_cast<Word>(packages.size() / package_words));
+			if(reader.new_category()) {
+				Word *category(&(categories[(hdr.size - reader.m_frames - 1) * category_words]));
+				category[0] = data.add_string(reader.category());
+				category[1] = package;
+			}
+			++(categories[(hdr.size - reader.m_frames - 1) * category_words + 2]);
+			packages.PUSH_BACK(data.add_string(reader.get()->name));
+			packages.PUSH_BACK(db.tell());
+			packages.PUSH_BACK(reader.m_next);
+			if(unlikely(!reader.skip())) {
+				break;
+			}
+		}
+		const char *err_cstr(reader.get_errtext());
+		if(unlikely(err_cstr != NULLPTR)) {
+			*errtext = err_cstr;
+			return false;
+		}
+	}
+	words[HEAD_CATINDEX] = static_cast<Word>(words.size());
+	words.insert(words.end(), categories.begin(), categories.end());
+	words[HEAD_PACKAGES] = static_cast<Word>(words.size());
+	words[HEAD_PACKAGE_COUNT] = static_cast<Word>(packages.size() / package_words);
+	words.insert(words.end(), packages.begin(), packages.end());
+	words[HEAD_STRINGS] = static_cast<Word>(words.size());
+
+	// Replace the file atomically: eix processes might have mapped it
+	string temp_file(name);
+	temp_file.append(".new");
+	if(unlikely(!data.write(temp_file.c_str())) ||
+		unlikely(std::rename(temp_file.c_str(), name) != 0)) {
+		*errtext = eix::format(_("cannot write %s: %s")) % name % std::strerror(errno);
+		unlink(temp_file.c_str());
+		return false;
+	}
+	return true;
+}
@@ -16,6 +16,7 @@
 #include <string>
 #include <vector>
 
+#include "database/delta.h"
 #include "database/header.h"
 #include "database/io.h"
 #include "database/package_reader.h"
@@ -29,6 +30,7 @@
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/parseerror.h"
+#include "eixTk/sharedstring.h"
 #include "eixTk/utils.h"
 #include "eixrc/eixrc.h"
 #include "eixrc/global.h"
@@ -42,6 +44,7 @@
 #include "portage/packagetree.h"
 #include "portage/set_stability.h"
 #include "portage/vardbpkg.h"
+#include "portage/version.h"
 #include "various/drop_permissions.h"
 
 #define VAR_DB_PKG "/var/db/pkg/"
@@ -68,6 +71,9 @@ static Node           *format_new, *format_delete, *format_changed;
 static void print_help() {
 	eix::say(_("Usage: %s [options] old-cache [new-cache]\n"
 "\n"
+"     --make-delta FILE   write the delta from old-cache to new-cache to FILE\n"
+"     --apply-delta FILE  apply the delta FILE to old-cache and write new-cache\n"
+"                         (default: patch old-cache in place)\n"
 " -Q, --quick (toggle)    do (not) read unguessable slots of installed packages\n"
 "     --care              always read slots of installed packages\n"
 "     --deps-installed    always read deps of installed packages\n"
@@ -99,6 +105,8 @@ bool cli_show_help(false),
 	cli_quiet;
 
 const char *var_to_print(NULLPTR);
+const char *make_delta(NULLPTR);
+const char *apply_delta(NULLPTR);
 
 enum diff_options {
 	O_DUMP = 300,
@@ -108,7 +116,9 @@ enum diff_options {
 	O_CARE,
 	O_DEPS_INSTALLED,
 	O_ANSI,
-	O_FORCE_COLOR
+	O_FORCE_COLOR,
+	O_MAKE_DELTA,
+	O_APPLY_DELTA
 };
 
 
@@ -136,6 +146,8 @@ EixDiffOptionList::EixDiffOptionList() {
 	push_back(Option("deps_installed", O_DEPS_INSTALLED, Option::BOOLEAN_T, &cli_deps_installed));
 	push_back(Option("quiet",        'q',    Option::BOOLEAN,   &cli_quiet));
 	push_back(Option("ansi",         O_ANSI, Option::BOOLEAN_T, &cli_ansi));
+	push_back(Option("make-delta",   O_MAKE_DELTA, Option::STRING, &make_delta));
+	push_back(Option("apply-delta",  O_APPLY_DELTA, Option::STRING, &apply_delta));
 }
 
 static void init_db(const char *file, Database *db, DBHeader *header, PackageReader **reader, PortageSettings *ps) {
@@ -348,8 +360,9 @@ static void parseFormat(Node **format, const char *varname, EixRc *rc) {
 
 int run_eix_diff(int argc, char *argv[]) {
 	// Initialize static classes
+	SharedString::init_static();
 	Eapi::init_static();
-	Category::init_static();
+	IUseSet::init_static();
 	ExtendedVersion::init_static();
 	PortageSettings::init_static();
 	PrintFormat::init_static();
@@ -421,9 +434,10 @@ int run_eix_diff(int argc, char *argv[]) {
 		}
 	}
 
-	bool have_new(false);
+	bool have_old(false), have_new(false);
 	if(unlikely((current_param != argreader.end()) && (current_param->type == Parameter::ARGUMENT))) {
 		old_file = current_param->m_argument;
+		have_old = true;
 		++current_param;
 		if(unlikely((current_param != argreader.end()) && (current_param->type == Parameter::ARGUMENT))) {
 			new_file = current_param->m_argument;
@@ -436,6 +450,27 @@ int run_eix_diff(int argc, char *argv[]) {
 		new_file = rc["EIX_CACHEFILE"];
 	}
 
+	if(unlikely(make_delta != NULLPTR) || unlikely(apply_delta != NULLPTR)) {
+		string errtext;
+		bool ok;
+		if(make_delta != NULLPTR) {
+			ok = DBDelta::create(old_file.c_str(), new_file.c_str(), make_delta, &errtext);
+		} else {
+			// Without arguments patch EIX_CACHEFILE, with one argument patch it
+			if(!have_old) {
+				old_file = new_file;
+			} else if(!have_new) {
+				new_file = old_file;
+			}
+			ok = DBDelta::apply(old_file.c_str(), apply_delta, new_file.c_str(), &errtext);
+		}
+		if(likely(ok)) {
+			return EXIT_SUCCESS;
+		}
+		eix::say_error() % errtext;
+		return EXIT_FAILURE;
+	}
+
 	format_for_new->setupResources(&rc);
 	format_for_new->slot_sorted = false;
 	format_for_new->style_version_lines = false;
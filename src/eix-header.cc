@@ -25,6 +25,7 @@
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/sharedstring.h"
 #include "main/main.h"
 
 using std::string;
@@ -89,6 +90,7 @@ class OverlayOption {
 int run_eix_header(int argc, char *argv[]) {
 	bool verbose(true);
 	OverlayOptionList options;
+	SharedString::init_static();
 
 	if(argc > 0) {
 		++argv;
@@ -21,6 +21,8 @@
 #include "cache/cachetable.h"
 #include "database/header.h"
 #include "database/io.h"
+#include "database/package_reader.h"
+#include "database/segment.h"
 #include "eixTk/attribute.h"
 #include "eixTk/argsreader.h"
 #include "eixTk/dialect.h"
@@ -31,6 +33,8 @@
 #include "eixTk/null.h"
 #include "eixTk/parseerror.h"
 #include "eixTk/percentage.h"
+#include "eixTk/phasestats.h"
+#include "eixTk/sharedstring.h"
 #include "eixTk/statusline.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
@@ -44,6 +48,7 @@
 #include "portage/extendedversion.h"
 #include "portage/overlay.h"
 #include "portage/packagetree.h"
+#include "portage/version.h"
 #include "various/drop_permissions.h"
 
 using std::string;
@@ -123,6 +128,7 @@ static void print_help() {
 "     --force-status      always output status line\n"
 " -F, --force-color       force \"color\" even if output is no terminal\n"
 " -v, --verbose           output used cache method for each ebuild\n"
+"     --phase-stats FILE  write time and counters of all phases to FILE\n"
 "\n"
 " -q, --quiet             produce no output\n"
 "\n"
@@ -147,7 +153,8 @@ enum update_options {
 	O_DUMP_DEFAULTS,
 	O_KNOWN_VARS,
 	O_PRINT_VAR,
-	O_FORCE_STATUS
+	O_FORCE_STATUS,
+	O_PHASE_STATS
 };
 
 static bool
@@ -158,7 +165,8 @@ static bool
 	dump_eixrc(false),
 	dump_defaults(false);
 
-static bool use_percentage, use_status, verbose;
+static bool use_percentage, use_status, verbose, prefetch;
+static bool compress_database = false;
 
 typedef vector<const char *> ExcludeArgs;
 typedef ExcludeArgs AddArgs;
@@ -172,6 +180,7 @@ static RepoArgs *repo_args;
 
 static const char *outputname = NULLPTR;
 static const char *var_to_print = NULLPTR;
+static const char *phase_stats_name = NULLPTR;
 
 /**
 Arguments and options
@@ -196,6 +205,7 @@ EixUpdateOptionList::EixUpdateOptionList() {
 	push_back(Option("force-color",    'F',     Option::BOOLEAN_T,  &use_percentage));
 	push_back(Option("force-status", O_FORCE_STATUS, Option::BOOLEAN_T, &use_status));
 	push_back(Option("verbose",        'v',     Option::BOOLEAN_T,  &verbose));
+	push_back(Option("phase-stats", O_PHASE_STATS, Option::STRING,  &phase_stats_name));
 
 	push_back(Option("exclude-overlay", 'x',    Option::STRINGLIST, exclude_args));
 	push_back(Option("add-overlay",    'a',     Option::STRINGLIST, add_args));
@@ -205,6 +215,16 @@ EixUpdateOptionList::EixUpdateOptionList() {
 }
 
 static PercentStatus *reading_percent_status;
+static PhaseStats *phase_stats = NULLPTR;
+
+/**
+Start a new phase if phase statistics are requested
+**/
+inline static void begin_phase(const char *name) {
+	if(unlikely(phase_stats != NULLPTR)) {
+		phase_stats->begin(name);
+	}
+}
 
 
 static void add_pathnames(PathVec *add_list, const WordVec& to_add, bool must_resolve) {
@@ -289,8 +309,9 @@ static bool stringstart_in_wordlist(const string& to_check, const WordVec& wordl
 
 int run_eix_update(int argc, char *argv[]) {
 	// Initialize static classes
+	SharedString::init_static();
 	Eapi::init_static();
-	Category::init_static();
+	IUseSet::init_static();
 	ExtendedVersion::init_static();
 	PortageSettings::init_static();
 	exclude_args = new ExcludeArgs;
@@ -345,6 +366,10 @@ int run_eix_update(int argc, char *argv[]) {
 
 	/* other defaults */
 	verbose = eixrc.getBool("UPDATE_VERBOSE");
+	prefetch = eixrc.getBool("PREFETCH_CACHEFILES");
+#ifdef WITH_ZLIB
+	compress_database = eixrc.getBool("COMPRESS_DATABASE");
+#endif
 
 	/* Setup ArgumentReader. */
 	ArgumentReader argreader(argc, argv, EixUpdateOptionList());
@@ -394,6 +419,18 @@ int run_eix_update(int argc, char *argv[]) {
 		override_umask = false;
 	}
 
+	/* Start the phase statistics as early as possible */
+	string phase_stats_file;
+	if(unlikely(phase_stats_name != NULLPTR)) {
+		phase_stats_file = phase_stats_name;
+	} else {
+		phase_stats_file = eixrc["UPDATE_PHASE_STATS"];
+	}
+	if(unlikely(!phase_stats_file.empty())) {
+		phase_stats = new PhaseStats("eix-update");
+		PackageReader::collect_stats = true;
+	}
+
 	Statusline statusline(use_status, (use_status &&
 		stringstart_in_wordlist(eixrc["TERM"],
 			split_string(eixrc["TERM_SOFTSTATUSLINE"]))),
@@ -401,6 +438,7 @@ int run_eix_update(int argc, char *argv[]) {
 
 	ParseError parse_error;
 	INFO(_("Reading Portage settings..."));
+	begin_phase("settings");
 	PortageSettings portage_settings(&eixrc, &parse_error, false, true);
 
 	/* Build default (overlay/method/...) lists, using environment vars */
@@ -499,6 +537,7 @@ int run_eix_update(int argc, char *argv[]) {
 	}
 
 	/* Create CacheTable and fill with PORTDIR and PORTDIR_OVERLAY. */
+	begin_phase("add caches");
 	CacheTable table(eixrc["CACHE_METHOD_PARSE"]); {
 		OverrideVector *override_ptr(override_vector.size() ? &override_vector : NULLPTR);
 		if(likely(find_filenames(excluded_overlays.begin(), excluded_overlays.end(),
@@ -542,9 +581,29 @@ int run_eix_update(int argc, char *argv[]) {
 
 	/* Update the database from scratch */
 	string errtext;
-	if(unlikely(!update(outputfile.c_str(), &table, &portage_settings, override_umask,
-			repo_names, excluded_overlays, &statusline, &errtext))) {
+	bool success(update(outputfile.c_str(), &table, &portage_settings, override_umask,
+			repo_names, excluded_overlays, &statusline, &errtext));
+	// The segment is only written for the database read by eix
+	const string& segment_file(eixrc["EIX_SEGMENT"]);
+	if(likely(success) && override_umask && !segment_file.empty()) {
+		INFO(_("Writing database index %s...")) % segment_file;
+		begin_phase("segment");
+		mode_t old_umask(umask(2));
+		success = DBSegment::write(segment_file.c_str(), outputfile.c_str(), &errtext);
+		umask(old_umask);
+	}
+	if(unlikely(!success)) {
 		eix::say_error() % errtext;
+	}
+	if(unlikely(phase_stats != NULLPTR)) {
+		phase_stats->end();
+		if(unlikely(!phase_stats->write(phase_stats_file.c_str(), &errtext))) {
+			eix::say_error() % errtext;
+		}
+		delete phase_stats;
+		phase_stats = NULLPTR;
+	}
+	if(unlikely(!success)) {
 		statusline.failure();
 		return EXIT_FAILURE;
 	}
@@ -566,6 +625,7 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 
 	dbheader.world_sets = *(portage_settings->get_world_sets());
 
+	begin_phase("prepare caches");
 	/* We must first initialize all caches and erase unneeded ones,
 	   because some cache methods like eixcache know about each other
 	   and call each other before we can call them in a loop afterwards. */
@@ -609,15 +669,35 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 		statusline->print(eix::format(P_("Statusline eix-update", "[%s] %s"))
 				% cache->getKey()
 				% cache->getOverlayName());
+		if(unlikely(phase_stats != NULLPTR)) {
+			phase_stats->begin(eix::format("read [%s] %s")
+				% cache->getKey()
+				% cache->getOverlayName());
+			phase_stats->add_arg("overlay", cache->getOverlayName());
+			phase_stats->add_arg("path", cache->getPathHumanReadable());
+			phase_stats->add_arg("cache", cache->getType());
+		}
 		reading_percent_status = new PercentStatus;
 		if(cache->can_read_multiple_categories()) {
 			reading_percent_status->init(P_("Percent",
 				"     Reading Packages..."));
 			cache->setErrorCallback(error_callback);
+			eix::UNumber categories_skipped(PackageReader::categories_skipped);
+			eix::OffsetType bytes_skipped(PackageReader::bytes_skipped);
+			eix::OffsetType bytes_decoded(PackageReader::bytes_decoded);
 			reading_percent_status->finish(
 				likely(cache->readCategories(&package_tree)) ?
 				P_("Percent", "Finished") :
 				P_("Percent", "ABORTED!"));
+			if(unlikely(phase_stats != NULLPTR)) {
+				// Only the eix cache methods read a database
+				phase_stats->add_arg("categories_skipped", eix::format("%s")
+					% (PackageReader::categories_skipped - categories_skipped));
+				phase_stats->add_arg("bytes_skipped", eix::format("%s")
+					% (PackageReader::bytes_skipped - bytes_skipped));
+				phase_stats->add_arg("bytes_decoded", eix::format("%s")
+					% (PackageReader::bytes_decoded - bytes_decoded));
+			}
 		} else {
 			if(use_percentage) {
 				reading_percent_status->init(P_("Percent",
@@ -636,6 +716,13 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 			bool is_empty(true);
 			for(PackageTree::const_iterator ci(package_tree.begin());
 				unlikely(ci != package_tree.end()); ++ci) {
+				if(prefetch) {
+					// Let the kernel read the next category while we parse this one
+					PackageTree::const_iterator next(ci);
+					if(++next != package_tree.end()) {
+						cache->prefetchCategory(next->first.c_str());
+					}
+				}
 				if(!cache->readCategoryPrepare(ci->first.c_str())) {
 					if(use_percentage) {
 						reading_percent_status->next();
@@ -665,6 +752,7 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 
 	/* Now apply all masks... */
 	INFO(_("Applying masks..."));
+	begin_phase("masks");
 	for(PackageTree::iterator c(package_tree.begin());
 		likely(c != package_tree.end()); ++c) {
 		Category *ci = c->second;
@@ -681,11 +769,13 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 	}
 
 	INFO(_("Calculating hash tables..."));
+	begin_phase("hashes");
 	Database::prep_header_hashs(&dbheader, package_tree);
 
 	/* And write database back to disk... */
 	statusline->print(eix::format(P_("Statusline eix-update", "Creating %s")) % outputfile);
 	INFO(_("Writing database file %s...")) % outputfile;
+	begin_phase("write");
 	mode_t old_umask;
 	if(override_umask) {
 		old_umask = umask(2);
@@ -701,6 +791,7 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 	}
 
 	dbheader.size = package_tree.countCategories();
+	dbheader.compressed = compress_database;
 
 	if(!(likely(db.write_header(dbheader, errtext)) &&
 		likely(db.write_packagetree(package_tree, dbheader, errtext)))) {
@@ -9,18 +9,21 @@
 
 #include <config.h>  // IWYU pragma: keep
 
+#include <fnmatch.h>
 #include <unistd.h>
 
 #include <cstdlib>
 #include <cstring>
 
 #include <algorithm>
+#include <iostream>
 #include <string>
 #include <vector>
 
 #include "database/header.h"
 #include "database/io.h"
 #include "database/package_reader.h"
+#include "database/segment.h"
 #include "eixTk/ansicolor.h"
 #include "eixTk/argsreader.h"
 #include "eixTk/attribute.h"
@@ -34,7 +37,9 @@
 #include "eixTk/null.h"
 #include "eixTk/outputstring.h"
 #include "eixTk/parseerror.h"
+#include "eixTk/phasestats.h"
 #include "eixTk/ptr_container.h"
+#include "eixTk/sharedstring.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "eixTk/unordered_map.h"
@@ -53,14 +58,17 @@
 #include "portage/keywords.h"
 #include "portage/mask.h"
 #include "portage/package.h"
+#include "portage/packageindex.h"
 #include "portage/packagetree.h"
 #include "portage/set_stability.h"
 #include "portage/vardbpkg.h"
+#include "portage/version.h"
 #include "search/algorithms.h"
 #include "search/matchtree.h"
 #include "search/packagetest.h"
 #include "various/cli.h"
 #include "various/drop_permissions.h"
+#include "various/server.h"
 
 #define VAR_DB_PKG "/var/db/pkg/"
 
@@ -71,7 +79,55 @@ using std::vector;
 
 typedef eix::ptr_container<vector<Package *> > PackageList;
 
+/**
+Lookup of masks in the compact index of all packages for --test-non-matching.
+For atoms with a category wildcard but a plain name (like * /foo) an index
+by name is built on demand.
+The exclude lists are read only once for all files using them.
+**/
+class UnusedIndex {
+	public:
+		explicit UnusedIndex(const PackageIndex& packages)
+			: m_packages(packages), m_have_names(false) {
+		}
+
+		/**
+		@return true if m matches some package of the tree
+		**/
+		bool matches(const Mask& m);
+
+		/**
+		@return the (cached) entries of the space-separated excludefiles
+		**/
+		const WordSet& excludes(const string& excludefiles);
+
+	private:
+		typedef vector<PackageIndex::size_type> Packages;
+		typedef UNORDERED_MAP<string, Packages> NameIndex;
+		typedef UNORDERED_MAP<string, WordSet> ExcludesCache;
+
+		const PackageIndex& m_packages;
+		NameIndex m_names;
+		bool m_have_names;
+		ExcludesCache m_excludes;
+
+		void init_names();
+
+		bool matches_range(const Mask& m, PackageIndex::size_type first, PackageIndex::size_type last) const;
+};
+
 static void dump_help();
+ATTRIBUTE_NONNULL_ static int run_eix_args(int argc, char *argv[]);
+class StatsPrinter;
+ATTRIBUTE_NONNULL_ static int run_eix_query(PortageSettings *portagesettings, StatsPrinter *stats_printer, const ArgumentReader& argreader, const string& cachefile, const char *tooltext, bool only_printed, bool is_tty);
+ATTRIBUTE_NONNULL((1, 2, 3, 4, 5)) static PackageList::size_type print_matches(PackageList *matches, DBHeader *header, VarDbPkg *varpkg_db, PortageSettings *portagesettings, SetStability *stability, MaskList<Mask> *marked_list, bool only_printed, bool is_tty);
+ATTRIBUTE_NONNULL_ static bool read_batch(const char *file, LineVec *lines, string *errtext);
+ATTRIBUTE_NONNULL_ static int run_batch(Database *db, DBHeader *header, VarDbPkg *varpkg_db, PortageSettings *portagesettings, SetStability *stability, MatchTree *matchtree, bool only_printed, bool is_tty);
+ATTRIBUTE_NONNULL_ static bool is_server_call(int argc, char *argv[]);
+static int run_server(const string& cachefile);
+static void begin_phase(const char *name);
+static void print_stats(const MatchTree *matchtree);
+static void server_prepare();
 ATTRIBUTE_NONNULL_ static bool opencache(Database *db, const char *filename, const char *tooltext);
 ATTRIBUTE_NONNULL((1, 2)) static bool print_overlay_table(PrintFormat *fmt, DBHeader *header, PrintFormat::OverlayUsed *overlay_used);
 ATTRIBUTE_NONNULL_ static void parseFormat(const char *sourcename, const char *content);
@@ -79,11 +135,11 @@ ATTRIBUTE_NONNULL_ static void set_format(EixRc *rc);
 ATTRIBUTE_NONNULL_ static void setup_defaults(EixRc *rc, bool is_tty);
 ATTRIBUTE_NONNULL_ static bool is_current_dbversion(const char *filename, const char *tooltext);
 static void print_wordvec(const WordVec& vec);
-static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist, bool test_empty);
-static void print_removed(const string& dirname, const string& excludefiles, const PackageList& packagelist);
-inline static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist);
-inline static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist) {
-	print_unused(filename, excludefiles, packagelist, false);
+ATTRIBUTE_NONNULL_ static void print_unused(const string& filename, const string& excludefiles, UnusedIndex *index, bool test_empty);
+ATTRIBUTE_NONNULL_ static void print_removed(const string& dirname, const string& excludefiles, const PackageIndex& packages, UnusedIndex *index);
+ATTRIBUTE_NONNULL_ inline static void print_unused(const string& filename, const string& excludefiles, UnusedIndex *index);
+inline static void print_unused(const string& filename, const string& excludefiles, UnusedIndex *index) {
+	print_unused(filename, excludefiles, index, false);
 }
 
 /**
@@ -120,6 +176,8 @@ static void dump_help() {
 "                           (needs DEP=true)\n"
 "     --print-world-sets    print the world sets\n"
 "     --print-profile-paths print all paths of current profile\n"
+"     --server              keep data loaded and answer calls of eix from\n"
+"                           the unix socket $EIX_SERVER\n"
 "     --256                 Print all ansi color palettes\n"
 "     --256d                Print ansi color palettes for foreground (dark)\n"
 "     --256d0               Print ansi color palette dark (normal)\n"
@@ -138,6 +196,10 @@ static void dump_help() {
 "         --care            always read slots of installed packages\n"
 "         --deps-installed  always read deps of installed packages\n"
 "         --cache-file      use another cache-file instead of %s\n"
+"         --batch FILE      answer each line of FILE (- for stdin) as a\n"
+"                           separate query in a single pass\n"
+"         --stats           print time per phase, counters, and calls,\n"
+"                           matches, and time of each test to stderr\n"
 "     -R  --remote (toggle)  use remote cache-file %s\n"
 "     -Z  --remote2 (toggle) use remote cache-file %s\n"
 "\n"
@@ -155,6 +217,8 @@ static void dump_help() {
 "         --brief2 (toggle)  Print at most two packages then stop\n"
 "     --xml (toggle)         output results in XML format\n"
 "     --proto (toggle)       output results in protobuf format\n"
+"     --proto-stream (toggle) output results as a stream of\n"
+"                            length-delimited protobuf Category messages\n"
 "     -c, --compact          compact search results\n"
 "     -v, --verbose          verbose search results\n"
 "     -N, --normal           ignores -c, -v, and DEFAULT_FORMAT\n"
@@ -283,6 +347,7 @@ static void dump_help() {
 static const char *formatstring;
 static const char *eix_cachefile(NULLPTR);
 static const char *var_to_print(NULLPTR);
+static const char *batch_file(NULLPTR);
 static const char *color(NULLPTR);
 
 enum OverlayMode {
@@ -334,6 +399,7 @@ static struct LocalOptions {
 		known_vars,
 		xml,
 		proto,
+		proto_stream,
 		test_unused,
 		do_debug,
 		ignore_etc_portage,
@@ -347,9 +413,118 @@ static struct LocalOptions {
 		hash_license,
 		hash_depend,
 		print_profile_paths,
-		world_sets;
+		world_sets,
+		server,
+		stats;
 } rc_options;
 
+/**
+The data which eix --server keeps loaded
+**/
+class EixResident {
+	public:
+		string cachefile;
+		FileStamps stamps;  ///< the files from which the data was read
+		ParseError *parse_error;
+		PortageSettings *portagesettings;
+		DBHeader *header;  ///< NULLPTR if the database cannot be read
+		/**
+		The content of the database file. We do not keep the file open,
+		since our lock would block eix-update.
+		**/
+		string database;
+		eix::OffsetType header_end;
+
+		explicit EixResident(const string& file) :
+			cachefile(file), parse_error(NULLPTR), portagesettings(NULLPTR), header(NULLPTR) {
+		}
+
+		~EixResident() {
+			clear();
+		}
+
+		void clear() {
+			delete header;
+			header = NULLPTR;
+			database.clear();
+			delete portagesettings;
+			portagesettings = NULLPTR;
+			delete parse_error;
+			parse_error = NULLPTR;
+		}
+};
+
+static EixResident *resident(NULLPTR);
+
+/**
+For --stats; start_snapshot is taken at the program start
+or at the start of a request to eix --server, respectively
+**/
+static PhaseStats::Snapshot start_snapshot;
+static PhaseStats *phase_stats(NULLPTR);
+
+static void begin_phase(const char *name) {
+	if(unlikely(phase_stats != NULLPTR)) {
+		phase_stats->begin(name);
+	}
+}
+
+/**
+Print the statistics of --stats (if any) to stderr
+**/
+static void print_stats(const MatchTree *matchtree) {
+	if(likely(phase_stats == NULLPTR)) {
+		return;
+	}
+	phase_stats->end();
+	phase_stats->print();
+	delete phase_stats;
+	phase_stats = NULLPTR;
+	eix::say_error(_("files: %s opened, %s bytes read"))
+		% PhaseStats::files_opened % PhaseStats::bytes_read;
+	eix::say_error(_("database: %s bytes decoded, %s bytes skipped, %s categories skipped"))
+		% PackageReader::bytes_decoded % PackageReader::bytes_skipped
+		% PackageReader::categories_skipped;
+	eix::say_error(_("decoded up to: name %s, description %s, homepage %s, license %s, versions %s"))
+		% PackageReader::decoded[PackageReader::NAME]
+		% PackageReader::decoded[PackageReader::DESCRIPTION]
+		% PackageReader::decoded[PackageReader::HOMEPAGE]
+		% PackageReader::decoded[PackageReader::LICENSE]
+		% (PackageReader::decoded[PackageReader::VERSIONS] +
+			PackageReader::decoded[PackageReader::ALL]);
+	eix::say_error(_("stability: %s recalculated, %s reused"))
+		% SetStability::recalculations % SetStability::reused;
+	if(matchtree != NULLPTR) {
+		matchtree->print_stats();
+	}
+}
+
+/**
+Print the statistics of --stats (if any) when leaving the scope,
+also on early returns. The matchtree must be deleted only after print().
+**/
+class StatsPrinter {
+	private:
+		const MatchTree *m_matchtree;
+
+	public:
+		StatsPrinter() : m_matchtree(NULLPTR) {
+		}
+
+		~StatsPrinter() {
+			print();
+		}
+
+		void set_matchtree(const MatchTree *matchtree) {
+			m_matchtree = matchtree;
+		}
+
+		void print() {
+			print_stats(m_matchtree);
+			m_matchtree = NULLPTR;
+		}
+};
+
 /**
 Arguments and options
 **/
@@ -392,6 +567,7 @@ EixOptionList::EixOptionList() {
 	push_back(Option("normal",        'N',     Option::BOOLEAN_T,     &rc_options.normal_output));
 	push_back(Option("xml",           O_XML,   Option::BOOLEAN,       &rc_options.xml));
 	push_back(Option("proto",         O_PROTO, Option::BOOLEAN,       &rc_options.proto));
+	push_back(Option("proto-stream",  O_PROTO_STREAM, Option::BOOLEAN, &rc_options.proto_stream));
 	push_back(Option("help",          'h',     Option::BOOLEAN_T,     &rc_options.show_help));
 	push_back(Option("version",       'V',     Option::BOOLEAN_T,     &rc_options.show_version));
 	push_back(Option("dump",          O_DUMP,  Option::BOOLEAN_T,     &rc_options.dump_eixrc));
@@ -408,6 +584,7 @@ EixOptionList::EixOptionList() {
 	push_back(Option("print-all-depends",   O_HASH_DEPEND,   Option::BOOLEAN_T, &rc_options.hash_depend));
 	push_back(Option("print-world-sets",    O_WORLD_SETS,    Option::BOOLEAN_T, &rc_options.world_sets));
 	push_back(Option("print-profile-paths", O_PROFILE_PATHS, Option::BOOLEAN_T, &rc_options.print_profile_paths));
+	push_back(Option("server",              O_SERVER,        Option::BOOLEAN_T, &rc_options.server));
 
 	push_back(Option("ignore-etc-portage",  O_IGNORE_ETC_PORTAGE, Option::BOOLEAN_T,  &rc_options.ignore_etc_portage));
 
@@ -416,6 +593,8 @@ EixOptionList::EixOptionList() {
 	push_back(Option("format",         O_FMT,         Option::STRING,   &formatstring));
 
 	push_back(Option("cache-file",     O_EIX_CACHEFILE, Option::STRING, &eix_cachefile));
+	push_back(Option("batch",          O_BATCH,       Option::STRING,   &batch_file));
+	push_back(Option("stats",          O_STATS,       Option::BOOLEAN_T, &rc_options.stats));
 	push_back(Option("remote",         'R', Option::BOOLEAN, &rc_options.remote));
 	push_back(Option("remote2",        'Z', Option::BOOLEAN, &rc_options.remote2));
 
@@ -650,14 +829,26 @@ static void set_format(EixRc *rc) {
 }
 
 int run_eix(int argc, char** argv) {
+	// Let a running eix --server answer (without initializing anything)
+	const char *server(std::getenv("EIX_SERVER"));
+	if(unlikely((server != NULLPTR) && (*server != '\0')) &&
+		likely(!is_server_call(argc, argv))) {
+		int status;
+		if(likely(server_client(server, argc, argv, &status))) {
+			return status;
+		}
+	}
+
+	start_snapshot.take();
+
 	// Initialize static classes
+	SharedString::init_static();
 	Eapi::init_static();
-	Category::init_static();
+	IUseSet::init_static();
 	ExtendedVersion::init_static();
 	PackageTest::init_static();
 	PortageSettings::init_static();
 	PrintFormat::init_static();
-	format = new PrintFormat(get_package_property);
 
 	EixRc& eixrc(get_eixrc(EIX_VARS_PREFIX)); {
 		string errtext;
@@ -669,6 +860,16 @@ int run_eix(int argc, char** argv) {
 			return EXIT_FAILURE;
 		}
 	}
+	return run_eix_args(argc, argv);
+}
+
+/**
+Everything after the initialization.
+eix --server calls this in a forked process for every request.
+**/
+static int run_eix_args(int argc, char *argv[]) {
+	EixRc& eixrc(get_eixrc());
+	format = new PrintFormat(get_package_property);
 
 	// Setup defaults for all global variables like rc_options
 	bool is_tty(isatty(1) != 0);
@@ -677,6 +878,15 @@ int run_eix(int argc, char** argv) {
 	// Read our options from the commandline.
 	ArgumentReader argreader(argc, argv, EixOptionList());
 
+	StatsPrinter stats_printer;
+	if(unlikely(rc_options.stats)) {
+		if(resident != NULLPTR) {
+			start_snapshot.take();
+		}
+		phase_stats = new PhaseStats(program_name, start_snapshot);
+		PackageReader::collect_stats = MatchTree::collect_stats = true;
+	}
+
 	if(unlikely(color != NULLPTR)) {
 		if(unlikely(strncasecmp("au", color, 2) == 0)) {
 			format->no_color = !is_tty;
@@ -738,6 +948,10 @@ int run_eix(int argc, char** argv) {
 		return (is_current_dbversion(cachefile.c_str(), tooltext) ? EXIT_SUCCESS : EXIT_FAILURE);
 	}
 
+	if(unlikely(rc_options.server)) {
+		return run_server(cachefile);
+	}
+
 	// Show version
 	if(unlikely(rc_options.show_version)) {
 		dump_version();
@@ -786,6 +1000,20 @@ int run_eix(int argc, char** argv) {
 
 	bool only_printed;
 
+	if(unlikely(rc_options.proto_stream)) {
+		rc_options.proto = true;
+	}
+	if(unlikely(batch_file != NULLPTR)) {
+		if(unlikely(rc_options.test_unused)) {
+			eix::say_error(_("--batch and -t must not be specified simultaneously"));
+			return EXIT_FAILURE;
+		}
+		// The output of the lines would be separate documents
+		if(unlikely(rc_options.xml || rc_options.proto)) {
+			eix::say_error(_("--batch must not be combined with --xml or --proto"));
+			return EXIT_FAILURE;
+		}
+	}
 	if(unlikely(rc_options.xml || rc_options.proto)) {
 		rc_options.pure_packages = format->no_color = true;
 		only_printed = false;
@@ -807,10 +1035,24 @@ int run_eix(int argc, char** argv) {
 	}
 
 	parse_error = new ParseError(rc_options.no_warn);
+	if(unlikely(resident != NULLPTR) && likely(resident->portagesettings != NULLPTR) &&
+		likely(!rc_options.print_profile_paths)) {
+		return run_eix_query(resident->portagesettings, &stats_printer, argreader, cachefile, tooltext, only_printed, is_tty);
+	}
+	begin_phase("settings");
 	PortageSettings portagesettings(&eixrc, parse_error, true, false, rc_options.print_profile_paths);
 	if(unlikely(rc_options.print_profile_paths)) {
 		return EXIT_SUCCESS;
 	}
+	return run_eix_query(&portagesettings, &stats_printer, argreader, cachefile, tooltext, only_printed, is_tty);
+}
+
+/**
+The actual query with the (possibly resident) portagesettings
+**/
+static int run_eix_query(PortageSettings *portagesettings_ptr, StatsPrinter *stats_printer, const ArgumentReader& argreader, const string& cachefile, const char *tooltext, bool only_printed, bool is_tty) {
+	EixRc& eixrc(get_eixrc());
+	PortageSettings& portagesettings(*portagesettings_ptr);
 
 	string var_db_pkg(eixrc["EPREFIX_INSTALLED"] + VAR_DB_PKG);
 	VarDbPkg varpkg_db(var_db_pkg, !rc_options.quick, rc_options.care,
@@ -823,22 +1065,39 @@ int run_eix(int argc, char** argv) {
 	MaskList<Mask> *marked_list(NULLPTR);
 
 	/* Open database file */
+	begin_phase("header");
+	DBSegment segment;  // must be mapped as long as db is used
 	Database db;
-	if(unlikely(!opencache(&db, cachefile.c_str(), tooltext))) {
-		return EXIT_FAILURE;
-	}
-	DBHeader header;
-
-	if(unlikely(!db.read_header(&header, NULLPTR, 0))) {
-		eix::say_error(_(
-			"%s was created with an incompatible eix-update:\n"
-			"It uses database format %s (current is %s).\n"
-			"Please run \"%s\" and try again."))
-			% cachefile
-			% header.version % DBHeader::current
-			% tooltext;
-		return EXIT_FAILURE;
+	DBHeader own_header;
+	DBHeader *header_ptr(&own_header);
+	if(unlikely(resident != NULLPTR) && likely(resident->header != NULLPTR) &&
+		likely(resident->cachefile == cachefile)) {
+		// The packages are still decoded, but from the resident copy
+		db.openmem(resident->database.data(),
+			static_cast<eix::OffsetType>(resident->database.size()));
+		db.seekabs(resident->header_end, NULLPTR);
+		header_ptr = resident->header;
+	} else {
+		if(unlikely(!opencache(&db, cachefile.c_str(), tooltext))) {
+			return EXIT_FAILURE;
+		}
+		const string& segment_file(eixrc["EIX_SEGMENT"]);
+		if(unlikely(!segment_file.empty()) &&
+			likely(segment.open(segment_file.c_str(), db))) {
+			db.use_segment(&segment);
+		}
+		if(unlikely(!db.read_header(&own_header, NULLPTR, 0))) {
+			eix::say_error(_(
+				"%s was created with an incompatible eix-update:\n"
+				"It uses database format %s (current is %s).\n"
+				"Please run \"%s\" and try again."))
+				% cachefile
+				% own_header.version % DBHeader::current
+				% tooltext;
+			return EXIT_FAILURE;
+		}
 	}
+	DBHeader& header(*header_ptr);
 
 	if(unlikely(rc_options.hash_eapi)) {
 		header.eapi_hash.output();
@@ -896,21 +1155,56 @@ int run_eix(int argc, char** argv) {
 
 	SetStability stability(&portagesettings, !rc_options.ignore_etc_portage, false, eixrc.getBool("ALWAYS_ACCEPT_KEYWORDS"));
 
+	begin_phase("parse query");
 	MatchTree *matchtree = new MatchTree(eixrc.getBool("DEFAULT_IS_OR"));
 	parse_cli(matchtree, &eixrc, &varpkg_db, &portagesettings, format, &stability, &header, parse_error, &marked_list, argreader);
+	stats_printer->set_matchtree(matchtree);
+
+	if(unlikely(batch_file != NULLPTR)) {
+		int status(run_batch(&db, &header, &varpkg_db, &portagesettings, &stability, matchtree, only_printed, is_tty));
+		stats_printer->print();
+		delete matchtree;
+		delete marked_list;
+		return status;
+	}
 
+	begin_phase("match");
 	PackageList matches;
-	PackageList all_packages; {
+	// With --proto-stream, print and free each match at once unless
+	// the matches must be sorted or kept for --test-non-matching
+	PrintProto *proto_stream(NULLPTR);
+	PackageList::size_type streamed(0);
+	if(unlikely(rc_options.proto_stream && !rc_options.test_unused &&
+		!FuzzyAlgorithm::sort_by_levenshtein())) {
+		proto_stream = new PrintProto(&header, &varpkg_db, format, &stability, true);
+	}
+	// For --test-non-matching
+	PackageIndex all_packages; {
 		PackageReader reader(&db, header, &portagesettings);
 		bool add_rest(false);
 		while(likely(reader.next())) {
 			if(unlikely(add_rest)) {
-				all_packages.PUSH_BACK(reader.release());
+				if(unlikely(!reader.read(PackageReader::VERSIONS))) {
+					break;
+				}
+				all_packages.add(*reader.get());
 			} else if(unlikely(matchtree->match(&reader))) {
 				Package *release(reader.release());
 				if(unlikely(release == NULLPTR)) {
 					break;
 				}
+				if(unlikely(proto_stream != NULLPTR)) {
+					stability.set_stability(release);
+					proto_stream->package(release);
+					delete release;
+					++streamed;
+					if(unlikely(only_printed &&
+						(rc_options.brief ||
+							(rc_options.brief2 && (streamed > 1))))) {
+						break;
+					}
+					continue;
+				}
 				matches.PUSH_BACK(release);
 				if(unlikely(only_printed &&
 					(rc_options.brief ||
@@ -922,83 +1216,117 @@ int run_eix(int argc, char** argv) {
 					}
 				}
 				if(unlikely(rc_options.test_unused)) {
-					all_packages.PUSH_BACK(release);
+					all_packages.add(*release);
 				}
 			} else {
 				if(unlikely(rc_options.test_unused)) {
-					Package *release(reader.release());
-					if(unlikely(release == NULLPTR)) {
+					if(unlikely(!reader.read(PackageReader::VERSIONS))) {
 						break;
 					}
-					all_packages.PUSH_BACK(release);
+					all_packages.add(*reader.get());
 				} else if(unlikely(!reader.skip())) {
 					break;
 				}
 			}
 		}
 		const char *err_cstr(reader.get_errtext());
+		delete proto_stream;
 		if(unlikely(err_cstr != NULLPTR)) {
 			eix::say_error() % err_cstr;
+			stats_printer->print();
+			delete matchtree;
+			delete marked_list;
+			matches.delete_and_clear();
 			return EXIT_FAILURE;
 		}
 	}
 
-	// Delete old matchtree
-	delete matchtree;
-
 	if(unlikely(rc_options.test_unused)) {
+		begin_phase("test non-matching");
 		bool empty(eixrc.getBool("TEST_FOR_EMPTY"));
+		UnusedIndex index(all_packages);
 		if(likely(eixrc.getBool("TEST_KEYWORDS"))) {
 			print_unused(eixrc.m_eprefixconf + USER_KEYWORDS_FILE1,
 				eixrc["KEYWORDS_NONEXISTENT"],
-				all_packages);
+				&index);
 			print_unused(eixrc.m_eprefixconf + USER_KEYWORDS_FILE2,
 				eixrc["KEYWORDS_NONEXISTENT"],
-				all_packages);
+				&index);
 		}
 		if(likely(eixrc.getBool("TEST_MASK"))) {
 			print_unused(eixrc.m_eprefixconf + USER_MASK_FILE,
 				eixrc["MASK_NONEXISTENT"],
-				all_packages);
+				&index);
 		}
 		if(likely(eixrc.getBool("TEST_UNMASK"))) {
 			print_unused(eixrc.m_eprefixconf + USER_UNMASK_FILE,
 				eixrc["UNMASK_NONEXISTENT"],
-				all_packages);
+				&index);
 		}
 		if(likely(eixrc.getBool("TEST_USE"))) {
 			print_unused(eixrc.m_eprefixconf + USER_USE_FILE,
 				eixrc["USE_NONEXISTENT"],
-				all_packages, empty);
+				&index, empty);
 		}
 		if(likely(eixrc.getBool("TEST_ENV"))) {
 			print_unused(eixrc.m_eprefixconf + USER_ENV_FILE,
 				eixrc["ENV_NONEXISTENT"],
-				all_packages, empty);
+				&index, empty);
 		}
 		if(likely(eixrc.getBool("TEST_LICENSE"))) {
 			print_unused(eixrc.m_eprefixconf + USER_LICENSE_FILE,
 				eixrc["LICENSE_NONEXISTENT"],
-				all_packages, empty);
+				&index, empty);
 		}
 		if(likely(eixrc.getBool("TEST_RESTRICT"))) {
 			print_unused(eixrc.m_eprefixconf + USER_RESTRICT_FILE,
 				eixrc["LICENSE_RESTRICT"],
-				all_packages, empty);
+				&index, empty);
 		}
 		if(likely(eixrc.getBool("TEST_CFLAGS"))) {
 			print_unused(eixrc.m_eprefixconf + USER_CFLAGS_FILE,
 				eixrc["CFLAGS_NONEXISTENT"],
-				all_packages, empty);
+				&index, empty);
 		}
 		if(likely(eixrc.getBool("TEST_REMOVED"))) {
-			print_removed(var_db_pkg, eixrc["INSTALLED_NONEXISTENT"], all_packages);
+			print_removed(var_db_pkg, eixrc["INSTALLED_NONEXISTENT"], all_packages, &index);
 		}
 	}
 
+	begin_phase("output");
+	PackageList::size_type count(print_matches(&matches, &header, &varpkg_db, &portagesettings, &stability, marked_list, only_printed, is_tty));
+	if(!only_printed) {
+		count += streamed;
+	}
+	stats_printer->print();
+	delete matchtree;
+
+	matches.delete_and_clear();
+	delete marked_list;
+
+	if(unlikely(!count)) {
+GCC_DIAG_OFF(sign-conversion)
+		return eixrc.getInteger("NOFOUND_STATUS");
+GCC_DIAG_ON(sign-conversion)
+	}
+	if(count > 1) {
+GCC_DIAG_OFF(sign-conversion)
+		return eixrc.getInteger("MOREFOUND_STATUS");
+GCC_DIAG_ON(sign-conversion)
+	}
+	return EXIT_SUCCESS;
+}  // NOLINT(readability/fn_size)
+
+/**
+Print the matches (but do not delete them)
+@return the number of matches or of printed matches, respectively
+**/
+static PackageList::size_type print_matches(PackageList *matches, DBHeader *header, VarDbPkg *varpkg_db, PortageSettings *portagesettings, SetStability *stability, MaskList<Mask> *marked_list, bool only_printed, bool is_tty) {
+	EixRc& eixrc(get_eixrc());
+
 	/* Sort the found matches by rating */
 	if(unlikely(FuzzyAlgorithm::sort_by_levenshtein())) {
-		std::sort(matches.begin(), matches.end(), FuzzyAlgorithm::compare);
+		std::sort(matches->begin(), matches->end(), FuzzyAlgorithm::compare);
 	}
 
 	format->set_marked_list(marked_list);
@@ -1006,7 +1334,7 @@ int run_eix(int argc, char** argv) {
 		format->set_overlay_translations(NULLPTR);
 	}
 	bool need_overlay_table(false);
-	PrintFormat::OverlayUsed overlay_used(header.countOverlays(), false);
+	PrintFormat::OverlayUsed overlay_used(header->countOverlays(), false);
 	format->set_overlay_used(&overlay_used, &need_overlay_table);
 	PackageList::size_type count(0);
 	PrintFormats *print_formats(NULLPTR);
@@ -1014,16 +1342,16 @@ int run_eix(int argc, char** argv) {
 		overlay_mode = mode_list_none;
 		rc_options.pure_packages = true;
 	}
-	if (!matches.empty()) {
+	if (!matches->empty()) {
 		if(rc_options.xml) {
 			if (unlikely(rc_options.proto)) {
 				eix::say_error(_("--xml and --proto must not be specified simultaneously"));
 				std::exit(EXIT_FAILURE);
 			}
-			print_formats = new PrintXml(&header, &varpkg_db, format, &stability, &eixrc,
-				portagesettings["PORTDIR"]);
+			print_formats = new PrintXml(header, varpkg_db, format, stability, &eixrc,
+				(*portagesettings)["PORTDIR"]);
 		} else if (rc_options.proto) {
-			print_formats = new PrintProto(&header, &varpkg_db, format, &stability);
+			print_formats = new PrintProto(header, varpkg_db, format, stability, rc_options.proto_stream);
 		}
 		if (print_formats != NULLPTR) {
 			print_formats->start();
@@ -1033,9 +1361,9 @@ int run_eix(int argc, char** argv) {
 	bool reached_limit(false), over_limit(false);
 	string limit_var(rc_options.compact_output ? "EIX_LIMIT_COMPACT" : "EIX_LIMIT");
 	eix::Treesize limit(is_tty ? eixrc.getInteger(limit_var) : 0);
-	for(PackageList::iterator it(matches.begin());
-		likely(it != matches.end()); ++it) {
-		stability.set_stability(*it);
+	for(PackageList::iterator it(matches->begin());
+		likely(it != matches->end()); ++it) {
+		stability->set_stability(*it);
 
 		if(unlikely(print_formats != NULLPTR)) {
 			print_formats->package(*it);
@@ -1055,7 +1383,7 @@ int run_eix(int argc, char** argv) {
 			}
 		}
 		if(overlay_mode != mode_list_used_renumbered) {
-			if(format->print(*it, &header, &varpkg_db, &portagesettings, &stability, reached_limit)) {
+			if(format->print(*it, header, varpkg_db, portagesettings, stability, reached_limit)) {
 				have_printed = true;
 				++count;
 				if(unlikely(reached_limit)) {
@@ -1079,7 +1407,7 @@ int run_eix(int argc, char** argv) {
 		default:
 			break;
 	}
-	PrintFormat::OverlayTranslations overlay_num(header.countOverlays(), 0);
+	PrintFormat::OverlayTranslations overlay_num(header->countOverlays(), 0);
 	if(overlay_mode == mode_list_used_renumbered) {
 		ExtendedVersion::Overlay i(1);
 		PrintFormat::OverlayUsed::iterator uit(overlay_used.begin());
@@ -1090,9 +1418,9 @@ int run_eix(int argc, char** argv) {
 			}
 		}
 		format->set_overlay_translations(&overlay_num);
-		for(PackageList::iterator it(matches.begin());
-			likely(it != matches.end()); ++it) {
-			if(format->print(*it, &header, &varpkg_db, &portagesettings, &stability, reached_limit)) {
+		for(PackageList::iterator it(matches->begin());
+			likely(it != matches->end()); ++it) {
+			if(format->print(*it, header, varpkg_db, portagesettings, stability, reached_limit)) {
 				have_printed = true;
 				++count;
 				if(unlikely(reached_limit)) {
@@ -1108,7 +1436,7 @@ int run_eix(int argc, char** argv) {
 	}
 	bool printed_overlay(false);
 	if(need_overlay_table) {
-		if(print_overlay_table(format, &header,
+		if(print_overlay_table(format, header,
 			(overlay_mode <= mode_list_used)? &overlay_used : NULLPTR)) {
 			printed_overlay = have_printed = true;
 		}
@@ -1119,7 +1447,7 @@ int run_eix(int argc, char** argv) {
 	}
 
 	if(!only_printed) {
-		count = matches.size();
+		count = matches->size();
 	}
 	eix::SignedBool print_count_always(rc_options.pure_packages ? -1 :
 		eixrc.getBoolText("PRINT_COUNT_ALWAYS", "never"));
@@ -1156,14 +1484,192 @@ int run_eix(int argc, char** argv) {
 		}
 	}
 
-	// Delete matches (or all_packages, respectively)
-	if(unlikely(rc_options.test_unused)) {
-		all_packages.delete_and_clear();
-		matches.clear();
+	return count;
+}
+
+/**
+A query of --batch
+**/
+class BatchQuery {
+	public:
+		string line;
+		WordVec args;
+		MatchTree *matchtree;
+		MaskList<Mask> *marked_list;
+		PackageList matches;  ///< The packages are owned by run_batch()
+
+		explicit BatchQuery(const string& l) : line(l), matchtree(NULLPTR), marked_list(NULLPTR) {
+		}
+
+		~BatchQuery() {
+			delete matchtree;
+			delete marked_list;
+		}
+};
+
+typedef eix::ptr_container<vector<BatchQuery *> > BatchQueries;
+
+/**
+Read the queries of --batch; empty lines and lines starting with # are
+ignored. A # elsewhere belongs to the query (e.g. to a regular expression).
+**/
+static bool read_batch(const char *file, LineVec *lines, string *errtext) {
+	LineVec raw;
+	if((file[0] != '-') || (file[1] != '\0')) {
+		if(unlikely(!pushback_lines(file, &raw, false, false, 1, errtext))) {
+			return false;
+		}
 	} else {
-		matches.delete_and_clear();
+		while(likely(std::cin.good())) {
+			string line;
+			getline(std::cin, line);
+			raw.PUSH_BACK(MOVE(line));
+		}
+	}
+	for(LineVec::iterator it(raw.begin()); likely(it != raw.end()); ++it) {
+		trim(&(*it));
+		if(likely(!it->empty()) && likely((*it)[0] != '#')) {
+			lines->PUSH_BACK(MOVE(*it));
+		}
+	}
+	return true;
+}
+
+/**
+The global variables which can be set by options.
+The options in the lines of --batch must not change them.
+**/
+class SavedOptions {
+	private:
+		LocalOptions m_rc_options;
+		const char *m_formatstring, *m_eix_cachefile, *m_var_to_print, *m_batch_file, *m_color;
+		bool m_no_color, m_style_version_lines, m_slot_sorted;
+
+	public:
+		SavedOptions() :
+			m_rc_options(rc_options),
+			m_formatstring(formatstring),
+			m_eix_cachefile(eix_cachefile),
+			m_var_to_print(var_to_print),
+			m_batch_file(batch_file),
+			m_color(color),
+			m_no_color(format->no_color),
+			m_style_version_lines(format->style_version_lines),
+			m_slot_sorted(format->slot_sorted) {
+		}
+
+		void restore() const {
+			rc_options = m_rc_options;
+			formatstring = m_formatstring;
+			eix_cachefile = m_eix_cachefile;
+			var_to_print = m_var_to_print;
+			batch_file = m_batch_file;
+			color = m_color;
+			format->no_color = m_no_color;
+			format->style_version_lines = m_style_version_lines;
+			format->slot_sorted = m_slot_sorted;
+		}
+};
+
+/**
+Answer all queries of --batch in a single pass over the database.
+Only packages matching the expression of the command line are considered.
+**/
+static int run_batch(Database *db, DBHeader *header, VarDbPkg *varpkg_db, PortageSettings *portagesettings, SetStability *stability, MatchTree *matchtree, bool only_printed, bool is_tty) {
+	EixRc& eixrc(get_eixrc());
+	LineVec lines; {
+		string errtext;
+		if(unlikely(!read_batch(batch_file, &lines, &errtext))) {
+			eix::say_error() % errtext;
+			return EXIT_FAILURE;
+		}
 	}
-	delete marked_list;
+
+	// Parse each line into its own matchtree; options in the lines are ignored
+	begin_phase("parse batch");
+	BatchQueries queries;
+	EixOptionList option_list;
+	SavedOptions saved_options;
+	for(LineVec::const_iterator it(lines.begin()); likely(it != lines.end()); ++it) {
+		BatchQuery *query(new BatchQuery(*it));
+		queries.PUSH_BACK(query);
+		split_string(&(query->args), *it, true, spaces);
+		vector<const char *> argv;
+		argv.PUSH_BACK(program_name);
+		for(WordVec::const_iterator arg(query->args.begin());
+			likely(arg != query->args.end()); ++arg) {
+			argv.PUSH_BACK(arg->c_str());
+		}
+		ArgumentReader argreader(static_cast<int>(argv.size()), &(argv[0]), option_list);
+		saved_options.restore();
+		query->matchtree = new MatchTree(eixrc.getBool("DEFAULT_IS_OR"));
+		parse_cli(query->matchtree, &eixrc, varpkg_db, portagesettings, format, stability, header, parse_error, &(query->marked_list), argreader);
+	}
+
+	begin_phase("match");
+	PackageList packages;  // owns the packages of all queries
+	{
+		PackageReader reader(db, *header, portagesettings);
+		vector<BatchQuery *> hits;
+		while(likely(reader.next())) {
+			hits.clear();
+			if(likely(matchtree->match(&reader))) {
+				for(BatchQueries::iterator it(queries.begin());
+					likely(it != queries.end()); ++it) {
+					if(it->matchtree->match(&reader)) {
+						hits.PUSH_BACK(*it);
+					}
+				}
+			}
+			if(likely(hits.empty())) {
+				if(unlikely(!reader.skip())) {
+					break;
+				}
+				continue;
+			}
+			Package *release(reader.release());
+			if(unlikely(release == NULLPTR)) {
+				break;
+			}
+			packages.PUSH_BACK(release);
+			for(vector<BatchQuery *>::iterator it(hits.begin());
+				likely(it != hits.end()); ++it) {
+				(*it)->matches.PUSH_BACK(release);
+			}
+		}
+		const char *err_cstr(reader.get_errtext());
+		if(unlikely(err_cstr != NULLPTR)) {
+			eix::say_error() % err_cstr;
+			packages.delete_and_clear();
+			return EXIT_FAILURE;
+		}
+	}
+
+	begin_phase("output");
+	PackageList::size_type count(0);
+	BatchQueries::size_type index(0);
+	for(BatchQueries::iterator it(queries.begin());
+		likely(it != queries.end()); ++it) {
+		if(likely(!rc_options.be_quiet)) {
+			eix::say("%s--- %s: %s%s")
+				% format->color_numbertext
+				% (++index)
+				% it->line
+				% format->color_numbertextend;
+		}
+		count += print_matches(&(it->matches), header, varpkg_db, portagesettings, stability, it->marked_list, only_printed, is_tty);
+	}
+	if(unlikely(rc_options.stats)) {
+		print_stats(matchtree);
+		index = 0;
+		for(BatchQueries::const_iterator it(queries.begin());
+			likely(it != queries.end()); ++it) {
+			eix::say_error(_("query %s: %s")) % (++index) % it->line;
+			it->matchtree->print_stats();
+		}
+	}
+	queries.delete_and_clear();
+	packages.delete_and_clear();
 
 	if(unlikely(!count)) {
 GCC_DIAG_OFF(sign-conversion)
@@ -1176,7 +1682,71 @@ GCC_DIAG_OFF(sign-conversion)
 GCC_DIAG_ON(sign-conversion)
 	}
 	return EXIT_SUCCESS;
-}  // NOLINT(readability/fn_size)
+}
+
+static bool is_server_call(int argc, char *argv[]) {
+	for(int i(1); likely(i < argc); ++i) {
+		if(unlikely(std::strcmp(argv[i], "--server") == 0)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+(Re)load the resident data if the database, the eixrc files, or some file
+or directory read for the portage settings has changed
+**/
+static void server_prepare() {
+	if(likely(resident->portagesettings != NULLPTR) &&
+		likely(!resident->stamps.changed())) {
+		return;
+	}
+	resident->clear();
+	resident->stamps.clear();
+	FileStamps::recording = &(resident->stamps);
+	resident->stamps.add(resident->cachefile.c_str());
+	EixRc& eixrc(get_eixrc());
+	eixrc.reread();
+	resident->parse_error = new ParseError(rc_options.no_warn);
+	resident->portagesettings = new PortageSettings(&eixrc, resident->parse_error, true, false, false);
+	resident->portagesettings->freeze();
+	FileStamps::recording = NULLPTR; {
+		Database file;
+		if(unlikely(!file.openread(resident->cachefile.c_str())) ||
+			unlikely(!file.read_rest(&(resident->database)))) {
+			resident->database.clear();
+			return;
+		}
+	}
+	Database db;
+	db.openmem(resident->database.data(),
+		static_cast<eix::OffsetType>(resident->database.size()));
+	DBHeader *header(new DBHeader);
+	if(likely(db.read_header(header, NULLPTR, 0))) {
+		resident->header = header;
+		resident->header_end = db.tell();
+	} else {
+		delete header;
+		resident->database.clear();
+	}
+}
+
+static int run_server(const string& cachefile) {
+	// The same source as for the client in run_eix()
+	const char *path(std::getenv("EIX_SERVER"));
+	if(unlikely((path == NULLPTR) || (*path == '\0'))) {
+		eix::say_error(_("--server needs EIX_SERVER to be set"));
+		return EXIT_FAILURE;
+	}
+	resident = new EixResident(cachefile);
+	string errtext;
+	server_run(path, server_prepare, run_eix_args, &errtext);
+	eix::say_error() % errtext;
+	delete resident;
+	resident = NULLPTR;
+	return EXIT_FAILURE;
+}
 
 static bool opencache(Database *db, const char *filename, const char *tooltext) {
 	if(likely(db->openread(filename))) {
@@ -1206,27 +1776,105 @@ static void print_wordvec(const WordVec& vec) {
 	eix::say("--");
 }
 
-static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist, bool test_empty) {
+/**
+@return true if the mask pattern contains wildcards for fnmatch()
+**/
+static bool has_wildcards(const char *pattern) {
+	return (std::strpbrk(pattern, "*?[\\") != NULLPTR);
+}
+
+/**
+@return true if m matches some package in [first, last)
+**/
+bool UnusedIndex::matches_range(const Mask& m, PackageIndex::size_type first, PackageIndex::size_type last) const {
+	const char *name(m.getName());
+	if(likely(!has_wildcards(name))) {
+		PackageIndex::size_type i(m_packages.find(m_packages.category(first), name));
+		return ((i != m_packages.size()) && m_packages.ismatch(m, i));
+	}
+	for(; likely(first != last); ++first) {
+		if(m_packages.ismatch(m, first)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void UnusedIndex::init_names() {
+	m_have_names = true;
+	for(PackageIndex::size_type i(0); likely(i != m_packages.size()); ++i) {
+		m_names[m_packages.name(i)].PUSH_BACK(i);
+	}
+}
+
+/**
+Only categories and names matching the mask are looked at.
+**/
+bool UnusedIndex::matches(const Mask& m) {
+	const char *cat(m.getCategory());
+	if(likely(!has_wildcards(cat))) {
+		PackageIndex::size_type first, last;
+		m_packages.find_category(cat, &first, &last);
+		return ((first != last) && matches_range(m, first, last));
+	}
+	const char *name(m.getName());
+	if(!has_wildcards(name)) {
+		if(unlikely(!m_have_names)) {
+			init_names();
+		}
+		NameIndex::const_iterator found(m_names.find(name));
+		if(found == m_names.end()) {
+			return false;
+		}
+		for(Packages::const_iterator it(found->second.begin());
+			likely(it != found->second.end()); ++it) {
+			if(m_packages.ismatch(m, *it)) {
+				return true;
+			}
+		}
+		return false;
+	}
+	PackageIndex::size_type first(0), last;
+	for(; likely(first != m_packages.size()); first = last) {
+		const string& category(m_packages.category(first));
+		m_packages.find_category(category, &first, &last);
+		if((fnmatch(cat, category.c_str(), 0) == 0) &&
+			matches_range(m, first, last)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+const WordSet& UnusedIndex::excludes(const string& excludefiles) {
+	ExcludesCache::const_iterator found(m_excludes.find(excludefiles));
+	if(found != m_excludes.end()) {
+		return found->second;
+	}
+	WordSet& excludes(m_excludes[excludefiles]);
+	WordVec excludelist;
+	split_string(&excludelist, excludefiles, true);
+	for(WordVec::const_iterator it(excludelist.begin());
+		likely(it != excludelist.end()); ++it) {
+		LineVec excl;
+		pushback_lines(it->c_str(), &excl, true, false);
+		join_and_split(&excludes, excl);
+	}
+	return excludes;
+}
+
+static void print_unused(const string& filename, const string& excludefiles, UnusedIndex *index, bool test_empty) {
 	WordVec unused;
 	LineVec lines;
-	WordSet excludes;
-	bool know_excludes(false);
+	const WordSet *excludes(NULLPTR);
 	pushback_lines(filename.c_str(), &lines, true);
 	for(WordVec::iterator i(lines.begin());
 		likely(i != lines.end()); ++i) {
 		if(i->empty()) {
 			continue;
 		}
-		if(unlikely(!know_excludes)) {
-			know_excludes = true;
-			WordVec excludelist;
-			split_string(&excludelist, excludefiles, true);
-			for(WordVec::const_iterator it(excludelist.begin());
-				likely(it != excludelist.end()); ++it) {
-				LineVec excl;
-				pushback_lines(it->c_str(), &excl, true, false);
-				join_and_split(&excludes, excl);
-			}
+		if(unlikely(excludes == NULLPTR)) {
+			excludes = &(index->excludes(excludefiles));
 		}
 
 		string::size_type n(i->find_first_of("\t "));
@@ -1234,7 +1882,7 @@ static void print_unused(const string& filename, const string& excludefiles, con
 		string errtext;
 		KeywordMask m;
 		if(n == string::npos) {
-			if(unlikely(excludes.count(*i) != 0)) {
+			if(unlikely(excludes->count(*i) != 0)) {
 				continue;
 			}
 			if(unlikely(test_empty)) {
@@ -1244,7 +1892,7 @@ static void print_unused(const string& filename, const string& excludefiles, con
 			r = m.parseMask(i->c_str(), &errtext, false);
 		} else {
 			string it(*i, 0, n);
-			if(excludes.count(it) != 0) {
+			if(excludes->count(it) != 0) {
 				continue;
 			}
 			r = m.parseMask(it.c_str(), &errtext, false);
@@ -1253,13 +1901,7 @@ static void print_unused(const string& filename, const string& excludefiles, con
 			parse_error->output(filename, lines.begin(), i, errtext);
 			continue;
 		}
-		PackageList::const_iterator pi(packagelist.begin());
-		for( ; likely(pi != packagelist.end()); ++pi) {
-			if(m.ismatch(**pi)) {
-				break;
-			}
-		}
-		if(pi != packagelist.end()) {
+		if(index->matches(m)) {
 			continue;
 		}
 		unused.PUSH_BACK(MOVE(*i));
@@ -1278,21 +1920,12 @@ static void print_unused(const string& filename, const string& excludefiles, con
 	print_wordvec(unused);
 }
 
-static void print_removed(const string& dirname, const string& excludefiles, const PackageList& packagelist) {
-	/* For faster testing, we build a category->name map */
-	typedef UNORDERED_MAP<string, WordUnorderedSet> CatName;
-	CatName cat_name;
-	for(PackageList::const_iterator pit(packagelist.begin());
-		likely(pit != packagelist.end()); ++pit) {
-		cat_name[pit->category].INSERT(pit->name);
-	}
-
+static void print_removed(const string& dirname, const string& excludefiles, const PackageIndex& packages, UnusedIndex *index) {
 	/* This will contain categories/packages to be printed */
 	WordVec failure;
 
 	/* Read all installed packages (not versions!) and fill failures */
-	WordSet excludes;
-	bool know_excludes(false);
+	const WordSet *excludes(NULLPTR);
 	WordVec categories;
 	pushback_files(dirname, &categories, NULLPTR, 2, true, false);
 	for(WordVec::const_iterator cit(categories.begin());
@@ -1301,29 +1934,19 @@ static void print_removed(const string& dirname, const string& excludefiles, con
 		string cat_slash(*cit);
 		cat_slash.append(1, '/');
 		pushback_files(dirname + cat_slash, &names, NULLPTR, 2, true, false);
-		CatName::const_iterator cat(cat_name.find(*cit));
-		const WordIterateSet *ns((cat == cat_name.end()) ? NULLPTR : &(cat->second));
 		for(WordVec::const_iterator nit(names.begin());
 			likely(nit != names.end()); ++nit) {
 			string curr_name;
 			if(unlikely(!ExplodeAtom::split_name(&curr_name, nit->c_str()))) {
 				continue;
 			}
-			if(unlikely((ns == NULLPTR) || (ns->count(curr_name) == 0))) {
-				if(unlikely(!know_excludes)) {
-					know_excludes = true;
-					WordVec excludelist;
-					split_string(&excludelist, excludefiles, true);
-					for(WordVec::const_iterator it(excludelist.begin());
-						likely(it != excludelist.end()); ++it) {
-						LineVec excl;
-						pushback_lines(it->c_str(), &excl, true, false);
-						join_and_split(&excludes, excl);
-					}
+			if(unlikely(packages.find(*cit, curr_name) == packages.size())) {
+				if(unlikely(excludes == NULLPTR)) {
+					excludes = &(index->excludes(excludefiles));
 				}
-				if(likely(excludes.count(curr_name) == 0)) {
+				if(likely(excludes->count(curr_name) == 0)) {
 					string fullname(cat_slash + curr_name);
-					if(excludes.count(fullname) == 0) {
+					if(excludes->count(fullname) == 0) {
 						failure.PUSH_BACK(MOVE(fullname));
 					}
 				}
@@ -15,11 +15,13 @@
 #include <string>
 #include <vector>
 
+#include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
 
 using std::string;
 
@@ -27,60 +29,100 @@ using std::string;
 
 namespace eix {
 
-const FormatManip::ArgType
-	FormatManip::NONE,
-	FormatManip::STRING,
-	FormatManip::DIGIT,
-	FormatManip::BOTH;
+const FormatTemplate::ArgType
+	FormatTemplate::NONE,
+	FormatTemplate::STRING,
+	FormatTemplate::DIGIT,
+	FormatTemplate::BOTH;
 
-void format::bad_format() const {
+/**
+The number of format strings to keep parsed (per kind of cache)
+**/
+#define FORMAT_CACHE_MAX 512
+
+void FormatTemplate::bad_format() const {
 	eix::say_error(_("internal error: bad format specification \"%s\""))
-		% m_text;
+		% m_format;
 	std::exit(EXIT_FAILURE);
 }
 
-#ifdef EIX_DEBUG_FORMAT
-void format::too_few_arguments() const {
-	eix::say_error(_("internal error: too few arguments passed for \"%s\""))
-		% m_text;
-	std::exit(EXIT_FAILURE);
+const FormatTemplate *FormatTemplate::get(const char *format_string, FormatTemplate *own) {
+	// Format strings are mostly literals or translations thereof.
+	// Since other pointers might be reused for different strings,
+	// a hit is only accepted if also the content is the same.
+	typedef UNORDERED_MAP<const char *, FormatTemplate *> PointerCache;
+	static PointerCache *cache(NULLPTR);
+	if(unlikely(cache == NULLPTR)) {
+		cache = new PointerCache;
+	}
+	PointerCache::const_iterator it(cache->find(format_string));
+	if(likely(it != cache->end())) {
+		if(likely(it->second->m_format == format_string)) {
+			return it->second;
+		}
+	} else if(cache->size() < FORMAT_CACHE_MAX) {
+		FormatTemplate *t(new FormatTemplate);
+		t->m_format = format_string;
+		t->parse();
+		(*cache)[format_string] = t;
+		return t;
+	}
+	own->m_format = format_string;
+	own->parse();
+	return NULLPTR;
 }
 
-void format::too_many_arguments() const {
-	eix::say_error(_("internal error: too many arguments passed for \"%s\""))
-		% m_text;
-	std::exit(EXIT_FAILURE);
+const FormatTemplate *FormatTemplate::get(const string& format_string, FormatTemplate *own) {
+	typedef UNORDERED_MAP<string, FormatTemplate *> StringCache;
+	static StringCache *cache(NULLPTR);
+	if(unlikely(cache == NULLPTR)) {
+		cache = new StringCache;
+	}
+	StringCache::const_iterator it(cache->find(format_string));
+	if(likely(it != cache->end())) {
+		return it->second;
+	}
+	if(cache->size() < FORMAT_CACHE_MAX) {
+		FormatTemplate *t(new FormatTemplate);
+		t->m_format = format_string;
+		t->parse();
+		(*cache)[format_string] = t;
+		return t;
+	}
+	own->m_format = format_string;
+	own->parse();
+	return NULLPTR;
 }
-#endif
 
-void format::init() {
-	simple = false;
-	current = 0;
-	FormatManip::ArgCount imp(0);
-	string::size_type i(0);
-	while(i = m_text.find('%', i), likely(i != string::npos)) {
-		string::size_type start(i), len(2);
+void FormatTemplate::parse() {
+	parts.clear();
+	wanted.clear();
+	tail.clear();
+	in_order = true;
+	ArgCount imp(0);
+	const string& text(m_format);
+	string::size_type prev(0), i(0);
+	// literal text collected so far (with %% already replaced)
+	string literal;
+	while(i = text.find('%', i), likely(i != string::npos)) {
+		literal.append(text, prev, i - prev);
 		++i;
-		if(unlikely(i == m_text.size())) {
+		if(unlikely(i == text.size())) {
 			bad_format();
 		}
-		char c(m_text[i]);
+		char c(text[i]);
 		if(c == '%') {
-			m_text.erase(start, len);
-			if(likely(start != m_text.size())) {
-				i = start;
-				continue;
-			}
-			break;
+			literal.append(1, '%');
+			prev = ++i;
+			continue;
 		}
 		ArgCount argnum(imp++);
 		if(my_isdigit(c)) {
-			string::size_type e(m_text.find('$', i));
+			string::size_type e(text.find('$', i));
 			if(unlikely(e == string::npos)) {
 				bad_format();
 			}
-			len += e - start;
-			string number(m_text, i, e - i);
+			string number(text, i, e - i);
 			if(unlikely(!is_numeric(number.c_str()))) {
 				bad_format();
 			}
@@ -89,69 +131,137 @@ void format::init() {
 				bad_format();
 			}
 			--argnum;
-			++e;
-			if(unlikely(e == m_text.size())) {
+			i = e + 1;
+			if(unlikely(i == text.size())) {
 				bad_format();
 			}
-			c = m_text[e];
+			c = text[i];
 		}
 		ArgType typ;
 #ifdef EIX_DEBUG_FORMAT
 		switch(c) {
 			case 's':
-				typ = FormatManip::STRING;
+				typ = STRING;
 				break;
 			case 'd':
-				typ = FormatManip::DIGIT;
+				typ = DIGIT;
 				break;
 			default:
 				bad_format();
 				break;
 		}
 #else
-		typ = ((c == 's') ? FormatManip::STRING : FormatManip::DIGIT);
+		typ = ((c == 's') ? STRING : DIGIT);
 #endif
 		if(likely(argnum == wanted.size())) {
 			wanted.PUSH_BACK(typ);
 		} else if(argnum > wanted.size()) {
-			wanted.insert(wanted.end(), argnum - wanted.size() + 1, FormatManip::NONE);
+			wanted.insert(wanted.end(), argnum - wanted.size() + 1, NONE);
 			wanted[argnum] = typ;
 		} else {
 			wanted[argnum] |= typ;
 		}
-		manip.EMPLACE_BACK(FormatManip, (start, argnum, typ));
-		m_text.erase(start, len);
-		i = start;
-		if(i == m_text.size()) {
-			break;
+		if(argnum != parts.size()) {
+			in_order = false;
 		}
+		parts.EMPLACE_BACK(Part, (literal, argnum, typ));
+		literal.clear();
+		prev = ++i;
+	}
+	literal.append(text, prev, string::npos);
+	tail.swap(literal);
+	if(wanted.size() != parts.size()) {
+		in_order = false;
 	}
-	if(unlikely(wanted.empty())) {
-		finalize();
+}
+
+#ifdef EIX_DEBUG_FORMAT
+void format::too_few_arguments() const {
+	eix::say_error(_("internal error: too few arguments passed for \"%s\""))
+		% tmpl().m_format;
+	std::exit(EXIT_FAILURE);
+}
+
+void format::too_many_arguments() const {
+	eix::say_error(_("internal error: too many arguments passed for \"%s\""))
+		% tmpl().m_format;
+	std::exit(EXIT_FAILURE);
+}
+#endif
+
+void format::append_unsigned(string *dest, unsigned long t) {
+	char buf[3 * sizeof(t) + 1];
+	char *p(buf + sizeof(buf));
+	do {
+		*(--p) = static_cast<char>('0' + (t % 10));
+		t /= 10;
+	} while(t != 0);
+GCC_DIAG_OFF(sign-conversion)
+	dest->append(p, buf + sizeof(buf) - p);
+GCC_DIAG_ON(sign-conversion)
+}
+
+void format::append_signed(string *dest, long t) {
+	if(t >= 0) {
+		append_unsigned(dest, static_cast<unsigned long>(t));
+		return;
+	}
+	dest->append(1, '-');
+	// Negate only after the conversion to avoid an overflow
+	append_unsigned(dest, 0UL - static_cast<unsigned long>(t));
+}
+
+void format::init(const char *format_string) {
+	m_cached = FormatTemplate::get(format_string, &m_own);
+	start();
+}
+
+void format::init(const string& format_string) {
+	m_cached = FormatTemplate::get(format_string, &m_own);
+	start();
+}
+
+void format::start() {
+	simple = false;
+	current = 0;
+	const FormatTemplate& t(tmpl());
+	if(unlikely(t.wanted.empty())) {
+		text().append(t.tail);
+		m_pending = false;
+		newline_output();
+		return;
+	}
+	m_pending = true;
+	if(likely(t.in_order)) {
+		text().append(t.parts[0].text);
 	} else {
-		args.insert(args.end(), wanted.size(), FormatReplace());
+		args.insert(args.end(), t.wanted.size(), FormatReplace());
 	}
 }
 
 void format::finalize() {
-	for(std::vector<FormatManip>::const_reverse_iterator it(manip.rbegin());
-		it != manip.rend(); ++it) {
-		m_text.insert(it->m_index, (it->m_type ?
-			args[it->argnum].s : args[it->argnum].d));
+	const FormatTemplate& t(tmpl());
+	string& dest(text());
+	for(std::vector<FormatTemplate::Part>::const_iterator it(t.parts.begin());
+		it != t.parts.end(); ++it) {
+		dest.append(it->text);
+		dest.append(it->string_type ?
+			args[it->argnum].s : args[it->argnum].d);
 	}
-	manip.clear();
-	wanted.clear();
+	dest.append(t.tail);
 	args.clear();
+	m_pending = false;
 	newline_output();
 }
 
 void format::newline_output() {
+	string& dest(text());
 	if(add_newline) {
-		m_text.append(1, '\n');
+		dest.append(1, '\n');
 	}
 	if(output != NULLPTR) {
-		if(likely(!m_text.empty())) {
-			std::fwrite(m_text.c_str(), sizeof(char),  m_text.size(), output);
+		if(likely(!dest.empty())) {
+			std::fwrite(dest.c_str(), sizeof(char),  dest.size(), output);
 		}
 		if(unlikely(do_flush)) {
 			std::fflush(output);
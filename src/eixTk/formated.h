@@ -87,7 +87,7 @@ Example usage:
 \endcode
 **/
 
-class FormatManip {
+class FormatTemplate {
 	protected:
 		friend class format;
 
@@ -98,16 +98,47 @@ class FormatManip {
 			DIGIT  = 0x02,
 			BOTH   = (STRING|DIGIT);
 
-		typedef bool ManipType;
 		typedef std::vector<ArgType>::size_type ArgCount;
-		std::string::size_type m_index;
-		ArgCount argnum;
-		ManipType m_type;  // true if string desired
+
+		/**
+		A placeholder together with the literal text in front of it
+		**/
+		class Part {
+			public:
+				std::string text;
+				ArgCount argnum;
+				bool string_type;  // true if string desired
+
+				Part(const std::string& t, ArgCount anum, ArgType typ) :
+					text(t), argnum(anum), string_type((typ & DIGIT) == NONE) {
+				}
+		};
+
+		/**
+		The unparsed format string (for verifying cache hits and diagnostics)
+		**/
+		std::string m_format;
+		std::vector<Part> parts;
+		std::string tail;
+		std::vector<ArgType> wanted;
+
+		/**
+		true if the placeholders use the arguments exactly once and in order.
+		Then the arguments can be appended immediately without storing them.
+		**/
+		bool in_order;
+
+		void parse();
+
+		ATTRIBUTE_NORETURN void bad_format() const;
 
 	public:
-		FormatManip(std::string::size_type ind, ArgCount anum, ArgType typ) NOEXCEPT :
-			m_index(ind), argnum(anum), m_type((typ & DIGIT) == NONE) {  // NOLINT(runtime/references)
-		}
+		/**
+		@return a parsed template from the cache, or NULLPTR if
+		format_string was parsed into own instead
+		**/
+		ATTRIBUTE_NONNULL_ static const FormatTemplate *get(const char *format_string, FormatTemplate *own);
+		ATTRIBUTE_NONNULL_ static const FormatTemplate *get(const std::string& format_string, FormatTemplate *own);
 };
 
 class FormatReplace {
@@ -118,45 +149,114 @@ class FormatReplace {
 
 class format {
 	protected:
-		typedef FormatManip::ArgType ArgType;
-		typedef FormatManip::ArgCount ArgCount;
+		typedef FormatTemplate::ArgType ArgType;
+		typedef FormatTemplate::ArgCount ArgCount;
 		bool simple;  // true only if no formatstring given. Set to false as a flag if first argument is passed
 		bool add_newline, do_flush;
 		FILE *output;
+
+		/**
+		The caller's buffer for the result or NULLPTR
+		**/
+		std::string *m_dest;
+
+		/**
+		The parsed format string: m_own if m_cached is NULLPTR.
+		The template is in use as long as arguments are missing.
+		**/
+		const FormatTemplate *m_cached;
+		FormatTemplate m_own;
+		bool m_pending;
+
 		/**
 		The currently parsed args
 		**/
 		ArgCount current;
+
+		/**
+		The args are only stored if the template is not in_order
+		**/
 		std::vector<FormatReplace> args;
-		std::vector<ArgType> wanted;
 
 		/**
-		The format string or result
+		The result (unless m_dest is used)
 		**/
 		std::string m_text;
-		std::vector<FormatManip> manip;
 
-		ATTRIBUTE_NORETURN void bad_format() const;
 #ifdef EIX_DEBUG_FORMAT
 		ATTRIBUTE_NORETURN void too_few_arguments() const;
 		ATTRIBUTE_NORETURN void too_many_arguments() const;
 #endif
 
+		std::string& text() {
+			return ((m_dest == NULLPTR) ? m_text : *m_dest);
+		}
+
+		const FormatTemplate& tmpl() const {
+			return ((m_cached == NULLPTR) ? m_own : *m_cached);
+		}
+
+		ATTRIBUTE_NONNULL_ static void append_unsigned(std::string *dest, unsigned long t);
+		ATTRIBUTE_NONNULL_ static void append_signed(std::string *dest, long t);
+
 		/**
-		Write size_type or "<string::npos>" to stream
+		Append the representation of t to dest. Common types are appended
+		directly; other types use the <<-operator of std::ostream.
 		**/
-		static std::ostream& write_representation(std::ostream& s, const std::string::size_type& t) {  // NOLINT(runtime/references)
+		ATTRIBUTE_NONNULL_ static void append_value(std::string *dest, const std::string& t) {
+			dest->append(t);
+		}
+
+		ATTRIBUTE_NONNULL_ static void append_value(std::string *dest, const char *t) {
+			dest->append(t);
+		}
+
+		ATTRIBUTE_NONNULL_ static void append_value(std::string *dest, char *t) {
+			dest->append(t);
+		}
+
+		ATTRIBUTE_NONNULL_ static void append_value(std::string *dest, char t) {
+			dest->append(1, t);
+		}
+
+		ATTRIBUTE_NONNULL_ static void append_value(std::string *dest, int t) {
+			append_signed(dest, t);
+		}
+
+		ATTRIBUTE_NONNULL_ static void append_value(std::string *dest, long t) {
+			append_signed(dest, t);
+		}
+
+		ATTRIBUTE_NONNULL_ static void append_value(std::string *dest, unsigned int t) {
+			append_unsigned(dest, t);
+		}
+
+		ATTRIBUTE_NONNULL_ static void append_value(std::string *dest, unsigned long t) {
+			append_unsigned(dest, t);
+		}
+
+		template<typename T> ATTRIBUTE_NONNULL_ static void append_value(std::string *dest, const T& t) {
+			std::ostringstream os;
+			os << t;
+			dest->append(os.str());
+		}
+
+		/**
+		Append size_type or "<string::npos>" to dest
+		**/
+		ATTRIBUTE_NONNULL_ static void append_digit(std::string *dest, const std::string::size_type& t) {
 			if(t == std::string::npos) {
-				return (s << "<string::npos>");
+				dest->append("<string::npos>");
+				return;
 			}
-			return (s << t);
+			append_value(dest, t);
 		}
 
 		/**
-		Write t into stream s
+		Append t to dest
 		**/
-		template<typename T> static std::ostream& write_representation(std::ostream& s, const T& t) {  // NOLINT(runtime/references)
-			return s << t;
+		template<typename T> ATTRIBUTE_NONNULL_ static void append_digit(std::string *dest, const T& t) {
+			append_value(dest, t);
 		}
 
 		void finalize();
@@ -164,93 +264,107 @@ class format {
 		void newline_output();
 
 		/**
-		Set the template string. Set simple = false
+		Parse the template string. Set simple = false
 		**/
-		void init();
+		void init(const char *format_string);
+		void init(const std::string& format_string);
+		void start();
 
 	public:
-		format(FILE *stream, const std::string& format_string, bool newline, bool flush) : add_newline(newline), do_flush(flush), output(stream), m_text(format_string) {
-			init();
+		format(FILE *stream, const std::string& format_string, bool newline, bool flush) : add_newline(newline), do_flush(flush), output(stream), m_dest(NULLPTR) {
+			init(format_string);
 		}
 
-		format(FILE *stream, const char *format_string, bool newline, bool flush) : add_newline(newline), do_flush(flush), output(stream), m_text(format_string) {
-			init();
+		format(FILE *stream, const char *format_string, bool newline, bool flush) : add_newline(newline), do_flush(flush), output(stream), m_dest(NULLPTR) {
+			init(format_string);
 		}
 
-		format(FILE *stream, char format_char, bool newline, bool flush) : simple(false), add_newline(newline), do_flush(flush), output(stream), m_text(1, format_char) {
+		format(FILE *stream, char format_char, bool newline, bool flush) : simple(false), add_newline(newline), do_flush(flush), output(stream), m_dest(NULLPTR), m_cached(NULLPTR), m_pending(false), m_text(1, format_char) {
 			newline_output();
 		}
 
-		format(FILE *stream, const std::string& format_string, bool newline) : add_newline(newline), do_flush(false), output(stream), m_text(format_string) {
-			init();
+		format(FILE *stream, const std::string& format_string, bool newline) : add_newline(newline), do_flush(false), output(stream), m_dest(NULLPTR) {
+			init(format_string);
 		}
 
-		format(FILE *stream, const char *format_string, bool newline) : add_newline(newline), do_flush(false), output(stream), m_text(format_string) {
-			init();
+		format(FILE *stream, const char *format_string, bool newline) : add_newline(newline), do_flush(false), output(stream), m_dest(NULLPTR) {
+			init(format_string);
 		}
 
-		format(FILE *stream, char format_char, bool newline) : simple(false), add_newline(newline), do_flush(false), output(stream), m_text(1, format_char) {
+		format(FILE *stream, char format_char, bool newline) : simple(false), add_newline(newline), do_flush(false), output(stream), m_dest(NULLPTR), m_cached(NULLPTR), m_pending(false), m_text(1, format_char) {
 			newline_output();
 		}
 
-		format(FILE *stream, const std::string& format_string) : add_newline(false), do_flush(false), output(stream), m_text(format_string) {
-			init();
+		format(FILE *stream, const std::string& format_string) : add_newline(false), do_flush(false), output(stream), m_dest(NULLPTR) {
+			init(format_string);
 		}
 
-		format(FILE *stream, const char *format_string) : add_newline(false), do_flush(false), output(stream), m_text(format_string) {
-			init();
+		format(FILE *stream, const char *format_string) : add_newline(false), do_flush(false), output(stream), m_dest(NULLPTR) {
+			init(format_string);
 		}
 
-		format(FILE *stream, char format_char) : simple(false), add_newline(false), do_flush(false), output(stream), m_text(1, format_char) {
+		format(FILE *stream, char format_char) : simple(false), add_newline(false), do_flush(false), output(stream), m_dest(NULLPTR), m_cached(NULLPTR), m_pending(false), m_text(1, format_char) {
 			newline_output();
 		}
 
-		format(const std::string& format_string, bool newline) : add_newline(newline), output(NULLPTR), m_text(format_string) {
-			init();
+		/**
+		Append the result to the caller's buffer dest instead of
+		constructing a new string
+		**/
+		ATTRIBUTE_NONNULL_ format(std::string *dest, const std::string& format_string) : add_newline(false), do_flush(false), output(NULLPTR), m_dest(dest) {
+			init(format_string);
+		}
+
+		ATTRIBUTE_NONNULL_ format(std::string *dest, const char *format_string) : add_newline(false), do_flush(false), output(NULLPTR), m_dest(dest) {
+			init(format_string);
 		}
 
-		format(const char *format_string, bool newline) : add_newline(newline), output(NULLPTR), m_text(format_string) {
-			init();
+		format(const std::string& format_string, bool newline) : add_newline(newline), output(NULLPTR), m_dest(NULLPTR) {
+			init(format_string);
 		}
 
-		format(char format_char, bool newline) : simple(false), add_newline(newline), output(NULLPTR), m_text(1, format_char) {
+		format(const char *format_string, bool newline) : add_newline(newline), output(NULLPTR), m_dest(NULLPTR) {
+			init(format_string);
+		}
+
+		format(char format_char, bool newline) : simple(false), add_newline(newline), output(NULLPTR), m_dest(NULLPTR), m_cached(NULLPTR), m_pending(false), m_text(1, format_char) {
 			newline_output();
 		}
 
-		explicit format(const std::string& format_string) : add_newline(false), output(NULLPTR), m_text(format_string) {
-			init();
+		explicit format(const std::string& format_string) : add_newline(false), output(NULLPTR), m_dest(NULLPTR) {
+			init(format_string);
 		}
 
-		explicit format(const char *format_string) : add_newline(false), output(NULLPTR), m_text(format_string) {
-			init();
+		explicit format(const char *format_string) : add_newline(false), output(NULLPTR), m_dest(NULLPTR) {
+			init(format_string);
 		}
 
-		explicit format(char format_char) : simple(false), add_newline(false), output(NULLPTR), m_text(1, format_char) {
+		explicit format(char format_char) : simple(false), add_newline(false), output(NULLPTR), m_dest(NULLPTR), m_cached(NULLPTR), m_pending(false), m_text(1, format_char) {
 		}
 
-		format(FILE *stream, bool newline, bool flush) : simple(true), add_newline(newline), do_flush(flush), output(stream) {
+		format(FILE *stream, bool newline, bool flush) : simple(true), add_newline(newline), do_flush(flush), output(stream), m_dest(NULLPTR), m_cached(NULLPTR), m_pending(false) {
 		}
 
-		format(FILE *stream, bool newline) : simple(true), add_newline(newline), do_flush(false), output(stream) {
+		format(FILE *stream, bool newline) : simple(true), add_newline(newline), do_flush(false), output(stream), m_dest(NULLPTR), m_cached(NULLPTR), m_pending(false) {
 		}
 
 		// Exceptional order in which case we use the empty string as default
-		format(bool newline, bool flush, FILE *stream) : simple(false), add_newline(newline), do_flush(flush), output(stream) {
+		format(bool newline, bool flush, FILE *stream) : simple(false), add_newline(newline), do_flush(flush), output(stream), m_dest(NULLPTR), m_cached(NULLPTR), m_pending(false) {
 			newline_output();
 		}
 
 		// Exceptional order in which case we use the empty string as default
-		format(bool newline, FILE *stream) : simple(false), add_newline(newline), do_flush(false), output(stream) {
+		format(bool newline, FILE *stream) : simple(false), add_newline(newline), do_flush(false), output(stream), m_dest(NULLPTR), m_cached(NULLPTR), m_pending(false) {
 			newline_output();
 		}
 
-		explicit format(FILE *stream) : simple(true), add_newline(false), do_flush(false), output(stream) {
+		explicit format(FILE *stream) : simple(true), add_newline(false), do_flush(false), output(stream), m_dest(NULLPTR), m_cached(NULLPTR), m_pending(false) {
 		}
 
-		explicit format(bool newline) : simple(true), add_newline(newline), output(NULLPTR) {
+		explicit format(bool newline) : simple(true), add_newline(newline), output(NULLPTR), m_dest(NULLPTR), m_cached(NULLPTR), m_pending(false) {
 		}
 
-		format() : simple(true), add_newline(false), output(NULLPTR) {
+		format() : simple(true), add_newline(false), output(NULLPTR), m_dest(NULLPTR), m_cached(NULLPTR), m_pending(false) {
 		}
 
 		/**
@@ -259,31 +373,42 @@ class format {
 		template<typename T> format& operator%(const T& s) {
 			if(simple) {
 				simple = false;
-				std::ostringstream os;
-				os << s;
-				m_text.append(os.str());
+				append_value(&text(), s);
 				newline_output();
 				return *this;
 			}
-			if(unlikely(manip.empty())) {
+			if(unlikely(!m_pending)) {
 #ifdef EIX_DEBUG_FORMAT
 				too_many_arguments();
 #else
 				return *this;
 #endif
 			}
-			ArgType c(wanted[current]);
-			if((c & FormatManip::STRING) != FormatManip::NONE) {
-				std::ostringstream os;
-				os << s;
-				args[current].s = os.str();
+			const FormatTemplate& t(tmpl());
+			if(likely(t.in_order)) {
+				std::string& dest(text());
+				if(t.parts[current].string_type) {
+					append_value(&dest, s);
+				} else {
+					append_digit(&dest, s);
+				}
+				if(unlikely(++current == t.parts.size())) {
+					dest.append(t.tail);
+					m_pending = false;
+					newline_output();
+				} else {
+					dest.append(t.parts[current].text);
+				}
+				return *this;
+			}
+			ArgType c(t.wanted[current]);
+			if((c & FormatTemplate::STRING) != FormatTemplate::NONE) {
+				append_value(&(args[current].s), s);
 			}
-			if((c & FormatManip::DIGIT) != FormatManip::NONE) {
-				std::ostringstream os;
-				write_representation(os, s);
-				args[current].d = os.str();
+			if((c & FormatTemplate::DIGIT) != FormatTemplate::NONE) {
+				append_digit(&(args[current].d), s);
 			}
-			if(unlikely(++current == wanted.size())) {
+			if(unlikely(++current == t.wanted.size())) {
 				finalize();
 			}
 			return *this;
@@ -294,11 +419,11 @@ class format {
 		**/
 		std::string str() const {
 #ifdef EIX_DEBUG_FORMAT
-			if(unlikely(simple || !manip.empty())) {
+			if(unlikely(simple || m_pending)) {
 				too_few_arguments();
 			}
 #endif
-			return m_text;
+			return ((m_dest == NULLPTR) ? m_text : *m_dest);
 		}
 
 		/**
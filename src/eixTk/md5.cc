@@ -20,11 +20,13 @@
 #include "eixTk/attribute.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
 #ifdef DEBUG_MD5
 #include "eixTk/formated.h"
 #endif
 #include "eixTk/inttypes.h"
 #include "eixTk/null.h"
+#include "eixTk/phasestats.h"
 
 using std::string;
 
@@ -257,13 +259,9 @@ static void debug_md5(const uint32_t *resarr) {
 }
 #endif
 
-bool verify_md5sum(const char *file, const string& md5sum) {
-	if(md5sum.size() != 32) {
-		return false;
-	}
-	if(md5sum.find_first_not_of("0123456789abcdefABCDEF") != string::npos) {
-		return false;
-	}
+ATTRIBUTE_NONNULL_ static bool calc_md5sum_file(const char *file, uint32_t *resarr);
+
+static bool calc_md5sum_file(const char *file, uint32_t *resarr) {
 	char *filebuffer(NULLPTR);
 	int fd(open(file, O_RDONLY));
 	if(fd == -1) {
@@ -279,6 +277,8 @@ GCC_DIAG_OFF(sign-conversion)
 		filesize = st.st_size;
 GCC_DIAG_ON(sign-conversion)
 	}
+	PhaseStats::count_file(static_cast<eix::OffsetType>(filesize));
+	PhaseStats::count_md5();
 	if(filesize != 0) {
 		filebuffer = static_cast<char *>(mmap(NULLPTR, filesize, PROT_READ, MAP_SHARED, fd, 0));
 		close(fd);
@@ -287,18 +287,26 @@ GCC_DIAG_OFF(old-style-cast)
 GCC_DIAG_ON(old-style-cast)
 			return false;
 		}
+	} else {
+		close(fd);
 	}
-	uint32_t resarr[4];
 	calc_md5sum(filebuffer, filesize, resarr);
 	if(filebuffer != NULLPTR) {
 		munmap(filebuffer, filesize);
 	}
 #ifdef DEBUG_MD5
-	eix::print("file: %s size: %s should be: %s is: ")
-		% file % filesize % md5sum;
+	eix::print("file: %s size: %s md5sum: ") % file % filesize;
 	debug_md5(resarr);
 #endif
-	string::size_type curr(0);
+	return true;
+}
+
+bool get_md5sum(const char *file, string *md5sum) {
+	uint32_t resarr[4];
+	if(!calc_md5sum_file(file, resarr)) {
+		return false;
+	}
+	md5sum->clear();
 	for(int i(0); i < 4; ++i) {
 		uint32_t res(resarr[i]);
 		for(int j(0); j < 8; ++j) {
@@ -309,18 +317,30 @@ GCC_DIAG_ON(old-style-cast)
 				c = (res % 16);
 				res /= 256;
 			}
-			if(c < 10) {
-				if(md5sum[curr] != ('0' + c)) {
-					return false;
-				}
-			} else {
-				c -= 10;
-				if(	(md5sum[curr] != ('a' + c)) &&
-					(md5sum[curr] != ('A' + c)) ) {
-					return false;
-				}
-			}
-			++curr;
+			md5sum->append(1, static_cast<char>((c < 10) ? ('0' + c) : ('a' + c - 10)));
+		}
+	}
+	return true;
+}
+
+bool verify_md5sum(const char *file, const string& md5sum) {
+	if(md5sum.size() != 32) {
+		return false;
+	}
+	if(md5sum.find_first_not_of("0123456789abcdefABCDEF") != string::npos) {
+		return false;
+	}
+	string is;
+	if(!get_md5sum(file, &is)) {
+		return false;
+	}
+	for(string::size_type curr(0); curr < 32; ++curr) {
+		char c(md5sum[curr]);
+		if((c >= 'A') && (c <= 'F')) {
+			c += 'a' - 'A';
+		}
+		if(c != is[curr]) {
+			return false;
 		}
 	}
 	return true;
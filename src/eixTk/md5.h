@@ -16,4 +16,10 @@
 
 ATTRIBUTE_NONNULL_ bool verify_md5sum(const char *file, const std::string& md5sum);
 
+/**
+Set md5sum to the (lowercase hex) md5sum of file
+@return false if file cannot be read
+**/
+ATTRIBUTE_NONNULL_ bool get_md5sum(const char *file, std::string *md5sum);
+
 #endif  // SRC_EIXTK_MD5_H_
@@ -0,0 +1,233 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "eixTk/phasestats.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <sstream>
+#include <string>
+
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/inttypes.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+
+using std::string;
+
+eix::UNumber PhaseStats::files_opened = 0;
+eix::OffsetType PhaseStats::bytes_read = 0;
+eix::UNumber PhaseStats::ebuilds_executed = 0;
+eix::UNumber PhaseStats::md5_calculated = 0;
+
+ATTRIBUTE_NONNULL_ static void json_string(std::ostringstream *out, const string& s);
+ATTRIBUTE_NONNULL((1)) static void json_event(std::ostringstream *out, const string& name, const string& category, int64_t origin, const PhaseStats::Snapshot& start, const PhaseStats::Snapshot& stop, const PhaseStats::Args *args);
+
+static int64_t microseconds(const struct timeval& tv) {
+	return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+int64_t PhaseStats::now() {
+	struct timeval tv;
+	gettimeofday(&tv, NULLPTR);
+	return microseconds(tv);
+}
+
+string PhaseStats::milliseconds(int64_t us) {
+	if(unlikely(us < 0)) {
+		us = 0;
+	}
+	string result(eix::format("%s.") % (us / 1000));
+	int64_t fraction(us % 1000);
+	if(fraction < 100) {
+		result.append((fraction < 10) ? "00" : "0");
+	}
+	result.append(eix::format("%s") % fraction);
+	return result;
+}
+
+void PhaseStats::Snapshot::take() {
+	wall = now();
+	struct rusage usage;
+	if(likely(getrusage(RUSAGE_SELF, &usage) == 0)) {
+		cpu = microseconds(usage.ru_utime) + microseconds(usage.ru_stime);
+		minor_faults = usage.ru_minflt;
+		major_faults = usage.ru_majflt;
+		max_rss = usage.ru_maxrss;
+	} else {
+		cpu = 0;
+		minor_faults = major_faults = 0;
+		max_rss = 0;
+	}
+	if(likely(getrusage(RUSAGE_CHILDREN, &usage) == 0)) {
+		child_cpu = microseconds(usage.ru_utime) + microseconds(usage.ru_stime);
+	} else {
+		child_cpu = 0;
+	}
+	files = files_opened;
+	bytes = bytes_read;
+	ebuilds = ebuilds_executed;
+	md5 = md5_calculated;
+}
+
+PhaseStats::PhaseStats(const char *program_name) : m_program(program_name), m_running(false) {
+	m_start.take();
+}
+
+PhaseStats::PhaseStats(const char *program_name, const Snapshot& start) : m_program(program_name), m_start(start), m_running(false) {
+}
+
+void PhaseStats::begin(const string& name) {
+	// A phase following immediately starts where the previous one stopped
+	bool was_running(m_running);
+	end();
+	m_phases.EMPLACE_BACK(Phase, ());
+	Phase& phase(m_phases.back());
+	phase.name = name;
+	if(was_running) {
+		phase.start = m_phases[m_phases.size() - 2].stop;
+	} else {
+		phase.start.take();
+	}
+	m_running = true;
+}
+
+void PhaseStats::add_arg(const string& key, const string& value) {
+	if(likely(m_running)) {
+		m_phases.back().args.EMPLACE_BACK(Arg, (key, value));
+	}
+}
+
+void PhaseStats::end() {
+	if(m_running) {
+		m_phases.back().stop.take();
+		m_running = false;
+	}
+}
+
+static void json_string(std::ostringstream *out, const string& s) {
+	(*out) << '"';
+	for(string::const_iterator it(s.begin()); likely(it != s.end()); ++it) {
+		unsigned char c(*it);
+		switch(c) {
+			case '"':
+				(*out) << "\\\"";
+				break;
+			case '\\':
+				(*out) << "\\\\";
+				break;
+			case '\n':
+				(*out) << "\\n";
+				break;
+			case '\t':
+				(*out) << "\\t";
+				break;
+			default:
+				if(unlikely(c < 0x20)) {
+					static const char hex[] = "0123456789abcdef";
+					(*out) << "\\u00" << hex[c >> 4] << hex[c & 0xF];
+				} else {
+					(*out) << *it;
+				}
+		}
+	}
+	(*out) << '"';
+}
+
+static void json_event(std::ostringstream *out, const string& name, const string& category, int64_t origin, const PhaseStats::Snapshot& start, const PhaseStats::Snapshot& stop, const PhaseStats::Args *args) {
+	(*out) << "{\"name\":";
+	json_string(out, name);
+	(*out) << ",\"cat\":";
+	json_string(out, category);
+	(*out) << ",\"ph\":\"X\",\"pid\":" << getpid() << ",\"tid\":0"
+		<< ",\"ts\":" << (start.wall - origin)
+		<< ",\"dur\":" << (stop.wall - start.wall)
+		<< ",\"args\":{";
+	if(args != NULLPTR) {
+		for(PhaseStats::Args::const_iterator it(args->begin());
+			likely(it != args->end()); ++it) {
+			json_string(out, it->first);
+			(*out) << ':';
+			json_string(out, it->second);
+			(*out) << ',';
+		}
+	}
+	(*out) << "\"cpu_us\":" << (stop.cpu - start.cpu)
+		<< ",\"child_cpu_us\":" << (stop.child_cpu - start.child_cpu)
+		<< ",\"files_opened\":" << (stop.files - start.files)
+		<< ",\"bytes_read\":" << (stop.bytes - start.bytes)
+		<< ",\"ebuilds_executed\":" << (stop.ebuilds - start.ebuilds)
+		<< ",\"md5_calculated\":" << (stop.md5 - start.md5)
+		<< ",\"minor_faults\":" << (stop.minor_faults - start.minor_faults)
+		<< ",\"major_faults\":" << (stop.major_faults - start.major_faults)
+		<< ",\"max_rss_kb\":" << stop.max_rss
+		<< "}}";
+}
+
+bool PhaseStats::write(const char *file, string *errtext) const {
+	Snapshot current;
+	current.take();
+	std::ostringstream out;
+	out << "{\"traceEvents\":[\n";
+	json_event(&out, m_program, m_program, m_start.wall, m_start, current, NULLPTR);
+	for(std::vector<Phase>::const_iterator it(m_phases.begin());
+		likely(it != m_phases.end()); ++it) {
+		if(unlikely(m_running && (&(*it) == &(m_phases.back())))) {
+			break;
+		}
+		out << ",\n";
+		json_event(&out, it->name, m_program, m_start.wall, it->start, it->stop, &(it->args));
+	}
+	out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	string result(out.str());
+	FILE *fp(std::fopen(file, "w"));
+	if(unlikely(fp == NULLPTR)) {
+		*errtext = eix::format(_("cannot write %s: %s")) % file % std::strerror(errno);
+		return false;
+	}
+	bool ok(std::fwrite(result.c_str(), 1, result.size(), fp) == result.size());
+	if(unlikely(std::fclose(fp) != 0)) {
+		ok = false;
+	}
+	if(unlikely(!ok)) {
+		*errtext = eix::format(_("cannot write %s: %s")) % file % std::strerror(errno);
+	}
+	return ok;
+}
+
+void PhaseStats::print() const {
+	Snapshot last(m_start);
+	for(std::vector<Phase>::const_iterator it(m_phases.begin());
+		likely(it != m_phases.end()); ++it) {
+		if(unlikely(m_running && (&(*it) == &(m_phases.back())))) {
+			break;
+		}
+		if(it->start.wall > last.wall) {
+			// Time not covered by a phase, e.g. the initialization
+			eix::say_error(_("%s (other): %s ms, cpu %s ms"))
+				% m_program
+				% milliseconds(it->start.wall - last.wall)
+				% milliseconds(it->start.cpu - last.cpu);
+		}
+		eix::say_error(_("%s %s: %s ms, cpu %s ms"))
+			% m_program % it->name
+			% milliseconds(it->stop.wall - it->start.wall)
+			% milliseconds(it->stop.cpu - it->start.cpu);
+		last = it->stop;
+	}
+}
@@ -0,0 +1,134 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_EIXTK_PHASESTATS_H_
+#define SRC_EIXTK_PHASESTATS_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/eixint.h"
+#include "eixTk/inttypes.h"
+
+/**
+Record wall and cpu time and some global counters for the phases of a
+program. The result is written as a trace-event file (plain JSON which
+can also be loaded into chrome://tracing or perfetto).
+The counters are always maintained since this is only an addition;
+phases are recorded only for an existing PhaseStats object.
+**/
+class PhaseStats {
+	public:
+		/**
+		Files read and their sizes (cache files, ebuilds, md5 checks)
+		**/
+		static eix::UNumber files_opened;
+		static eix::OffsetType bytes_read;
+		/**
+		Number of ebuild "depend" calls
+		**/
+		static eix::UNumber ebuilds_executed;
+		/**
+		Number of files whose md5sum was calculated
+		**/
+		static eix::UNumber md5_calculated;
+
+		static void count_file(eix::OffsetType size) {
+			++files_opened;
+			bytes_read += size;
+		}
+
+		static void count_ebuild() {
+			++ebuilds_executed;
+		}
+
+		static void count_md5() {
+			++md5_calculated;
+		}
+
+		explicit PhaseStats(const char *program_name);
+
+		/**
+		A snapshot of times (in microseconds) and counters
+		**/
+		class Snapshot {
+			public:
+				int64_t wall, cpu, child_cpu;
+				eix::UNumber files, ebuilds, md5, minor_faults, major_faults;
+				eix::OffsetType bytes;
+				int64_t max_rss;
+
+				void take();
+		};
+
+		/**
+		Start recording at an earlier snapshot (e.g. the program start)
+		**/
+		PhaseStats(const char *program_name, const Snapshot& start);
+
+		~PhaseStats() {
+			end();
+		}
+
+		/**
+		Start a new phase, ending the previous one
+		**/
+		void begin(const std::string& name);
+
+		/**
+		Add an argument like the overlay name to the current phase
+		**/
+		void add_arg(const std::string& key, const std::string& value);
+
+		/**
+		End the current phase (if any)
+		**/
+		void end();
+
+		/**
+		Write all ended phases to file
+		@return false if file cannot be written
+		**/
+		ATTRIBUTE_NONNULL_ bool write(const char *file, std::string *errtext) const;
+
+		/**
+		Print wall and cpu time of all ended phases to stderr
+		**/
+		void print() const;
+
+		/**
+		@return current wall time in microseconds
+		**/
+		static int64_t now();
+
+		/**
+		@return microseconds as milliseconds with 3 digits
+		**/
+		static std::string milliseconds(int64_t us);
+
+		typedef std::pair<std::string, std::string> Arg;
+		typedef std::vector<Arg> Args;
+
+		class Phase {
+			public:
+				std::string name;
+				Args args;
+				Snapshot start, stop;
+		};
+
+	private:
+		std::string m_program;
+		Snapshot m_start;
+		std::vector<Phase> m_phases;
+		bool m_running;
+};
+
+#endif  // SRC_EIXTK_PHASESTATS_H_
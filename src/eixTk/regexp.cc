@@ -11,10 +11,13 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <cstdlib>
+#include <cstring>
+#include <cwctype>
 
 #include <string>
 #include <vector>
 
+#include "eixTk/attribute.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
 #include "eixTk/formated.h"
@@ -26,6 +29,231 @@
 using std::string;
 using std::vector;
 
+ATTRIBUTE_NONNULL_ static const char *skip_bracket(const char *p);
+ATTRIBUTE_NONNULL_ static const char *skip_group(const char *p);
+ATTRIBUTE_NONNULL_ static void regex_literal(const char *regex, string *literal, bool *whole);
+ATTRIBUTE_CONST static bool is_ascii_upper(char c);
+ATTRIBUTE_CONST static bool is_ascii_lower(char c);
+ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE static const char *find_literal(const char *s, const string& literal, bool icase);
+ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE static bool have_nonascii(const char *s);
+
+static bool is_ascii_upper(char c) {
+	return ((c >= 'A') && (c <= 'Z'));
+}
+
+static bool is_ascii_lower(char c) {
+	return ((c >= 'a') && (c <= 'z'));
+}
+
+/**
+@return the position of the closing ] of the bracket expression at p
+(or of the terminating '\0')
+**/
+static const char *skip_bracket(const char *p) {
+	++p;
+	if(*p == '^') {
+		++p;
+	}
+	if(*p == ']') {
+		++p;
+	}
+	for(; likely(*p != '\0'); ++p) {
+		if(*p == ']') {
+			return p;
+		}
+		if((*p == '[') && ((p[1] == ':') || (p[1] == '.') || (p[1] == '='))) {
+			// [:class:], [.coll.], or [=equiv=]
+			char delim(p[1]);
+			for(p += 2; likely(*p != '\0'); ++p) {
+				if((*p == delim) && (p[1] == ']')) {
+					++p;
+					break;
+				}
+			}
+			if(unlikely(*p == '\0')) {
+				return p;
+			}
+		}
+	}
+	return p;
+}
+
+/**
+@return the position of the closing ) of the group at p
+(or of the terminating '\0')
+**/
+static const char *skip_group(const char *p) {
+	int depth(1);
+	for(++p; likely(*p != '\0'); ++p) {
+		switch(*p) {
+			case '\\':
+				if(unlikely(*(++p) == '\0')) {
+					return p;
+				}
+				break;
+			case '[':
+				p = skip_bracket(p);
+				if(unlikely(*p == '\0')) {
+					return p;
+				}
+				break;
+			case '(':
+				++depth;
+				break;
+			case ')':
+				if(--depth == 0) {
+					return p;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	return p;
+}
+
+/**
+Handle the quantifiers following a literal character c at *p: Append c to
+current if it is required, and move *p to the last quantifier.
+@return true if current may be continued by the next character
+**/
+static bool regex_literal_char(const char **p, char c, string *current) {
+	bool optional(false), repeated(false);
+	for(;;) {
+		switch((*p)[1]) {
+			case '+':
+				repeated = true;
+				++(*p);
+				continue;
+			case '*':
+			case '?':
+				optional = true;
+				++(*p);
+				continue;
+			case '{':
+				// Even a minimum of 1 is treated as optional (conservative)
+				optional = true;
+				++(*p);
+				while(((*p)[1] != '\0') && (**p != '}')) {
+					++(*p);
+				}
+				continue;
+			default:
+				break;
+		}
+		break;
+	}
+	// Stacked quantifiers like x+? or x+* make x optional, too
+	if(optional) {
+		return false;
+	}
+	current->append(1, c);
+	return !repeated;
+}
+
+/**
+Find the longest string which every match of the extended regex must
+contain. The analysis is conservative: Anything not understood just ends
+the current string.
+@arg whole is set to true if the regex matches exactly this string
+**/
+static void regex_literal(const char *regex, string *literal, bool *whole) {
+	literal->clear();
+	*whole = true;
+	string current;
+	for(const char *p(regex); likely(*p != '\0'); ++p) {
+		char c(*p);
+		switch(c) {
+			case '|':
+				// An alternative on the top level: Nothing is required
+				literal->clear();
+				*whole = false;
+				return;
+			case '(':
+			case '[':
+				p = ((c == '(') ? skip_group(p) : skip_bracket(p));
+				if(unlikely(*p == '\0')) {
+					--p;
+				}
+				break;
+			case '{':
+				// A quantifier of something which is not a literal character
+				while((p[1] != '\0') && (*p != '}')) {
+					++p;
+				}
+				break;
+			case '\\':
+				c = *(++p);
+				if(unlikely(c == '\0')) {
+					--p;
+					break;
+				}
+				if((std::strchr(".[]()*+?{}|^$\\", c) != NULLPTR) &&
+					regex_literal_char(&p, c, &current)) {
+					continue;
+				}
+				break;
+			default:
+				if(likely(((c & 0x80) == 0) &&
+					(std::strchr("*?+.^$)}", c) == NULLPTR)) &&
+					regex_literal_char(&p, c, &current)) {
+					continue;
+				}
+				break;
+		}
+		// Everything which did not continue above ends the current string
+		*whole = false;
+		if(current.size() > literal->size()) {
+			literal->swap(current);
+		}
+		current.clear();
+	}
+	if(current.size() > literal->size()) {
+		literal->swap(current);
+	}
+}
+
+/**
+@return the first occurrence of literal in s, ignoring the case of ASCII
+letters if icase (literal must be in lowercase then)
+**/
+static const char *find_literal(const char *s, const string& literal, bool icase) {
+	if(likely(!icase)) {
+		return std::strstr(s, literal.c_str());
+	}
+	char lower(literal[0]);
+	char upper(is_ascii_lower(lower) ? (lower - 'a' + 'A') : lower);
+	string::size_type len(literal.size());
+	for(; likely(*s != '\0'); ++s) {
+		if(likely((*s != lower) && (*s != upper))) {
+			continue;
+		}
+		string::size_type i(1);
+		for(; i < len; ++i) {
+			char c(s[i]);
+			if(is_ascii_upper(c)) {
+				c = c - 'A' + 'a';
+			}
+			if(c != literal[i]) {
+				break;
+			}
+		}
+		if(i == len) {
+			return s;
+		}
+	}
+	return NULLPTR;
+}
+
+static bool have_nonascii(const char *s) {
+	for(; likely(*s != '\0'); ++s) {
+		if(unlikely((*s & 0x80) != 0)) {
+			return true;
+		}
+	}
+	return false;
+}
+
 /**
 Free the regular expression
 **/
@@ -56,6 +284,30 @@ void Regex::compile(const char *regex, int eflags) {
 		std::exit(EXIT_FAILURE);
 	}
 	m_compiled = true;
+
+	m_icase = ((eflags & REG_ICASE) != 0);
+	regex_literal(regex, &m_literal, &m_only_literal);
+	if(m_literal.empty()) {
+		m_only_literal = false;
+		return;
+	}
+	if(!m_icase) {
+		return;
+	}
+	for(string::iterator it(m_literal.begin()); likely(it != m_literal.end()); ++it) {
+		char c(*it);
+		if(!is_ascii_upper(c) && !is_ascii_lower(c)) {
+			continue;
+		}
+		char lower(is_ascii_upper(c) ? (c - 'A' + 'a') : c);
+		char upper(lower - 'a' + 'A');
+		*it = lower;
+		// Only if the locale maps the case as usual, regexec() finds nothing else
+		if(unlikely((std::towlower(static_cast<wint_t>(upper)) != static_cast<wint_t>(lower)) ||
+			(std::towupper(static_cast<wint_t>(lower)) != static_cast<wint_t>(upper)))) {
+			m_only_literal = false;
+		}
+	}
 }
 
 /**
@@ -63,7 +315,20 @@ void Regex::compile(const char *regex, int eflags) {
 @return true if the regular expression matches
 **/
 bool Regex::match(const char *s) const {
-	return (!m_compiled) || (!regexec(get(), s, 0, NULLPTR, 0));
+	if(!m_compiled) {
+		return true;
+	}
+	if(likely(!m_literal.empty())) {
+		if(find_literal(s, m_literal, m_icase) != NULLPTR) {
+			if(m_only_literal) {
+				return true;
+			}
+		} else if(likely(!have_nonascii(s))) {
+			// Non-ASCII characters might match case-insensitively
+			return false;
+		}
+	}
+	return !regexec(get(), s, 0, NULLPTR, 0);
 }
 
 /**
@@ -83,6 +348,32 @@ bool Regex::match(const char *s, string::size_type *b, string::size_type *e) con
 		}
 		return true;
 	}
+	if(likely(!m_literal.empty())) {
+		const char *found(find_literal(s, m_literal, m_icase));
+		if(found != NULLPTR) {
+			// With non-ASCII characters, regexec() might find an earlier match
+			if(m_only_literal && (!m_icase || !have_nonascii(s))) {
+GCC_DIAG_OFF(sign-conversion)
+				string::size_type pos(found - s);
+GCC_DIAG_ON(sign-conversion)
+				if(likely(b != NULLPTR)) {
+					*b = pos;
+				}
+				if(likely(e != NULLPTR)) {
+					*e = pos + m_literal.size();
+				}
+				return true;
+			}
+		} else if(likely(!have_nonascii(s))) {
+			if(likely(b != NULLPTR)) {
+				*b = string::npos;
+			}
+			if(likely(e != NULLPTR)) {
+				*e = string::npos;
+			}
+			return false;
+		}
+	}
 	if(regexec(get(), s, 1, pmatch, 0)) {
 		if(likely(b != NULLPTR)) {
 			*b = string::npos;
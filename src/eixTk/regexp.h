@@ -38,20 +38,20 @@ class Regex {
 		/**
 		Initalize class
 		**/
-		Regex() : m_compiled(false) {
+		Regex() : m_compiled(false), m_icase(false), m_only_literal(false) {
 		}
 
 		/**
 		Initalize and compile regular expression
 		**/
-		Regex(const char *regex, int eflags) : m_compiled(false) {
+		Regex(const char *regex, int eflags) : m_compiled(false), m_icase(false), m_only_literal(false) {
 			compile(regex, eflags);
 		}
 
 		/**
 		Initalize and compile regular expression
 		**/
-		explicit Regex(const char *regex) : m_compiled(false) {
+		explicit Regex(const char *regex) : m_compiled(false), m_icase(false), m_only_literal(false) {
 			compile(regex, REG_EXTENDED);
 		}
 
@@ -107,6 +107,22 @@ class Regex {
 		Is the regex already compiled and nonempty?
 		**/
 		bool m_compiled;
+
+		/**
+		A string which every match must contain (in lowercase if m_icase).
+		It is used to reject most strings without calling regexec().
+		**/
+		std::string m_literal;
+
+		/**
+		Is the regex compiled with REG_ICASE?
+		**/
+		bool m_icase;
+
+		/**
+		Is the whole regex just m_literal so that regexec() is not needed?
+		**/
+		bool m_only_literal;
 };
 
 class RegexList {
@@ -0,0 +1,113 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "eixTk/sharedstring.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+#include "eixTk/assert.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/stringutils.h"
+
+using std::string;
+
+static WordUnorderedSet *string_pool(NULLPTR);
+
+const string SharedString::empty_string;
+
+class SharedWords::Entry {
+	public:
+		WordList words;
+		mutable string joined;  // mutable: it is just a cache
+		mutable bool have_joined;
+
+		Entry() : have_joined(false) {
+		}
+};
+
+class SharedWords::EntryLess {
+	public:
+		static bool word_less(const SharedString& a, const SharedString& b) {
+			return a.pooled_less(b);
+		}
+
+		bool operator()(const Entry& a, const Entry& b) const {
+			return std::lexicographical_compare(a.words.begin(), a.words.end(),
+				b.words.begin(), b.words.end(), word_less);
+		}
+};
+
+SharedWords::Pool *SharedWords::pool(NULLPTR);
+
+const SharedWords::WordList SharedWords::empty_list;
+
+void SharedString::init_static() {
+	eix_assert_static(string_pool == NULLPTR);
+	string_pool = new WordUnorderedSet;
+	SharedWords::pool = new SharedWords::Pool;
+}
+
+const string *SharedString::pooled(const string& s) {
+	if(s.empty()) {
+		return NULLPTR;
+	}
+	eix_assert_static(string_pool != NULLPTR);
+	return &(*(string_pool->INSERT(s).first));
+}
+
+void SharedWords::assign(const string& s) {
+	WordVec vec;
+	split_string(&vec, s);
+	WordList words(vec.size());
+	for(WordVec::size_type i(0); likely(i != vec.size()); ++i) {
+		words[i].assign(vec[i]);
+	}
+	assign(&words);
+}
+
+void SharedWords::assign(WordList *words) {
+	if(words->empty()) {
+		m_entry = NULLPTR;
+		return;
+	}
+	eix_assert_static(pool != NULLPTR);
+	// Look up without copying the words
+	Entry key;
+	key.words.swap(*words);
+	Pool::const_iterator it(pool->find(key));
+	if(it == pool->end()) {
+		it = pool->INSERT(key).first;
+	}
+	key.words.swap(*words);
+	m_entry = &(*it);
+}
+
+const SharedWords::WordList& SharedWords::words() const {
+	return ((m_entry == NULLPTR) ? empty_list : m_entry->words);
+}
+
+const string& SharedWords::get() const {
+	if(m_entry == NULLPTR) {
+		return SharedString::empty_string;
+	}
+	if(!m_entry->have_joined) {
+		for(WordList::const_iterator it(m_entry->words.begin());
+			likely(it != m_entry->words.end()); ++it) {
+			if(!m_entry->joined.empty()) {
+				m_entry->joined.append(1, ' ');
+			}
+			m_entry->joined.append(it->get());
+		}
+		m_entry->have_joined = true;
+	}
+	return m_entry->joined;
+}
@@ -0,0 +1,173 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_EIXTK_SHAREDSTRING_H_
+#define SRC_EIXTK_SHAREDSTRING_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/null.h"
+
+/**
+A string which is stored only once in a global pool.
+Copying it copies a pointer, and equal strings have equal pointers.
+The empty string is not stored in the pool.
+**/
+class SharedString {
+	public:
+		/**
+		Must be called exactly once; initializes also the pool of SharedWords
+		**/
+		static void init_static();
+
+		SharedString() NOEXCEPT : m_str(NULLPTR) {
+		}
+
+		explicit SharedString(const std::string& s) : m_str(pooled(s)) {
+		}
+
+		SharedString& operator=(const std::string& s) {
+			m_str = pooled(s);
+			return *this;
+		}
+
+		void assign(const std::string& s) {
+			m_str = pooled(s);
+		}
+
+		void clear() {
+			m_str = NULLPTR;
+		}
+
+		bool empty() const {
+			return (m_str == NULLPTR);
+		}
+
+		const std::string& get() const {
+			return ((m_str == NULLPTR) ? empty_string : *m_str);
+		}
+
+		const char *c_str() const {
+			return get().c_str();
+		}
+
+		bool operator==(const SharedString& s) const {
+			return (m_str == s.m_str);
+		}
+
+		bool operator!=(const SharedString& s) const {
+			return (m_str != s.m_str);
+		}
+
+		bool operator==(const std::string& s) const {
+			return (get() == s);
+		}
+
+		bool operator!=(const std::string& s) const {
+			return (get() != s);
+		}
+
+		/**
+		An arbitrary but fixed order which is cheaper than comparing
+		the strings
+		**/
+		bool pooled_less(const SharedString& s) const {
+			return std::less<const std::string *>()(&get(), &(s.get()));
+		}
+
+	private:
+		friend class SharedWords;
+
+		const std::string *m_str;
+
+		static const std::string empty_string;
+
+		static const std::string *pooled(const std::string& s);
+};
+
+inline static bool operator==(const std::string& a, const SharedString& b) {
+	return (b == a);
+}
+
+inline static bool operator!=(const std::string& a, const SharedString& b) {
+	return (b != a);
+}
+
+/**
+A list of words which is stored only once in a global pool.
+The words are SharedStrings. The words joined by spaces are only computed
+when they are needed, and then also only once for each list.
+**/
+class SharedWords {
+	public:
+		typedef std::vector<SharedString> WordList;
+
+		SharedWords() NOEXCEPT : m_entry(NULLPTR) {
+		}
+
+		explicit SharedWords(const std::string& s) {
+			assign(s);
+		}
+
+		SharedWords& operator=(const std::string& s) {
+			assign(s);
+			return *this;
+		}
+
+		/**
+		Split s into words
+		**/
+		void assign(const std::string& s);
+
+		/**
+		words is used as a buffer: Its content is unchanged on return
+		**/
+		ATTRIBUTE_NONNULL_ void assign(WordList *words);
+
+		void clear() {
+			m_entry = NULLPTR;
+		}
+
+		bool empty() const {
+			return (m_entry == NULLPTR);
+		}
+
+		ATTRIBUTE_PURE const WordList& words() const;
+
+		/**
+		@return the words joined by spaces
+		**/
+		const std::string& get() const;
+
+		bool operator==(const SharedWords& s) const {
+			return (m_entry == s.m_entry);
+		}
+
+		bool operator!=(const SharedWords& s) const {
+			return (m_entry != s.m_entry);
+		}
+
+	private:
+		friend class SharedString;
+		class Entry;
+		class EntryLess;
+		typedef std::set<Entry, EntryLess> Pool;
+		static Pool *pool;
+
+		const Entry *m_entry;
+
+		static const WordList empty_list;
+};
+
+#endif  // SRC_EIXTK_SHAREDSTRING_H_
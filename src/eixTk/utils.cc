@@ -136,6 +136,7 @@ push_back every line of file or dir into v.
 **/
 bool pushback_lines(const char *file, LineVec *v, bool recursive, bool keep_empty, eix::SignedBool keep_comments, string *errtext) {
 	static int depth(0);
+	FileStamps::note(file);
 	WordVec files;
 	string dir(file);
 	dir.append(1, '/');
@@ -228,6 +229,7 @@ char * in given exlude list.
 @return true if everything is ok
 **/
 bool pushback_files(const string& dir_path, WordVec *into, const char *const exclude[], unsigned char only_type, bool no_hidden, bool full_path) {
+	FileStamps::note(dir_path.c_str());
 	pushback_files_exclude = exclude;
 	pushback_files_no_hidden = no_hidden;
 	pushback_files_only_type = only_type;
@@ -249,6 +251,47 @@ bool pushback_files(const string& dir_path, WordVec *into, const char *const exc
 	return true;
 }
 
+FileStamps *FileStamps::recording = NULLPTR;
+
+void FileStamps::add(const char *name) {
+	if(!m_names.INSERT(name).second) {
+		return;
+	}
+	m_stamps.PUSH_BACK(Stamp());
+	Stamp& stamp(m_stamps.back());
+	stamp.name = name;
+	stamp.get(name);
+}
+
+bool FileStamps::changed() const {
+	for(std::vector<Stamp>::const_iterator it(m_stamps.begin());
+		likely(it != m_stamps.end()); ++it) {
+		Stamp current;
+		current.get(it->name.c_str());
+		if(unlikely(!(current == *it))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void FileStamps::Stamp::get(const char *filename) {
+	struct stat st;
+	mtime = link_mtime = 0;
+	size = 0;
+	inode = 0;
+	exists = (stat(filename, &st) == 0);
+	if(exists) {
+		mtime = st.st_mtime;
+		size = st.st_size;
+		inode = st.st_ino;
+	}
+	// A replaced symlink (e.g. make.profile) need not change the target
+	if(lstat(filename, &st) == 0) {
+		link_mtime = st.st_mtime;
+	}
+}
+
 void dump_version() {
 	eix::say() % PACKAGE_VERSION;
 	std::exit(EXIT_SUCCESS);
@@ -12,10 +12,16 @@
 
 #include <config.h>  // IWYU pragma: keep
 
+#include <sys/types.h>
+
+#include <ctime>
+
 #include <string>
+#include <vector>
 
 #include "eixTk/attribute.h"
 #include "eixTk/eixint.h"
+#include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
 
@@ -79,6 +85,62 @@ inline static bool pushback_files(const std::string& dir_path, WordVec *into, co
 	return pushback_files(dir_path, into, exclude, only_files, true, true);
 }
 
+/**
+The files and directories read while recording, together with their
+state at that time. eix --server uses this to notice changes of the
+files from which its resident data was read.
+**/
+class FileStamps {
+	public:
+		/**
+		If not NULLPTR, pushback_lines(), pushback_files(), and
+		VarsReader::read() add the names they read to this object
+		**/
+		static FileStamps *recording;
+
+		ATTRIBUTE_NONNULL_ static void note(const char *name) {
+			if(unlikely(recording != NULLPTR)) {
+				recording->add(name);
+			}
+		}
+
+		/**
+		Add name (also if it does not exist) with its current state
+		**/
+		ATTRIBUTE_NONNULL_ void add(const char *name);
+
+		/**
+		@return true if some recorded file was changed, created, or removed
+		**/
+		bool changed() const;
+
+		void clear() {
+			m_stamps.clear();
+			m_names.clear();
+		}
+
+	private:
+		class Stamp {
+			public:
+				std::string name;
+				bool exists;
+				std::time_t mtime, link_mtime;
+				off_t size;
+				ino_t inode;
+
+				ATTRIBUTE_NONNULL_ void get(const char *filename);
+
+				bool operator==(const Stamp& s) const {
+					return ((exists == s.exists) && (mtime == s.mtime) &&
+						(link_mtime == s.link_mtime) && (size == s.size) &&
+						(inode == s.inode));
+				}
+		};
+
+		std::vector<Stamp> m_stamps;
+		WordUnorderedSet m_names;
+};
+
 /**
 Print version of eix to stdout.
 **/
@@ -30,6 +30,7 @@
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/phasestats.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "eixTk/utils.h"
@@ -1049,6 +1050,7 @@ bool VarsReader::readmem(const char *buffer, const char *buffer_end, string *err
 }
 
 bool VarsReader::read(const char *filename, string *errtext, bool noexist_ok, WordUnorderedSet *sourced, bool nodir) {
+	FileStamps::note(filename);
 	if((!nodir) && ((parse_flags & RECURSE) != NONE)) {
 		string dir(filename);
 		dir.append(1, '/');
@@ -1081,6 +1083,7 @@ bool VarsReader::read(const char *filename, string *errtext, bool noexist_ok, Wo
 		}
 		return false;
 	}
+	PhaseStats::count_file(st.st_size);
 	if(st.st_size == 0) {
 		close(fd);
 		return true;
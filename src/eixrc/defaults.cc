@@ -178,6 +178,13 @@ AddOption(STRING, "EIX_PREVIOUS",
 	"%{EPREFIX}" EIX_PREVIOUS, P_("EIX_PREVIOUS",
 	"This file is the previous eix cache (used by eix-diff and eix-sync)."));
 
+AddOption(STRING, "EIX_SEGMENT",
+	"", P_("EIX_SEGMENT",
+	"If this is nonempty, eix-update writes an index of EIX_CACHEFILE to this\n"
+	"file. eix maps the index (shared by all eix processes) if it fits to the\n"
+	"database; then the hashes need not be decoded, and package names can be\n"
+	"matched without reading or decompressing the categories."));
+
 AddOption(STRING, "EIX_REMOTE1",
 	"%{EPREFIX}" EIX_REMOTECACHEFILE1, P_("EIX_REMOTE1",
 	"This is the eix cache used when -R is in effect. If the string is nonempty,\n"
@@ -367,6 +374,11 @@ AddOption(BOOLEAN, "REQUIRED_USE",
 	REQUIRED_USE_DEFAULT, P_("REQUIRED_USE",
 	"If true, store/use REQUIRED_USE. Usage increases disk/memory requirements."));
 
+AddOption(BOOLEAN, "COMPRESS_DATABASE",
+	"false", P_("COMPRESS_DATABASE",
+	"If true, store the packages of each category as a compressed block.\n"
+	"This is ignored if eix was compiled without zlib."));
+
 AddOption(STRING, "DEFAULT_FORMAT",
 	"normal", P_("DEFAULT_FORMAT",
 	"Defines whether --compact or --verbose is on by default."));
@@ -459,6 +471,17 @@ AddOption(BOOLEAN, "UPDATE_VERBOSE",
 	"false", P_("UPDATE_VERBOSE",
 	"Whether eix-update -v is on by default (output cache method per ebuild)"));
 
+AddOption(BOOLEAN, "PREFETCH_CACHEFILES",
+	"false", P_("PREFETCH_CACHEFILES",
+	"If true, eix-update asks the kernel to read the cache files of the next\n"
+	"category in the background while the current category is parsed.\n"
+	"This can speed up eix-update with a cold disk cache."));
+
+AddOption(STRING, "UPDATE_PHASE_STATS",
+	"", P_("UPDATE_PHASE_STATS",
+	"If nonempty, eix-update writes time and counters of all phases to this\n"
+	"file, see eix-update --phase-stats."));
+
 AddOption(STRING, "CACHE_METHOD_PARSE",
 	"#metadata-md5#metadata-flat#assign", P_("CACHE_METHOD_PARSE",
 	"This string is appended to all cache methods using parse[*] or ebuild[*]."));
@@ -677,6 +677,12 @@ void EixRc::modify_value(string *value, const string& key) {
 	}
 }
 
+void EixRc::reread() {
+	filevarmap.clear();
+	main_map.clear();
+	read();
+}
+
 void EixRc::clear() {
 	defaults.clear();
 	prefix_keys.clear();
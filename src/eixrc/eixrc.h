@@ -62,6 +62,12 @@ class EixRc {
 
 		void read();
 
+		/**
+		Read the files again, keeping the defaults (for eix --server).
+		References to the previous values become invalid.
+		**/
+		void reread();
+
 		void clear();
 
 		void addDefault(EixRcOption option);
@@ -23,6 +23,7 @@
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/parseerror.h"
+#include "eixTk/sharedstring.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "eixTk/utils.h"
@@ -186,6 +187,7 @@ int run_masked_packages(int argc, char *argv[]) {
 		print_help();
 		return EXIT_SUCCESS;
 	}
+	SharedString::init_static();
 
 	MaskList<Mask> mask_list;
 	WordVec args;
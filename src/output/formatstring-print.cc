@@ -1053,7 +1053,7 @@ void PrintFormat::VER_ISFULLSLOT(OutputString *s, Package *package) const {
 }
 
 void PrintFormat::VER_SLOT(OutputString *s, Package *package) const {
-	const string& slot(ver_versionslot(package)->slotname);
+	const string& slot(ver_versionslot(package)->slotname.get());
 	if(likely(slot.empty())) {
 		s->assign_fast('0');
 	} else {
@@ -1062,14 +1062,14 @@ void PrintFormat::VER_SLOT(OutputString *s, Package *package) const {
 }
 
 void PrintFormat::VER_ISSLOT(OutputString *s, Package *package) const {
-	const string& slot(ver_versionslot(package)->slotname);
+	const string& slot(ver_versionslot(package)->slotname.get());
 	if((!slot.empty()) && (slot != "0")) {
 		s->set_one();
 	}
 }
 
 void PrintFormat::VER_SUBSLOT(OutputString *s, Package *package) const {
-	s->assign_smart(ver_versionslot(package)->subslotname);
+	s->assign_smart(ver_versionslot(package)->subslotname.get());
 }
 
 void PrintFormat::VER_ISSUBSLOT(OutputString *s, Package *package) const {
@@ -1310,7 +1310,7 @@ void PrintFormat::VER_REQUIREDUSE(OutputString *s, Package * /* package */) cons
 		return;
 	}
 	if(Version::use_required_use) {
-		s->assign_smart(version_variables->version()->required_use);
+		s->assign_smart(version_variables->version()->required_use.get());
 	}
 }
 
@@ -31,6 +31,7 @@
 #include "eixTk/stringtypes.h"
 #include "eixTk/unordered_set.h"
 WSUGGEST_FINAL_METHODS_OFF
+#include <google/protobuf/util/delimited_message_util.h>
 #include "output/eix.pb.h"
 WSUGGEST_FINAL_METHODS_ON
 #include "output/formatstring.h"
@@ -54,11 +55,28 @@ static void add_restrictions(eix_proto::Restrictions *restrictions, ExtendedVers
 static void add_properties(eix_proto::Properties *properties, ExtendedVersion::Restrict props);
 
 void PrintProto::start() {
+	if(stream) {
+		if(record == NULLPTR) {
+			record = new eix_proto::Category();
+		}
+		return;
+	}
 	collection = new eix_proto::Collection();
 	category_index.clear();
 }
 
 void PrintProto::package(Package *pkg) {
+	if(stream) {
+		if(unlikely(record == NULLPTR)) {
+			start();
+		}
+		// Clear() keeps the allocated memory of the message for reuse
+		record->Clear();
+		record->set_category(pkg->category);
+		fill_package(record->add_package(), pkg);
+		google::protobuf::util::SerializeDelimitedToOstream(*record, &std::cout);
+		return;
+	}
 	if(collection == NULLPTR) {
 		start();
 	}
@@ -73,7 +91,10 @@ void PrintProto::package(Package *pkg) {
 		category->set_category(pkg->category);
 		index = collection->category_size();
 	}
-	eix_proto::Package *package = category->add_package();
+	fill_package(category->add_package(), pkg);
+}
+
+void PrintProto::fill_package(eix_proto::Package *package, Package *pkg) {
 	package->set_name(pkg->name);
 	package->set_description(pkg->desc);
 	package->set_homepage(pkg->homepage);
@@ -183,7 +204,7 @@ void PrintProto::package(Package *pkg) {
 			}
 		}
 		if(Version::use_required_use) {
-			string &required_use(ver->required_use);
+			const string& required_use(ver->required_use.get());
 			if(!(required_use.empty())) {
 				version->set_required_use(required_use);
 			}
@@ -357,6 +378,11 @@ static void add_properties(eix_proto::Properties *properties, ExtendedVersion::R
 }
 
 void PrintProto::finish() {
+	if(record != NULLPTR) {
+		delete record;
+		record = NULLPTR;
+		std::cout.flush();
+	}
 	if(collection == NULLPTR) {
 		return;
 	}
@@ -25,7 +25,9 @@ class PrintFormat;
 class SetStability;
 
 namespace eix_proto {
+class Category;
 class Collection;
+class Package;
 }
 
 class PrintProto FINAL : public PrintFormats {
@@ -38,11 +40,24 @@ class PrintProto FINAL : public PrintFormats {
 		typedef UNORDERED_MAP<std::string, int> CategoryIndex;
 		CategoryIndex category_index;
 
+		/**
+		If true, each package is output immediately as a length-delimited
+		Category message containing only this package
+		**/
+		bool stream;
+
+		/**
+		The message reused for each package in stream mode
+		**/
+		eix_proto::Category *record;
+
+		ATTRIBUTE_NONNULL_ void fill_package(eix_proto::Package *package, Package *pkg);
+
 	public:
-		ATTRIBUTE_NONNULL_ PrintProto(const DBHeader *header, VarDbPkg *vardb, const PrintFormat *printformat, const SetStability *set_stability) :
-			hdr(header), var_db_pkg(vardb), print_format(printformat), stability(set_stability), collection(NULLPTR) {}
+		ATTRIBUTE_NONNULL_ PrintProto(const DBHeader *header, VarDbPkg *vardb, const PrintFormat *printformat, const SetStability *set_stability, bool stream_mode) :
+			hdr(header), var_db_pkg(vardb), print_format(printformat), stability(set_stability), collection(NULLPTR), stream(stream_mode), record(NULLPTR) {}
 
-		PrintProto() : hdr(NULLPTR), var_db_pkg(NULLPTR), print_format(NULLPTR), stability(NULLPTR), collection(NULLPTR) {}
+		PrintProto() : hdr(NULLPTR), var_db_pkg(NULLPTR), print_format(NULLPTR), stability(NULLPTR), collection(NULLPTR), stream(false), record(NULLPTR) {}
 
 		void start() OVERRIDE;
 
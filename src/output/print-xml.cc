@@ -9,17 +9,19 @@
 #include "output/print-xml.h"
 #include <config.h>  // IWYU pragma: keep
 
-#include <set>
+#include <cstdio>
+
 #include <string>
+#include <vector>
 
 #include "database/header.h"
+#include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
 #include "eixTk/formated.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/sysutils.h"
-#include "eixTk/unordered_set.h"
 #include "eixrc/eixrc.h"
 #include "output/formatstring.h"
 #include "portage/basicversion.h"
@@ -33,12 +35,15 @@
 #include "portage/vardbpkg.h"
 #include "portage/version.h"
 
-using std::set;
 using std::string;
+using std::vector;
 
 const PrintXml::XmlVersion PrintXml::current;
 
-static void print_iuse(const IUseSet::IUseNaturalOrder& s, IUse::Flags wanted, const char *dflt);
+/**
+The output buffer is written when it has reached this size
+**/
+#define XML_FLUSH_SIZE 65536
 
 void PrintXml::runclear() {
 	started = false;
@@ -75,14 +80,25 @@ void PrintXml::clear(EixRc *eixrc) {
 	runclear();
 }
 
+void PrintXml::flush_out() {
+	if(likely(!out.empty())) {
+		std::fwrite(out.data(), 1, out.size(), stdout);
+		// clear() keeps the capacity for the next block
+		out.clear();
+	}
+}
+
 void PrintXml::start() {
 	if(unlikely(started)) {
 		return;
 	}
 	started = true;
 
-	eix::say("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
-		"<eixdump version=\"%s\">") % current;
+	out.reserve(XML_FLUSH_SIZE + XML_FLUSH_SIZE / 4);
+	put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<eixdump version=\"");
+	eix::format(&out, "%s") % current;
+	put("\">\n");
 }
 
 void PrintXml::finish() {
@@ -91,34 +107,84 @@ void PrintXml::finish() {
 	}
 
 	if(count) {
-		eix::say("\t</category>");
+		put("\t</category>\n");
 	}
-	eix::say("</eixdump>");
+	put("</eixdump>\n");
+	flush_out();
+	std::fflush(stdout);
 
 	runclear();
 }
 
-static void print_iuse(const IUseSet::IUseNaturalOrder& s, IUse::Flags wanted, const char *dflt) {
+void PrintXml::put_iuse(const IUseSet::IUseNaturalOrder& s, IUse::Flags wanted, const char *dflt) {
 	bool have_found(false);
 	for(IUseSet::IUseNaturalOrder::const_iterator it(s.begin()); likely(it != s.end()); ++it) {
 		if(((it->iuse().flags) & wanted) == 0) {
 			continue;
 		}
 		if(likely(have_found)) {
-			eix::print(" %s") % PrintXml::escape_xmlstring(false, it->name());
-			continue;
-		}
-		have_found = true;
-		if(dflt != NULLPTR) {
-			eix::print("\t\t\t\t<iuse default=\"%s\">") % dflt;
+			out.append(1, ' ');
 		} else {
-			eix::print("\t\t\t\t<iuse>");
+			have_found = true;
+			if(dflt != NULLPTR) {
+				put("\t\t\t\t<iuse default=\"");
+				put(dflt);
+				put("\">");
+			} else {
+				put("\t\t\t\t<iuse>");
+			}
 		}
-		eix::print() % PrintXml::escape_xmlstring(false, it->name());
+		put_escaped(false, it->name());
 	}
 	if(have_found) {
-		eix::say("</iuse>");
+		put("</iuse>\n");
+	}
+}
+
+void PrintXml::calc_installed(Package *pkg) {
+	inst_versions.clear();
+	if((unlikely(var_db_pkg == NULLPTR)) || !var_db_pkg->isInstalled(*pkg)) {
+		return;
+	}
+	// First we check which versions are installed with correct overlays.
+	if(likely(hdr != NULLPTR)) {
+		// Package is a 'list' of Versions with added members ^^
+		for(Package::const_iterator ver(pkg->begin());
+			likely(ver != pkg->end()); ++ver) {
+			if(var_db_pkg->isInstalledVersion(*pkg, *ver, *hdr) > 0) {
+				inst_versions.PUSH_BACK(*ver);
+			}
+		}
+	}
+	// From the remaining ones we choose the last.
+	// There are only few versions, so a linear search is fastest.
+	// The following should actually be const_reverse_iterator,
+	// but some compilers would then need a cast of rend(),
+	// see https://bugs.gentoo.org/show_bug.cgi?id=354071
+	for(Package::reverse_iterator ver(pkg->rbegin());
+		likely(ver != pkg->rend()); ++ver) {
+		bool known(false);
+		for(vector<const Version *>::const_iterator it(inst_versions.begin());
+			likely(it != inst_versions.end()); ++it) {
+			if(BasicVersion::compare(**it, **ver) == 0) {
+				known = true;
+				break;
+			}
+		}
+		if(!known) {
+			inst_versions.PUSH_BACK(*ver);
+		}
+	}
+}
+
+bool PrintXml::is_installed(const Version *ver) const {
+	for(vector<const Version *>::const_iterator it(inst_versions.begin());
+		likely(it != inst_versions.end()); ++it) {
+		if(*it == ver) {
+			return true;
+		}
 	}
+	return false;
 }
 
 void PrintXml::package(Package *pkg) {
@@ -127,49 +193,27 @@ void PrintXml::package(Package *pkg) {
 	}
 	if(unlikely(curcat != pkg->category)) {
 		if(!curcat.empty()) {
-			eix::say("\t</category>");
+			put("\t</category>\n");
 		}
 		curcat = pkg->category;
-		eix::say("\t<category name=\"%s\">") % escape_xmlstring(true, curcat);
+		put("\t<category name=\"");
+		put_escaped(true, curcat);
+		put("\">\n");
 	}
 	// category, name, desc, homepage, licenses;
-	eix::say("\t\t<package name=\"%s\">")
-		% escape_xmlstring(true, pkg->name);
-	say_xml_element("\t\t\t", "description", pkg->desc);
-	say_xml_element("\t\t\t", "homepage", pkg->homepage);
-	say_xml_element("\t\t\t", "licenses", pkg->licenses);
-
-	UNORDERED_SET<const Version*> have_inst;
-	if((likely(var_db_pkg != NULLPTR)) && var_db_pkg->isInstalled(*pkg)) {
-		set<BasicVersion> know_inst;
-		// First we check which versions are installed with correct overlays.
-		if(likely(hdr != NULLPTR)) {
-			// Package is a 'list' of Versions with added members ^^
-			for(Package::const_iterator ver(pkg->begin());
-				likely(ver != pkg->end()); ++ver) {
-				if(var_db_pkg->isInstalledVersion(*pkg, *ver, *hdr) > 0) {
-					know_inst.INSERT(**ver);
-					have_inst.INSERT(*ver);
-				}
-			}
-		}
-		// From the remaining ones we choose the last.
-		// The following should actually be const_reverse_iterator,
-		// but some compilers would then need a cast of rend(),
-		// see https://bugs.gentoo.org/show_bug.cgi?id=354071
-		for(Package::reverse_iterator ver(pkg->rbegin());
-			likely(ver != pkg->rend()); ++ver) {
-			if(know_inst.count(**ver) == 0) {
-				know_inst.INSERT(**ver);
-				have_inst.INSERT(*ver);
-			}
-		}
-	}
+	put("\t\t<package name=\"");
+	put_escaped(true, pkg->name);
+	put("\">\n");
+	put_element("\t\t\t", "description", pkg->desc);
+	put_element("\t\t\t", "homepage", pkg->homepage);
+	put_element("\t\t\t", "licenses", pkg->licenses);
+
+	calc_installed(pkg);
 
 	for(Package::const_iterator ver(pkg->begin()); likely(ver != pkg->end()); ++ver) {
 		bool versionInstalled(false);
 		InstVersion *installedVersion(NULLPTR);
-		if(have_inst.count(*ver) != 0) {
+		if(unlikely(!inst_versions.empty()) && is_installed(*ver)) {
 			if(var_db_pkg->isInstalled(*pkg, *ver, &installedVersion)) {
 				versionInstalled = true;
 				var_db_pkg->readInstDate(*pkg, installedVersion);
@@ -177,38 +221,46 @@ void PrintXml::package(Package *pkg) {
 			}
 		}
 
-		eix::print("\t\t\t<version id=\"%s\" EAPI=\"%s\"")
-			% escape_xmlstring(true, ver->getFull())
-			% escape_xmlstring(true, ver->eapi.get());
+		put("\t\t\t<version id=\"");
+		put_escaped(true, ver->getFull());
+		put("\" EAPI=\"");
+		put_escaped(true, ver->eapi.get());
+		out.append(1, '\"');
 		ExtendedVersion::Overlay overlay_key(ver->overlay_key);
 		if(unlikely(overlay_key != 0)) {
 			if(print_format->is_virtual(overlay_key)) {
-				eix::print(" virtual=\"1\"");
+				put(" virtual=\"1\"");
 			}
 			const OverlayIdent& overlay(hdr->getOverlay(overlay_key));
 			if((print_overlay || overlay.label.empty()) && !(overlay.path.empty())) {
-				eix::print(" overlay=\"%s\"")
-					% escape_xmlstring(true, overlay.path);
+				put(" overlay=\"");
+				put_escaped(true, overlay.path);
+				out.append(1, '\"');
 			}
 			if(!overlay.label.empty()) {
-				eix::print(" repository=\"%s\"")
-					% escape_xmlstring(true, overlay.label);
+				put(" repository=\"");
+				put_escaped(true, overlay.label);
+				out.append(1, '\"');
 			}
 		}
 		if(!ver->get_shortfullslot().empty()) {
-			eix::print(" slot=\"%s\"")
-				% escape_xmlstring(true, ver->get_longfullslot());
+			put(" slot=\"");
+			put_escaped(true, ver->get_longfullslot());
+			out.append(1, '\"');
 		}
 		if(!ver->src_uri.empty()) {
-			eix::print(" srcURI=\"%s\"")
-				% escape_xmlstring(true, ver->src_uri);
+			put(" srcURI=\"");
+			put_escaped(true, ver->src_uri);
+			out.append(1, '\"');
 		}
 		if(versionInstalled) {
-			eix::print(" installed=\"1\" installDate=\"%s\" installEAPI=\"%s\"")
-				% escape_xmlstring(true, date_conv(dateformat.c_str(), installedVersion->instDate))
-				% escape_xmlstring(true, installedVersion->eapi.get());
+			put(" installed=\"1\" installDate=\"");
+			put_escaped(true, date_conv(dateformat.c_str(), installedVersion->instDate));
+			put("\" installEAPI=\"");
+			put_escaped(true, installedVersion->eapi.get());
+			out.append(1, '\"');
 		}
-		eix::say('>');
+		put(">\n");
 
 		MaskFlags currmask(ver->maskflags);
 		KeywordsFlags currkey(ver->keyflags);
@@ -216,69 +268,69 @@ void PrintXml::package(Package *pkg) {
 		KeywordsFlags waskey;
 		stability->calc_version_flags(false, &wasmask, &waskey, *ver, pkg);
 
-		WordVec mask_text, unmask_text;
-		// The following might give a memory leak with -flto for unknown reasons:
-		// mask_text.PUSH_BACK("FOO") or mask_text.PUSH_BACK("BAR")
+		// At most one text comes from the masks and one from the keywords
+		const char *mask_text[2];
+		const char *unmask_text[2];
+		unsigned int mask_count(0), unmask_count(0);
 		if(wasmask.isHardMasked()) {
 			if(currmask.isProfileMask()) {
-				mask_text.push_back("profile");
+				mask_text[mask_count++] = "profile";
 			} else if(currmask.isPackageMask()) {
-				mask_text.push_back("hard");
+				mask_text[mask_count++] = "hard";
 			} else if(wasmask.isProfileMask()) {
-				mask_text.push_back("profile");
-				unmask_text.push_back("package_unmask");
+				mask_text[mask_count++] = "profile";
+				unmask_text[unmask_count++] = "package_unmask";
 			} else {
-				mask_text.push_back("hard");
-				unmask_text.push_back("package_unmask");
+				mask_text[mask_count++] = "hard";
+				unmask_text[unmask_count++] = "package_unmask";
 			}
 		} else if(currmask.isHardMasked()) {
-			mask_text.push_back("package_mask");
+			mask_text[mask_count++] = "package_mask";
 		}
 
 		if(currkey.isStable()) {
+			const char *was_text;
 			if(waskey.isStable()) {
-				//
+				was_text = NULLPTR;
 			} else if(waskey.isUnstable()) {
-				mask_text.push_back("keyword");
-				unmask_text.push_back("package_keywords");
+				was_text = "keyword";
 			} else if(waskey.isMinusKeyword()) {
-				mask_text.push_back("minus_keyword");
-				unmask_text.push_back("package_keywords");
+				was_text = "minus_keyword";
 			} else if(waskey.isAlienStable()) {
-				mask_text.push_back("alien_stable");
-				unmask_text.push_back("package_keywords");
+				was_text = "alien_stable";
 			} else if(waskey.isAlienUnstable()) {
-				mask_text.push_back("alien_unstable");
-				unmask_text.push_back("package_keywords");
+				was_text = "alien_unstable";
 			} else if(waskey.isMinusUnstable()) {
-				mask_text.push_back("minus_unstable");
-				unmask_text.push_back("package_keywords");
+				was_text = "minus_unstable";
 			} else if(waskey.isMinusAsterisk()) {
-				mask_text.push_back("minus_asterisk");
-				unmask_text.push_back("package_keywords");
+				was_text = "minus_asterisk";
 			} else {
-				mask_text.push_back("missing_keyword");
-				unmask_text.push_back("package_keywords");
+				was_text = "missing_keyword";
+			}
+			if(was_text != NULLPTR) {
+				mask_text[mask_count++] = was_text;
+				unmask_text[unmask_count++] = "package_keywords";
 			}
 		} else if(currkey.isUnstable()) {
-			mask_text.push_back("keyword");
+			mask_text[mask_count++] = "keyword";
 		} else if(currkey.isMinusKeyword()) {
-			mask_text.push_back("minus_keyword");
+			mask_text[mask_count++] = "minus_keyword";
 		} else if(currkey.isAlienStable()) {
-			mask_text.push_back("alien_stable");
+			mask_text[mask_count++] = "alien_stable";
 		} else if(currkey.isAlienUnstable()) {
-			mask_text.push_back("alien_unstable");
+			mask_text[mask_count++] = "alien_unstable";
 		} else if(currkey.isMinusUnstable()) {
-			mask_text.push_back("minus_unstable");
+			mask_text[mask_count++] = "minus_unstable";
 		} else if(currkey.isMinusAsterisk()) {
-			mask_text.push_back("minus_asterisk");
+			mask_text[mask_count++] = "minus_asterisk";
 		} else {
-			mask_text.push_back("missing_keyword");
+			mask_text[mask_count++] = "missing_keyword";
 		}
 
-		for(WordVec::const_iterator it(mask_text.begin());
-			unlikely(it != mask_text.end()); ++it) {
-			eix::say("\t\t\t\t<mask type=\"%s\"/>") % (*it);
+		for(unsigned int i(0); unlikely(i < mask_count); ++i) {
+			put("\t\t\t\t<mask type=\"");
+			put(mask_text[i]);
+			put("\"/>\n");
 		}
 
 		if(unlikely(ver->have_reasons())) {
@@ -289,45 +341,48 @@ void PrintXml::package(Package *pkg) {
 				if((vec == NULLPTR) || (vec->empty())) {
 					continue;
 				}
-				eix::print("\t\t\t\t<maskreason>");
+				put("\t\t\t\t<maskreason>");
 				bool pret(false);
 				for(WordVec::const_iterator wit(vec->begin());
 					likely(wit != vec->end()); ++wit) {
 					if(likely(pret)) {
-						eix::say_empty();
+						out.append(1, '\n');
 					} else {
 						pret = true;
 					}
-					eix::say() % escape_xmlstring(false, *wit);
+					put_escaped(false, *wit);
+					out.append(1, '\n');
 				}
-				eix::say("</maskreason>");
+				put("</maskreason>\n");
 			}
 		}
 
-		for(WordVec::const_iterator it(unmask_text.begin());
-			unlikely(it != unmask_text.end()); ++it) {
-			eix::say("\t\t\t\t<unmask type=\"%s\"/>") % (*it);
+		for(unsigned int i(0); unlikely(i < unmask_count); ++i) {
+			put("\t\t\t\t<unmask type=\"");
+			put(unmask_text[i]);
+			put("\"/>\n");
 		}
 
 		if(!(ver->iuse.empty())) {
 			const IUseSet::IUseNaturalOrder& s(ver->iuse.asNaturalOrder());
-			print_iuse(s, IUse::USEFLAGS_NORMAL, NULLPTR);
-			print_iuse(s, IUse::USEFLAGS_PLUS, "1");
-			print_iuse(s, IUse::USEFLAGS_MINUS, "-1");
+			put_iuse(s, IUse::USEFLAGS_NORMAL, NULLPTR);
+			put_iuse(s, IUse::USEFLAGS_PLUS, "1");
+			put_iuse(s, IUse::USEFLAGS_MINUS, "-1");
 		}
 		if(Version::use_required_use) {
-			string &required_use(ver->required_use);
+			const string& required_use(ver->required_use.get());
 			if(!(required_use.empty())) {
-				eix::say("\t\t\t\t<required_use>%s</required_use>")
-					% escape_xmlstring(false, required_use);
+				put("\t\t\t\t<required_use>");
+				put_escaped(false, required_use);
+				put("</required_use>\n");
 			}
 		}
 		if(versionInstalled) {
 			string iuse_disabled, iuse_enabled;
 			var_db_pkg->readUse(*pkg, installedVersion);
-			WordVec inst_iuse(installedVersion->inst_iuse);
-			WordSet usedUse(installedVersion->usedUse);
-			for(WordVec::const_iterator iu(inst_iuse.begin()); likely(iu != inst_iuse.end()); iu++) {
+			const WordVec& inst_iuse(installedVersion->inst_iuse);
+			const WordSet& usedUse(installedVersion->usedUse);
+			for(WordVec::const_iterator iu(inst_iuse.begin()); likely(iu != inst_iuse.end()); ++iu) {
 				if(usedUse.count(*iu) == 0) {
 					if(!iuse_disabled.empty()) {
 						iuse_disabled.append(1, ' ');
@@ -341,61 +396,63 @@ void PrintXml::package(Package *pkg) {
 				}
 			}
 			if(!iuse_disabled.empty()) {
-				eix::say("\t\t\t\t<use enabled=\"0\">%s</use>")
-					% escape_xmlstring(false, iuse_disabled);
+				put("\t\t\t\t<use enabled=\"0\">");
+				put_escaped(false, iuse_disabled);
+				put("</use>\n");
 			}
 			if(!iuse_enabled.empty()) {
-				eix::say("\t\t\t\t<use enabled=\"1\">%s</use>")
-					% escape_xmlstring(false, iuse_enabled);
+				put("\t\t\t\t<use enabled=\"1\">");
+				put_escaped(false, iuse_enabled);
+				put("</use>\n");
 			}
 		}
 
 		ExtendedVersion::Restrict restrict(ver->restrictFlags);
 		if(unlikely(restrict != ExtendedVersion::RESTRICT_NONE)) {
 			if(unlikely((restrict & ExtendedVersion::RESTRICT_BINCHECKS) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"binchecks\"/>");
+				put("\t\t\t\t<restrict flag=\"binchecks\"/>\n");
 			}
 			if(unlikely((restrict & ExtendedVersion::RESTRICT_STRIP) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"strip\"/>");
+				put("\t\t\t\t<restrict flag=\"strip\"/>\n");
 			}
 			if(unlikely((restrict & ExtendedVersion::RESTRICT_TEST) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"test\"/>");
+				put("\t\t\t\t<restrict flag=\"test\"/>\n");
 			}
 			if(unlikely((restrict & ExtendedVersion::RESTRICT_USERPRIV) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"userpriv\"/>");
+				put("\t\t\t\t<restrict flag=\"userpriv\"/>\n");
 			}
 			if(unlikely((restrict & ExtendedVersion::RESTRICT_INSTALLSOURCES) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"installsources\"/>");
+				put("\t\t\t\t<restrict flag=\"installsources\"/>\n");
 			}
 			if(unlikely((restrict & ExtendedVersion::RESTRICT_FETCH) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"fetch\"/>");
+				put("\t\t\t\t<restrict flag=\"fetch\"/>\n");
 			}
 			if(unlikely((restrict & ExtendedVersion::RESTRICT_MIRROR) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"mirror\"/>");
+				put("\t\t\t\t<restrict flag=\"mirror\"/>\n");
 			}
 			if(unlikely((restrict & ExtendedVersion::RESTRICT_PRIMARYURI) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"primaryuri\"/>");
+				put("\t\t\t\t<restrict flag=\"primaryuri\"/>\n");
 			}
 			if(unlikely((restrict & ExtendedVersion::RESTRICT_BINDIST) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"bindist\"/>");
+				put("\t\t\t\t<restrict flag=\"bindist\"/>\n");
 			}
 			if(unlikely((restrict & ExtendedVersion::RESTRICT_PARALLEL) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"parallel\"/>");
+				put("\t\t\t\t<restrict flag=\"parallel\"/>\n");
 			}
 		}
 		ExtendedVersion::Restrict properties(ver->propertiesFlags);
 		if(unlikely(properties != ExtendedVersion::PROPERTIES_NONE)) {
 			if(unlikely((properties & ExtendedVersion::PROPERTIES_INTERACTIVE) != 0)) {
-				eix::say("\t\t\t\t<properties flag=\"interactive\"/>");
+				put("\t\t\t\t<properties flag=\"interactive\"/>\n");
 			}
 			if(unlikely((properties & ExtendedVersion::PROPERTIES_LIVE) != 0)) {
-				eix::say("\t\t\t\t<properties flag=\"live\"/>");
+				put("\t\t\t\t<properties flag=\"live\"/>\n");
 			}
 			if(unlikely((properties & ExtendedVersion::PROPERTIES_VIRTUAL) != 0)) {
-				eix::say("\t\t\t\t<properties flag=\"virtual\"/>");
+				put("\t\t\t\t<properties flag=\"virtual\"/>\n");
 			}
 			if(unlikely((properties & ExtendedVersion::PROPERTIES_SET) != 0)) {
-				eix::say("\t\t\t\t<properties flag=\"set\"/>");
+				put("\t\t\t\t<properties flag=\"set\"/>\n");
 			}
 		}
 
@@ -419,53 +476,61 @@ void PrintXml::package(Package *pkg) {
 				}
 			}
 			if(print_full) {
-				say_xml_element("\t\t\t\t", "keywords", full_kw);
+				put_element("\t\t\t\t", "keywords", full_kw);
 			}
 			if(print_effective) {
-				say_xml_element("\t\t\t\t", "effective_keywords", eff_kw);
+				put_element("\t\t\t\t", "effective_keywords", eff_kw);
 			}
 		}
 
 		if(Depend::use_depend) {
 			const string& depend = ver->depend.get_depend();
 			if(!depend.empty()) {
-				eix::say("\t\t\t\t<depend>%s</depend>")
-					% escape_xmlstring(false, depend);
+				put("\t\t\t\t<depend>");
+				put_escaped(false, depend);
+				put("</depend>\n");
 			}
 			const string& rdepend = ver->depend.get_rdepend();
 			if(!rdepend.empty()) {
-				eix::say("\t\t\t\t<rdepend>%s</rdepend>")
-					% escape_xmlstring(false, rdepend);
+				put("\t\t\t\t<rdepend>");
+				put_escaped(false, rdepend);
+				put("</rdepend>\n");
 			}
 			const string& pdepend = ver->depend.get_pdepend();
 			if(!pdepend.empty()) {
-				eix::say("\t\t\t\t<pdepend>%s</pdepend>")
-					% escape_xmlstring(false, pdepend);
+				put("\t\t\t\t<pdepend>");
+				put_escaped(false, pdepend);
+				put("</pdepend>\n");
 			}
 			const string& bdepend = ver->depend.get_bdepend();
 			if(!bdepend.empty()) {
-				eix::say("\t\t\t\t<bdepend>%s</bdepend>")
-					% escape_xmlstring(false, bdepend);
+				put("\t\t\t\t<bdepend>");
+				put_escaped(false, bdepend);
+				put("</bdepend>\n");
 			}
 			const string& idepend = ver->depend.get_idepend();
 			if(!idepend.empty()) {
-				eix::say("\t\t\t\t<idepend>%s</idepend>")
-					% escape_xmlstring(false, idepend);
+				put("\t\t\t\t<idepend>");
+				put_escaped(false, idepend);
+				put("</idepend>\n");
 			}
 		}
-		eix::say("\t\t\t</version>");
+		put("\t\t\t</version>\n");
 	}
-	eix::say("\t\t</package>");
+	put("\t\t</package>\n");
 	++count;
+	if(out.size() >= XML_FLUSH_SIZE) {
+		flush_out();
+	}
 }  // NOLINT(readability/fn_size)
 
-string PrintXml::escape_xmlstring(bool quoted, const string& s) {
-	string ret;
-	string::size_type prev(0);
-	string::size_type len(s.length());
-	for(string::size_type i(0); likely(i < len); ++i) {
+void PrintXml::append_xmlstring(string *dest, bool quoted, const string& s) {
+	const char *str(s.c_str());
+	const char *end(str + s.size());
+	const char *prev(str);
+	for(const char *curr(str); likely(curr != end); ++curr) {
 		const char *replace;
-		switch(s[i]) {
+		switch(*curr) {
 			case '&':
 				replace = "&amp;";
 				break;
@@ -482,29 +547,39 @@ string PrintXml::escape_xmlstring(bool quoted, const string& s) {
 				replace = (quoted ? "&quot;" : NULLPTR);
 				break;
 			default:
-				replace = NULLPTR;
-				break;
+				continue;
 		}
 		if(unlikely(replace != NULLPTR)) {
-			ret.append(s, prev, i - prev);
-			ret.append(replace);
-			prev = i + 1;
+			// Copy the clean part at once
+GCC_DIAG_OFF(sign-conversion)
+			dest->append(prev, curr - prev);
+GCC_DIAG_ON(sign-conversion)
+			dest->append(replace);
+			prev = curr + 1;
 		}
 	}
-	if(likely(prev == 0)) {
-		return s;
-	}
-	if(prev < len) {
-		ret.append(s, prev, len - prev);
-	}
+GCC_DIAG_OFF(sign-conversion)
+	dest->append(prev, end - prev);
+GCC_DIAG_ON(sign-conversion)
+}
+
+string PrintXml::escape_xmlstring(bool quoted, const string& s) {
+	string ret;
+	append_xmlstring(&ret, quoted, s);
 	return ret;
 }
 
-void PrintXml::say_xml_element(const string& prefix, const string& name, const string& content) {
+void PrintXml::put_element(const char *prefix, const char *name, const string& content) {
+	put(prefix);
+	out.append(1, '<');
+	put(name);
 	if(unlikely(content.empty())) {
-		eix::say("%s<%s/>") % prefix % name;
+		put("/>\n");
 		return;
 	}
-	eix::say("%s<%s>%s</%2$s>") % prefix % name
-		% escape_xmlstring(false, content);
+	out.append(1, '>');
+	put_escaped(false, content);
+	put("</");
+	put(name);
+	put(">\n");
 }
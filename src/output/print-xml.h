@@ -21,6 +21,7 @@
 #include "eixTk/ptr_container.h"
 #include "output/print-formats.h"
 #include "portage/package.h"
+#include "portage/version.h"
 
 class EixRc;
 class DBHeader;
@@ -45,9 +46,37 @@ class PrintXml FINAL : public PrintFormats {
 		PackageList::size_type count;
 		std::string curcat;
 
+		/**
+		The output is collected here and written in large blocks
+		**/
+		std::string out;
+
+		/**
+		The installed versions of the current package (reused for each package)
+		**/
+		std::vector<const Version *> inst_versions;
+
 		void clear(EixRc *eixrc);
 		void runclear();
 
+		void put(const char *s) {
+			out.append(s);
+		}
+
+		void put(const std::string& s) {
+			out.append(s);
+		}
+
+		void put_escaped(bool quoted, const std::string& s) {
+			append_xmlstring(&out, quoted, s);
+		}
+
+		ATTRIBUTE_NONNULL_ void put_element(const char *prefix, const char *name, const std::string& content);
+		void put_iuse(const IUseSet::IUseNaturalOrder& s, IUse::Flags wanted, const char *dflt);
+		ATTRIBUTE_NONNULL_ void calc_installed(Package *pkg);
+		ATTRIBUTE_PURE bool is_installed(const Version *ver) const;
+		void flush_out();
+
 	public:
 		typedef eix::UNumber XmlVersion;
 		static CONSTEXPR const XmlVersion current = 16;
@@ -73,7 +102,7 @@ class PrintXml FINAL : public PrintFormats {
 		ATTRIBUTE_NONNULL_ void package(Package *pkg) OVERRIDE;
 		void finish() OVERRIDE;
 		static std::string escape_xmlstring(bool quoted, const std::string& s);
-		static void say_xml_element(const std::string& prefix, const std::string& name, const std::string& content);
+		ATTRIBUTE_NONNULL_ static void append_xmlstring(std::string *dest, bool quoted, const std::string& s);
 
 		~PrintXml() {
 			finish();
@@ -10,7 +10,11 @@
 #include "portage/conf/cascadingprofile.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <sys/stat.h>
+#include <sys/types.h>
+
 #include <cstring>
+#include <ctime>
 
 #include <string>
 #include <utility>
@@ -19,6 +23,7 @@
 #include "eixTk/attribute.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
 #include "eixTk/filenames.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
@@ -158,9 +163,66 @@ class ProfileFilenames {
 
 static ProfileFilenames *profile_filenames = NULLPTR;
 
+/**
+The lines of the plain files of the profile, validated by mtime and size.
+The global and the local profile read mostly the same files, and
+eix --server rereads the profile whenever /etc/portage has changed.
+**/
+class ProfileLinesCache {
+	private:
+		class Entry {
+			public:
+				std::time_t mtime;
+				off_t size;
+				LineVec lines;
+		};
+		typedef UNORDERED_MAP<string, Entry> EntryMap;
+		EntryMap entries;
+
+	public:
+		/**
+		@return the lines of filename (which may also be a directory);
+		scratch is used if the lines are not cached
+		**/
+		ATTRIBUTE_NONNULL_ const LineVec& get(const string& filename, eix::SignedBool keep_comments, LineVec *scratch);
+};
+
+const LineVec& ProfileLinesCache::get(const string& filename, eix::SignedBool keep_comments, LineVec *scratch) {
+	FileStamps::note(filename.c_str());
+	struct stat stat_buf;
+	if((stat(filename.c_str(), &stat_buf) != 0) || !S_ISREG(stat_buf.st_mode)) {
+		pushback_lines(filename.c_str(), scratch, true, true, keep_comments);
+		return *scratch;
+	}
+	string key(filename);
+	key.append(1, (keep_comments == 0) ? '\0' : '\1');
+	Entry& entry(entries[key]);
+	if(entry.lines.empty() ||
+		(entry.mtime != stat_buf.st_mtime) || (entry.size != stat_buf.st_size)) {
+		entry.mtime = stat_buf.st_mtime;
+		entry.size = stat_buf.st_size;
+		entry.lines.clear();
+		pushback_lines(filename.c_str(), &(entry.lines), true, true, keep_comments);
+	}
+	return entry.lines;
+}
+
+static ProfileLinesCache *profile_lines_cache = NULLPTR;
+
 void CascadingProfile::init_static() {
 	eix_assert_static(profile_filenames == NULLPTR);
 	profile_filenames = new ProfileFilenames;
+	profile_lines_cache = new ProfileLinesCache;
+}
+
+/**
+@return the lines of filename, preferably from the cache
+**/
+ATTRIBUTE_NONNULL_ static const LineVec& profile_lines(const string& filename, eix::SignedBool keep_comments, LineVec *scratch);
+
+static const LineVec& profile_lines(const string& filename, eix::SignedBool keep_comments, LineVec *scratch) {
+	eix_assert_static(profile_lines_cache != NULLPTR);
+	return profile_lines_cache->get(filename, keep_comments, scratch);
 }
 
 bool CascadingProfile::readremoveFiles() {
@@ -190,8 +252,8 @@ bool CascadingProfile::readremoveFiles() {
 }
 
 bool CascadingProfile::readPackages(const string& filename, const char *repo, bool only_repo) {
-	LineVec lines;
-	pushback_lines(filename.c_str(), &lines, true);
+	LineVec scratch;
+	const LineVec& lines(profile_lines(filename, 0, &scratch));
 	bool ret(false);
 	PreList::FilenameIndex file_system(p_system.push_name(filename, repo, only_repo));
 	PreList::FilenameIndex file_profile(p_profile.push_name(filename, repo, only_repo));
@@ -228,26 +290,26 @@ bool CascadingProfile::readPackages(const string& filename, const char *repo, bo
 }
 
 bool CascadingProfile::readPackageMasks(const string& filename, const char *repo, bool only_repo) {
-	LineVec lines;
-	pushback_lines(filename.c_str(), &lines, true, true, -1);
+	LineVec scratch;
+	const LineVec& lines(profile_lines(filename, -1, &scratch));
 	return p_package_masks.handle_file(lines, filename, repo, false, true, only_repo);
 }
 
 bool CascadingProfile::readPackageUnmasks(const string& filename, const char *repo, bool only_repo) {
-	LineVec lines;
-	pushback_lines(filename.c_str(), &lines, true);
+	LineVec scratch;
+	const LineVec& lines(profile_lines(filename, 0, &scratch));
 	return p_package_unmasks.handle_file(lines, filename, repo, false, false, only_repo);
 }
 
 bool CascadingProfile::readPackageKeywords(const string& filename, const char *repo, bool only_repo) {
-	LineVec lines;
-	pushback_lines(filename.c_str(), &lines, true);
+	LineVec scratch;
+	const LineVec& lines(profile_lines(filename, 0, &scratch));
 	return p_package_keywords.handle_file(lines, filename, repo, false, false, only_repo);
 }
 
 bool CascadingProfile::readPackageAcceptKeywords(const string& filename, const char *repo, bool only_repo) {
-	LineVec lines;
-	pushback_lines(filename.c_str(), &lines, true);
+	LineVec scratch;
+	const LineVec& lines(profile_lines(filename, 0, &scratch));
 	return p_package_accept_keywords.handle_file(lines, filename, repo, true, false, only_repo);
 }
 
@@ -281,6 +343,16 @@ void CascadingProfile::finalize() {
 	p_package_accept_keywords.initialize(&m_package_accept_keywords, m_portagesettings->m_raised_arch, parse_error);
 }
 
+void CascadingProfile::freeze() const {
+	m_world.freeze();
+	m_system.freeze();
+	m_profile.freeze();
+	m_package_masks.freeze();
+	m_package_unmasks.freeze();
+	m_package_keywords.freeze();
+	m_package_accept_keywords.freeze();
+}
+
 /**
 Cycle through profile and put path to files into this->m_profile_files.
 **/
@@ -145,6 +145,11 @@ class CascadingProfile {
 		**/
 		void finalize();
 
+		/**
+		Calculate the lookup data of all MaskLists now
+		**/
+		void freeze() const;
+
 		/**
 		Read all "make.defaults" files previously added by listadd...
 		**/
@@ -445,7 +445,10 @@ void PortageSettings::init(EixRc *eixrc, const ParseError *e, bool getlocal, boo
 		}
 	} else {
 		m_local_arch_set = m_auto_arch_set = &m_arch_set;
-	} {
+	}
+	m_accepted_keywords_compiled.assign(m_accepted_keywords_set);
+	m_auto_arch_compiled.assign(*m_auto_arch_set);
+	{
 		// Calculate m_raised_arch by prepending ~ to every token
 		WordSet archset;
 		for(WordSet::const_iterator it(m_arch_set.begin());
@@ -711,18 +714,23 @@ void PortageSettings::calc_recursive_sets(Package *p) const {
 	}
 }
 
+void PortageSettings::init_upgrade_policy() const {
+	know_upgrade_policy = true;
+	upgrade_policy = settings_rc->getBool("UPGRADE_TO_HIGHEST_SLOT");
+	upgrade_policy_exceptions.clear();
+	WordVec exceptions;
+	split_string(&exceptions, ((*settings_rc)[upgrade_policy ?
+			"SLOT_UPGRADE_FORBID" : "SLOT_UPGRADE_ALLOW"]), true);
+	for(WordVec::const_iterator it(exceptions.begin());
+		likely(it != exceptions.end()); ++it) {
+		upgrade_policy_exceptions.add_file(it->c_str(), Mask::maskTypeNone, true, parse_error);
+	}
+	upgrade_policy_exceptions.finalize();
+}
+
 bool PortageSettings::calc_allow_upgrade_slots(const Package *p) const {
 	if(unlikely(!know_upgrade_policy)) {
-		upgrade_policy = settings_rc->getBool("UPGRADE_TO_HIGHEST_SLOT");
-		upgrade_policy_exceptions.clear();
-		WordVec exceptions;
-		split_string(&exceptions, ((*settings_rc)[upgrade_policy ?
-				"SLOT_UPGRADE_FORBID" : "SLOT_UPGRADE_ALLOW"]), true);
-		for(WordVec::const_iterator it(exceptions.begin());
-			likely(it != exceptions.end()); ++it) {
-			upgrade_policy_exceptions.add_file(it->c_str(), Mask::maskTypeNone, true, parse_error);
-		}
-		upgrade_policy_exceptions.finalize();
+		init_upgrade_policy();
 	}
 	if(unlikely(!upgrade_policy_exceptions.empty()) && unlikely(upgrade_policy_exceptions.match_name(p)))
 		return !upgrade_policy;
@@ -887,21 +895,18 @@ inline static void increase(char *s) {
 bool PortageUserConfig::CheckList(Package *p, const MaskList<KeywordMask> *list, Keywords::Redundant flag_double, Keywords::Redundant flag_in) const {
 	bool rvalue(false);
 	UNORDERED_MAP<Version*, char> counter;
-	MaskList<KeywordMask>::Get *keyword_masks(list->get(p));
-	if(keyword_masks != NULLPTR) {
-		for(MaskList<KeywordMask>::Get::const_iterator it(keyword_masks->begin());
-			likely(it != keyword_masks->end()); ++it) {
-			rvalue = true;
-			Mask::Matches matches;
-			it->match(&matches, p);
-			for(Mask::Matches::iterator v(matches.begin());
-				likely(v != matches.end()); ++v) {
-				if(!it->keywords.empty()) {
-					increase(&(counter[*v]));
-				}
+	MaskList<KeywordMask>::Get keyword_masks(list->get(p));
+	for(MaskList<KeywordMask>::Get::const_iterator it(keyword_masks.begin());
+		likely(it != keyword_masks.end()); ++it) {
+		rvalue = true;
+		Mask::Matches matches;
+		it->match(&matches, p);
+		for(Mask::Matches::iterator v(matches.begin());
+			likely(v != matches.end()); ++v) {
+			if(!it->keywords.empty()) {
+				increase(&(counter[*v]));
 			}
 		}
-		delete keyword_masks;
 	}
 	// Also apply the set entries:
 	for(Package::iterator v(p->begin()); likely(v != p->end()); ++v) {
@@ -911,19 +916,18 @@ bool PortageUserConfig::CheckList(Package *p, const MaskList<KeywordMask> *list,
 		}
 		for(Version::SetsIndizes::const_iterator it(v->sets_indizes.begin());
 			unlikely(it != v->sets_indizes.end()); ++it) {
-			MaskList<KeywordMask>::Get *key_masks(list->get_setname(m_settings->set_names[*it]));
-			if(key_masks == NULLPTR) {
+			MaskList<KeywordMask>::Get key_masks(list->get_setname(m_settings->set_names[*it]));
+			MaskList<KeywordMask>::Get::const_iterator m(key_masks.begin());
+			if(m == key_masks.end()) {
 				continue;
 			}
 			rvalue = true;
 			char& c(counter[*v]);
-			for(MaskList<KeywordMask>::Get::const_iterator m(key_masks->begin());
-				likely(m != key_masks->end()); ++m) {
+			for(; likely(m != key_masks.end()); ++m) {
 				if(!m->keywords.empty()) {
 					increase(&c);
 				}
 			}
-			delete key_masks;
 		}
 	}
 	if(!rvalue) {
@@ -946,11 +950,33 @@ bool PortageUserConfig::CheckList(Package *p, const MaskList<KeywordMask> *list,
 }
 
 bool PortageUserConfig::CheckFile(Package *p, const char *file, MaskList<KeywordMask> *list, bool *readfile, Keywords::Redundant flag_double, Keywords::Redundant flag_in) const {
+	ReadFileOnce(file, list, readfile);
+	return CheckList(p, list, flag_double, flag_in);
+}
+
+void PortageUserConfig::ReadFileOnce(const char *file, MaskList<KeywordMask> *list, bool *readfile) const {
 	if(!(*readfile)) {
 		ReadVersionFile(((m_settings->m_eprefixconf) + file).c_str(), list);
 		*readfile = true;
 	}
-	return CheckList(p, list, flag_double, flag_in);
+}
+
+void PortageUserConfig::freeze() {
+	ReadFileOnce(USER_USE_FILE, &m_use, &read_use);
+	ReadFileOnce(USER_ENV_FILE, &m_env, &read_env);
+	ReadFileOnce(USER_LICENSE_FILE, &m_license, &read_license);
+	ReadFileOnce(USER_RESTRICT_FILE, &m_restrict, &read_restrict);
+	ReadFileOnce(USER_CFLAGS_FILE, &m_cflags, &read_cflags);
+	m_localmasks.freeze();
+	m_accept_keywords.freeze();
+	m_use.freeze();
+	m_env.freeze();
+	m_license.freeze();
+	m_restrict.freeze();
+	m_cflags.freeze();
+	if(profile != NULLPTR) {
+		profile->freeze();
+	}
 }
 
 static CONSTEXPR const ArchUsed
@@ -1089,24 +1115,21 @@ bool PortageUserConfig::setKeyflags(Package *p, Keywords::Redundant check) const
 
 	UNORDERED_MAP<Version*, WordVec> sorted_by_versions;
 
-	const MaskList<KeywordMask>::Get *keyword_masks(m_accept_keywords.get(p));
-	if(keyword_masks != NULLPTR) {
-		for(MaskList<KeywordMask>::Get::const_iterator it(keyword_masks->begin());
-			likely(it != keyword_masks->end()); ++it) {
-			Mask::Matches matches;
-			it->match(&matches, p);
-			for(Mask::Matches::iterator v(matches.begin());
-				likely(v != matches.end()); ++v) {
-				split_string(&(sorted_by_versions[*v]), it->keywords);
-				// Set RED_DOUBLE_LINE depending on locally_double
-				if(it->locally_double) {
-					if(check & Keywords::RED_DOUBLE_LINE)
-						v->set_redundant((v->get_redundant()) |
-							Keywords::RED_DOUBLE_LINE);
-				}
+	MaskList<KeywordMask>::Get keyword_masks(m_accept_keywords.get(p));
+	for(MaskList<KeywordMask>::Get::const_iterator it(keyword_masks.begin());
+		likely(it != keyword_masks.end()); ++it) {
+		Mask::Matches matches;
+		it->match(&matches, p);
+		for(Mask::Matches::iterator v(matches.begin());
+			likely(v != matches.end()); ++v) {
+			split_string(&(sorted_by_versions[*v]), it->keywords);
+			// Set RED_DOUBLE_LINE depending on locally_double
+			if(it->locally_double) {
+				if(check & Keywords::RED_DOUBLE_LINE)
+					v->set_redundant((v->get_redundant()) |
+						Keywords::RED_DOUBLE_LINE);
 			}
 		}
-		delete keyword_masks;
 	}
 
 	bool rvalue(!sorted_by_versions.empty());
@@ -1128,7 +1151,7 @@ bool PortageUserConfig::setKeyflags(Package *p, Keywords::Redundant check) const
 		}
 		if(kv.size() == kvsize) {
 			// Nothing has changed. In this case, we take defaults:
-			kf.set_keyflags(it->get_keyflags(m_settings->m_accepted_keywords_set));
+			kf.set_keyflags(it->get_keyflags(m_settings->m_accepted_keywords_compiled));
 			it->keyflags = kf;
 			it->save_keyflags(Version::SAVEKEY_ACCEPT);
 		} else {
@@ -1136,7 +1159,7 @@ bool PortageUserConfig::setKeyflags(Package *p, Keywords::Redundant check) const
 			WordSet s;
 			resolve_plus_minus(&s, kv);
 			kv = WordVec(s.begin(), s.end());
-			kf.set_keyflags(it->get_keyflags(s));
+			kf.set_keyflags(it->get_keyflags(AcceptedKeywords(s)));
 			kvsize = kv.size();
 		}
 		bool ori_is_stable(kf.havesome(KeywordsFlags::KEY_STABLE));
@@ -1293,15 +1316,11 @@ bool PortageUserConfig::setKeyflags(Package *p, Keywords::Redundant check) const
 void PortageUserConfig::pushback_set_accepted_keywords(WordVec *result, const Version *v) const {
 	for(Version::SetsIndizes::const_iterator it(v->sets_indizes.begin());
 		unlikely(it != v->sets_indizes.end()); ++it) {
-		const MaskList<KeywordMask>::Get *keyword_masks(m_accept_keywords.get_setname(m_settings->set_names[*it]));
-		if(keyword_masks == NULLPTR) {
-			continue;
-		}
-		for(MaskList<KeywordMask>::Get::const_iterator i(keyword_masks->begin());
-			i != keyword_masks->end(); ++i) {
+		MaskList<KeywordMask>::Get keyword_masks(m_accept_keywords.get_setname(m_settings->set_names[*it]));
+		for(MaskList<KeywordMask>::Get::const_iterator i(keyword_masks.begin());
+			i != keyword_masks.end(); ++i) {
 			split_string(result, i->keywords);
 		}
-		delete keyword_masks;
 	}
 }
 
@@ -1309,14 +1328,14 @@ void PortageUserConfig::pushback_set_accepted_keywords(WordVec *result, const Ve
 Set stability according to arch or local ACCEPT_KEYWORDS
 **/
 void PortageSettings::setKeyflags(Package *p, bool use_accepted_keywords) const {
-	const WordSet *accept_set;
+	const AcceptedKeywords *accept_set;
 	Version::SavedKeyIndex ind;
 	if(use_accepted_keywords) {
 		ind = Version::SAVEKEY_ACCEPT;
-		accept_set = &m_accepted_keywords_set;
+		accept_set = &m_accepted_keywords_compiled;
 	} else {
 		ind = Version::SAVEKEY_ARCH;
-		accept_set = m_auto_arch_set;
+		accept_set = &m_auto_arch_compiled;
 	}
 	if(p->restore_keyflags(ind))
 		return;
@@ -1421,19 +1440,23 @@ void PortageSettings::calc_local_sets(Package *p) const {
 	}
 }
 
+void PortageSettings::init_expands() const {
+	know_expands = true;
+	WordSet use_expands;
+	resolve_plus_minus(&use_expands, (*this)["USE_EXPAND"]);
+	for(WordSet::const_iterator it(use_expands.begin());
+		it != use_expands.end(); ++it) {
+		expand_vars[to_lower(*it)] = *it;
+	}
+}
+
 bool PortageSettings::use_expand(string *var, string *expvar, const string& value) const {
 	string::size_type s(value.size());
 	for(string::size_type pos(0);
 		((pos = value.find('_', pos)) != string::npos) &&
 		(pos != 0) && (pos + 1 < s); ++pos) {
 		if(!know_expands) {
-			know_expands = true;
-			WordSet use_expands;
-			resolve_plus_minus(&use_expands, (*this)["USE_EXPAND"]);
-			for(WordSet::const_iterator it(use_expands.begin());
-				it != use_expands.end(); ++it) {
-				expand_vars[to_lower(*it)] = *it;
-			}
+			init_expands();
 		}
 		const_iterator it(expand_vars.find(value.substr(0, pos)));
 		if(it != expand_vars.end()) {
@@ -1445,9 +1468,28 @@ bool PortageSettings::use_expand(string *var, string *expvar, const string& valu
 	return false;
 }
 
+void PortageSettings::freeze() {
+	if(!know_upgrade_policy) {
+		init_upgrade_policy();
+	}
+	upgrade_policy_exceptions.freeze();
+	m_package_sets.freeze();
+	profile->freeze();
+	if(!know_expands) {
+		init_expands();
+	}
+	if(!world_setslist_up_to_date) {
+		update_world_setslist();
+	}
+	if(user_config != NULLPTR) {
+		user_config->freeze();
+	}
+}
+
 void PortageSettings::init_static() {
 	eix_assert_static(emptystring == NULLPTR);
 	emptystring = new string;
 	OverlayIdent::init_static();
+	AcceptedKeywords::init_static();
 	CascadingProfile::init_static();
 }
@@ -74,6 +74,7 @@ class PortageUserConfig {
 
 		ATTRIBUTE_NONNULL_ bool CheckList(Package *p, const MaskList<KeywordMask> *list, Keywords::Redundant flag_double, Keywords::Redundant flag_in) const;
 		ATTRIBUTE_NONNULL_ bool CheckFile(Package *p, const char *file, MaskList<KeywordMask> *list, bool *readfile, Keywords::Redundant flag_double, Keywords::Redundant flag_in) const;
+		ATTRIBUTE_NONNULL_ void ReadFileOnce(const char *file, MaskList<KeywordMask> *list, bool *readfile) const;
 		ATTRIBUTE_NONNULL_ void ReadVersionFile(const char *file, MaskList<KeywordMask> *list) const;
 
 		ATTRIBUTE_NONNULL_ void pushback_set_accepted_keywords(WordVec *result, const Version *v) const;
@@ -83,6 +84,12 @@ class PortageUserConfig {
 
 		~PortageUserConfig();
 
+		/**
+		Read all files which are otherwise read only on demand,
+		and calculate the lookup data of all MaskLists
+		**/
+		void freeze();
+
 		ATTRIBUTE_NONNULL_ void setProfileMasks(Package *p) const;
 
 		/**
@@ -171,6 +178,7 @@ class PortageSettings : public WordIterateMap {
 		WordSet                  m_accepted_keywords_set, m_arch_set,
 		                         m_plain_accepted_keywords_set,
 		                        *m_local_arch_set, *m_auto_arch_set;
+		AcceptedKeywords         m_accepted_keywords_compiled, m_auto_arch_compiled;
 		std::string              m_raised_arch;
 
 		MaskList<SetMask>        m_package_sets;
@@ -221,6 +229,9 @@ class PortageSettings : public WordIterateMap {
 
 		void update_world_setslist();
 
+		void init_upgrade_policy() const;
+		void init_expands() const;
+
 		bool grab_setmasks(const char *file, SetsIndex i, WordVec *contains_set, bool recursive);
 		bool grab_setmasks(const char *file, SetsIndex i, WordVec *contains_set) {
 			return grab_setmasks(file, i, contains_set, false);
@@ -341,6 +352,13 @@ class PortageSettings : public WordIterateMap {
 
 		ATTRIBUTE_NONNULL_ bool use_expand(std::string *var, std::string *expvar, const std::string& value) const;
 
+		/**
+		Calculate all data which is otherwise calculated on demand.
+		Afterwards, the const methods do not modify the object anymore,
+		and it need not be recalculated in forked children (eix --server).
+		**/
+		void freeze();
+
 		static void init_static();
 };
 
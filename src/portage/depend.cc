@@ -51,20 +51,17 @@ static bool subst_the_same(string *in, const string& from) {
 }
 
 void Depend::set(const string& depend, const string& rdepend, const string& pdepend, const string& bdepend, const string& idepend, bool normspace) {
-	m_depend = depend;
-	m_rdepend = rdepend;
-	m_pdepend = pdepend;
-	m_bdepend = bdepend;
-	m_idepend = idepend;
+	string d(depend), r(rdepend);
 	if(normspace) {
-		trimall(&m_depend);
-		trimall(&m_rdepend);
-		trimall(&m_pdepend);
-		trimall(&m_bdepend);
-		trimall(&m_idepend);
+		trimall(&d);
+		trimall(&r);
 	}
-	subst_the_same(&m_depend, m_rdepend) || \
-		subst_the_same(&m_rdepend, m_depend);
+	subst_the_same(&d, r) || subst_the_same(&r, d);
+	m_depend.assign(d);
+	m_rdepend.assign(r);
+	m_pdepend.assign(pdepend);
+	m_bdepend.assign(bdepend);
+	m_idepend.assign(idepend);
 	obsolete = false;
 }
 
@@ -89,6 +86,11 @@ string Depend::subst(const string& in, const string& text, bool obs) {
 }
 
 bool Depend::operator==(const Depend& d) const {
+	if((obsolete == d.obsolete) && (m_depend == d.m_depend) &&
+		(m_rdepend == d.m_rdepend) && (m_pdepend == d.m_pdepend) &&
+		(m_bdepend == d.m_bdepend) && (m_idepend == d.m_idepend)) {
+		return true;
+	}
 	return ((get_depend() == d.get_depend()) &&
 		(get_rdepend() == d.get_rdepend()) &&
 		(get_pdepend() == d.get_pdepend()) &&
@@ -12,6 +12,8 @@
 
 #include <string>
 
+#include "eixTk/sharedstring.h"
+
 class Database;
 class DBHeader;
 class Version;
@@ -21,7 +23,11 @@ class Depend {
 	friend class Database;
 
 	private:
-		std::string m_depend, m_rdepend, m_pdepend, m_bdepend, m_idepend;
+		/**
+		The words are shared with all other versions; they are only
+		joined (once for each distinct list) when they are needed.
+		**/
+		SharedWords m_depend, m_rdepend, m_pdepend, m_bdepend, m_idepend;
 		bool obsolete;
 
 		static const char c_depend[];
@@ -38,43 +44,43 @@ class Depend {
 		void set(const std::string& depend, const std::string& rdepend, const std::string& pdepend, const std::string& bdepend, const std::string& idepend, bool normspace);
 
 		std::string get_depend() const {
-			return subst(m_depend, m_rdepend, obsolete);
+			return subst(m_depend.get(), m_rdepend.get(), obsolete);
 		}
 
 		std::string get_depend_brief() const {
-			return subst(m_depend, c_rdepend, obsolete);
+			return subst(m_depend.get(), c_rdepend, obsolete);
 		}
 
 		std::string get_rdepend() const {
-			return subst(m_rdepend, m_depend, obsolete);
+			return subst(m_rdepend.get(), m_depend.get(), obsolete);
 		}
 
 		std::string get_rdepend_brief() const {
-			return subst(m_rdepend, c_depend, obsolete);
+			return subst(m_rdepend.get(), c_depend, obsolete);
 		}
 
-		std::string get_pdepend() const {
-			return m_pdepend;
+		const std::string& get_pdepend() const {
+			return m_pdepend.get();
 		}
 
-		std::string get_pdepend_brief() const {
-			return m_pdepend;
+		const std::string& get_pdepend_brief() const {
+			return m_pdepend.get();
 		}
 
-		std::string get_bdepend() const {
-			return m_bdepend;
+		const std::string& get_bdepend() const {
+			return m_bdepend.get();
 		}
 
-		std::string get_bdepend_brief() const {
-			return m_bdepend;
+		const std::string& get_bdepend_brief() const {
+			return m_bdepend.get();
 		}
 
-		std::string get_idepend() const {
-			return m_idepend;
+		const std::string& get_idepend() const {
+			return m_idepend.get();
 		}
 
-		std::string get_idepend_brief() const {
-			return m_idepend;
+		const std::string& get_idepend_brief() const {
+			return m_idepend.get();
 		}
 
 		bool depend_empty() const {
@@ -50,9 +50,16 @@ const ExtendedVersion::HaveBinPkg
 
 bool ExtendedVersion::use_src_uri;
 
+void ExtendedVersion::set_slotname(const string& str) {
+	string slot, subslot;
+	slot_subslot(str, &slot, &subslot);
+	slotname.assign(slot);
+	subslotname.assign(subslot);
+}
+
 string ExtendedVersion::get_longfullslot() const {
-	return (subslotname.empty() ? (slotname.empty() ? "0" : slotname) :
-		(slotname.empty() ? (string("0/") + subslotname) : (slotname + "/" + subslotname)));
+	return (subslotname.empty() ? (slotname.empty() ? "0" : slotname.get()) :
+		(slotname.empty() ? (string("0/") + subslotname.get()) : (slotname.get() + "/" + subslotname.get())));
 }
 
 eix::SignedBool ExtendedVersion::compare(const ExtendedVersion& left, const ExtendedVersion& right) {
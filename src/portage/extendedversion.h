@@ -18,6 +18,7 @@
 #include "eixTk/dialect.h"
 #include "eixTk/eixint.h"
 #include "eixTk/inttypes.h"
+#include "eixTk/sharedstring.h"
 #include "eixTk/stringutils.h"
 #include "portage/basicversion.h"
 #include "portage/depend.h"
@@ -75,8 +76,8 @@ class ExtendedVersion : public BasicVersion {
 		The slot, the version represents.
 		For saving space, the default "0" is always stored as ""
 		**/
-		std::string slotname;
-		std::string subslotname;
+		SharedString slotname;
+		SharedString subslotname;
 
 		/**
 		The repository name
@@ -124,18 +125,16 @@ class ExtendedVersion : public BasicVersion {
 			propertiesFlags = calcProperties(str);
 		}
 
-		void set_slotname(const std::string& str) {
-			slot_subslot(str, &slotname, &subslotname);
-		}
+		void set_slotname(const std::string& str);
 
 		std::string get_shortfullslot() const {
-			return (subslotname.empty() ? slotname : (slotname + "/" + subslotname));
+			return (subslotname.empty() ? slotname.get() : (slotname.get() + "/" + subslotname.get()));
 		}
 
 		std::string get_longfullslot() const;
 
 		std::string get_longslot() const {
-			return (slotname.empty() ? "0" : slotname);
+			return (slotname.empty() ? "0" : slotname.get());
 		}
 
 		void assign_basic_version(const BasicVersion& b) {
@@ -12,11 +12,16 @@
 
 #include <algorithm>
 #include <string>
+#include <vector>
 
+#include "eixTk/assert.h"
 #include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
 #include "eixTk/likely.h"
+#include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
 
 using std::string;
 
@@ -45,9 +50,93 @@ const KeywordsFlags::KeyType
 	KeywordsFlags::KEY_SOMEUNSTABLE,
 	KeywordsFlags::KEY_TILDESTARMATCH;
 
+/**
+A token of a KEYWORDS string in parsed form
+**/
+class KeywordToken {
+	public:
+		typedef eix::UChar Kind;
+		static CONSTEXPR const Kind
+			MINUS_ASTERISK = 0,  ///< -*
+			MINUS_UNSTABLE = 1,  ///< -~*
+			MINUS          = 2,  ///< -KEYWORD
+			ASTERISK       = 3,  ///< *
+			TILDE_ASTERISK = 4,  ///< ~*
+			TILDE          = 5,  ///< ~KEYWORD
+			PLAIN          = 6;  ///< KEYWORD
+
+		Kind kind;
+		/**
+		Index of the token and of the token without its first character
+		**/
+		AcceptedKeywords::Index self, base;
+};
+
+typedef std::vector<KeywordToken> KeywordTokens;
+typedef UNORDERED_MAP<string, AcceptedKeywords::Index> KeywordIndexMap;
+typedef UNORDERED_MAP<string, KeywordTokens> KeywordTokensMap;
+static KeywordIndexMap *keyword_index(NULLPTR);
+static KeywordTokensMap *keyword_tokens(NULLPTR);
+
+void AcceptedKeywords::init_static() {
+	eix_assert_static(keyword_index == NULLPTR);
+	keyword_index = new KeywordIndexMap;
+	keyword_tokens = new KeywordTokensMap;
+}
+
+static AcceptedKeywords::Index get_keyword_index(const string& keyword);
+static const KeywordTokens& get_keyword_tokens(const string& keywords);
 inline static bool is_not_testing(const string& s);
 inline static bool is_testing(const string& s);
 
+static AcceptedKeywords::Index get_keyword_index(const string& keyword) {
+	eix_assert_static(keyword_index != NULLPTR);
+	KeywordIndexMap::const_iterator it(keyword_index->find(keyword));
+	if(likely(it != keyword_index->end())) {
+		return it->second;
+	}
+	AcceptedKeywords::Index i(keyword_index->size());
+	(*keyword_index)[keyword] = i;
+	return i;
+}
+
+static const KeywordTokens& get_keyword_tokens(const string& keywords) {
+	eix_assert_static(keyword_tokens != NULLPTR);
+	KeywordTokensMap::const_iterator it(keyword_tokens->find(keywords));
+	if(likely(it != keyword_tokens->end())) {
+		return it->second;
+	}
+	KeywordTokens& tokens((*keyword_tokens)[keywords]);
+	WordVec keywords_vec;
+	split_string(&keywords_vec, keywords);
+	tokens.resize(keywords_vec.size());
+	KeywordTokens::iterator t(tokens.begin());
+	for(WordVec::const_iterator k(keywords_vec.begin());
+		likely(k != keywords_vec.end()); ++k, ++t) {
+		t->base = t->self = get_keyword_index(*k);
+		if((*k)[0] == '-') {
+			if(*k == "-*") {
+				t->kind = KeywordToken::MINUS_ASTERISK;
+			} else if(*k == "-~*") {
+				t->kind = KeywordToken::MINUS_UNSTABLE;
+			} else {
+				t->kind = KeywordToken::MINUS;
+				t->base = get_keyword_index(k->substr(1));
+			}
+		} else if(*k == "*") {
+			t->kind = KeywordToken::ASTERISK;
+		} else if(*k == "~*") {
+			t->kind = KeywordToken::TILDE_ASTERISK;
+		} else if((*k)[0] == '~') {
+			t->kind = KeywordToken::TILDE;
+			t->base = get_keyword_index(k->substr(1));
+		} else {
+			t->kind = KeywordToken::PLAIN;
+		}
+	}
+	return tokens;
+}
+
 inline static bool is_not_testing(const string& s) {
 	char c(s[0]);
 	return ((c != '~') && (c != '-'));
@@ -57,67 +146,87 @@ inline static bool is_testing(const string& s) {
 	return (s[0] == '~');
 }
 
-KeywordsFlags::KeyType KeywordsFlags::get_keyflags(const WordSet& accepted_keywords, const string& keywords) {
-	KeyType m(KEY_EMPTY);
-	WordVec keywords_vec;
-	split_string(&keywords_vec, keywords);
-	for(WordVec::const_iterator it(keywords_vec.begin());
-		likely(it != keywords_vec.end()); ++it) {
-		if((*it)[0] == '-') {
-			if(*it == "-*") {
-				m |= KEY_MINUSASTERISK;
-			} else if(*it == "-~*") {
-				m |= KEY_MINUSUNSTABLE;
-			} else if(accepted_keywords.count(it->substr(1)) != 0) {
-				m |= KEY_MINUSKEYWORD;
-			}
-			continue;
-		}
-		if(*it == "*") {
-			m |= KEY_SOMESTABLE;
-			if(find_if(accepted_keywords.begin(), accepted_keywords.end(), is_not_testing)
-				!= accepted_keywords.end()) {
-				m |= KEY_STABLE;
-			}
-			continue;
-		}
-		bool found(false);
-		if(accepted_keywords.count(*it) != 0) {
-			found = true;
-			m |= (KEY_STABLE | KEY_SOMESTABLE);
+void AcceptedKeywords::assign(const WordSet& accepted_keywords) {
+	m_accepted.clear();
+	for(WordSet::const_iterator it(accepted_keywords.begin());
+		likely(it != accepted_keywords.end()); ++it) {
+		Index i(get_keyword_index(*it));
+		if(i >= m_accepted.size()) {
+			m_accepted.resize(i + 1, false);
 		}
-		if((*it)[0] == '~') {
-			if(found) {
-				m |= KEY_ARCHUNSTABLE;
-			} else if(*it == "~*") {
-				m |= KEY_SOMEUNSTABLE;
-				if(find_if(accepted_keywords.begin(), accepted_keywords.end(), is_testing)
-					!= accepted_keywords.end()) {
-					m |= KEY_STABLE;
+		m_accepted[i] = true;
+	}
+	m_have_stable = (find_if(accepted_keywords.begin(), accepted_keywords.end(), is_not_testing)
+		!= accepted_keywords.end());
+	m_have_testing = (find_if(accepted_keywords.begin(), accepted_keywords.end(), is_testing)
+		!= accepted_keywords.end());
+	m_accept_all = (accepted_keywords.count("**") != 0);
+	m_accept_star = (accepted_keywords.count("*") != 0);
+	m_accept_tildestar = (accepted_keywords.count("~*") != 0);
+}
+
+KeywordsFlags::KeyType AcceptedKeywords::get_keyflags(const string& keywords) const {
+	KeywordsFlags::KeyType m(KeywordsFlags::KEY_EMPTY);
+	const KeywordTokens& tokens(get_keyword_tokens(keywords));
+	for(KeywordTokens::const_iterator it(tokens.begin());
+		likely(it != tokens.end()); ++it) {
+		bool found(accepted(it->self));
+		switch(it->kind) {
+			case KeywordToken::MINUS_ASTERISK:
+				m |= KeywordsFlags::KEY_MINUSASTERISK;
+				break;
+			case KeywordToken::MINUS_UNSTABLE:
+				m |= KeywordsFlags::KEY_MINUSUNSTABLE;
+				break;
+			case KeywordToken::MINUS:
+				if(accepted(it->base)) {
+					m |= KeywordsFlags::KEY_MINUSKEYWORD;
 				}
-			} else if(accepted_keywords.count(it->substr(1)) != 0) {
-				m |= KEY_ARCHUNSTABLE;
-			} else {
-				m |= KEY_ALIENUNSTABLE;
-			}
-		} else if((*it)[0] != '-') {
-			m |= (found ? KEY_ARCHSTABLE : KEY_ALIENSTABLE);
+				break;
+			case KeywordToken::ASTERISK:
+				m |= KeywordsFlags::KEY_SOMESTABLE;
+				if(m_have_stable) {
+					m |= KeywordsFlags::KEY_STABLE;
+				}
+				break;
+			case KeywordToken::TILDE_ASTERISK:
+				if(found) {
+					m |= (KeywordsFlags::KEY_STABLE | KeywordsFlags::KEY_SOMESTABLE | KeywordsFlags::KEY_ARCHUNSTABLE);
+					break;
+				}
+				m |= KeywordsFlags::KEY_SOMEUNSTABLE;
+				if(m_have_testing) {
+					m |= KeywordsFlags::KEY_STABLE;
+				}
+				break;
+			case KeywordToken::TILDE:
+				if(found) {
+					m |= (KeywordsFlags::KEY_STABLE | KeywordsFlags::KEY_SOMESTABLE | KeywordsFlags::KEY_ARCHUNSTABLE);
+				} else {
+					m |= (accepted(it->base) ? KeywordsFlags::KEY_ARCHUNSTABLE : KeywordsFlags::KEY_ALIENUNSTABLE);
+				}
+				break;
+			default:  // KeywordToken::PLAIN
+				m |= (found ?
+					(KeywordsFlags::KEY_STABLE | KeywordsFlags::KEY_SOMESTABLE | KeywordsFlags::KEY_ARCHSTABLE) :
+					KeywordsFlags::KEY_ALIENSTABLE);
+				break;
 		}
 	}
-	if(m & KEY_STABLE) {
+	if(m & KeywordsFlags::KEY_STABLE) {
 		return m;
 	}
-	if(accepted_keywords.count("**") != 0) {
-		return (m | KEY_STABLE);
+	if(m_accept_all) {
+		return (m | KeywordsFlags::KEY_STABLE);
 	}
-	if(m & KEY_SOMESTABLE) {
-		if(accepted_keywords.count("*") != 0) {
-			return (m | KEY_STABLE);
+	if(m & KeywordsFlags::KEY_SOMESTABLE) {
+		if(m_accept_star) {
+			return (m | KeywordsFlags::KEY_STABLE);
 		}
 	}
-	if(m & KEY_TILDESTARMATCH) {
-		if(accepted_keywords.count("~*") != 0) {
-			return (m | KEY_STABLE);
+	if(m & KeywordsFlags::KEY_TILDESTARMATCH) {
+		if(m_accept_tildestar) {
+			return (m | KeywordsFlags::KEY_STABLE);
 		}
 	}
 	return m;
@@ -13,6 +13,7 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <string>
+#include <vector>
 
 #include "eixTk/dialect.h"
 #include "eixTk/eixint.h"
@@ -154,8 +155,6 @@ class KeywordsFlags {
 			KEY_SOMEUNSTABLE   = KEY_ARCHUNSTABLE|KEY_ALIENUNSTABLE,
 			KEY_TILDESTARMATCH = KEY_SOMESTABLE|KEY_SOMEUNSTABLE;
 
-		static KeyType get_keyflags(const WordSet& accepted_keywords, const std::string& keywords);
-
 		KeywordsFlags() : m_keyword(KEY_EMPTY) {
 		}
 
@@ -261,6 +260,40 @@ class KeywordsFlags {
 		KeyType m_keyword;
 };
 
+/**
+Precompiled set of accepted keywords.
+Every keyword gets a global index, and the set is stored as a bitmap over
+these indices. Also the tokens of each KEYWORDS string are looked up only
+once, so that get_keyflags() needs only a few bit tests per token.
+**/
+class AcceptedKeywords {
+	public:
+		typedef std::vector<bool>::size_type Index;
+
+		static void init_static();  // must be called exactly once
+
+		AcceptedKeywords() {
+			assign(WordSet());
+		}
+
+		explicit AcceptedKeywords(const WordSet& accepted_keywords) {
+			assign(accepted_keywords);
+		}
+
+		void assign(const WordSet& accepted_keywords);
+
+		KeywordsFlags::KeyType get_keyflags(const std::string& keywords) const;
+
+	private:
+		std::vector<bool> m_accepted;
+		bool m_have_stable, m_have_testing;
+		bool m_accept_all, m_accept_star, m_accept_tildestar;
+
+		bool accepted(Index i) const {
+			return ((i < m_accepted.size()) && m_accepted[i]);
+		}
+};
+
 inline static bool operator==(const KeywordsFlags& left, const KeywordsFlags& right) {
 	return (left.get() == right.get());
 }
@@ -12,6 +12,7 @@
 
 #include <fnmatch.h>
 
+#include <algorithm>
 #include <cstring>
 
 #include <string>
@@ -261,11 +262,7 @@ void Mask::to_package(Package *p) const {
 	p->addVersion(v);
 }
 
-/**
-Test if the mask applies to a Version.
-@return true if applies.
-**/
-bool Mask::test(const ExtendedVersion *ev) const {
+bool Mask::test_extra(const ExtendedVersion *ev) const {
 	if(m_test_slot) {
 		if(m_slotname != ev->slotname) {
 			return false;
@@ -281,6 +278,10 @@ bool Mask::test(const ExtendedVersion *ev) const {
 			return false;
 		}
 	}
+	return true;
+}
+
+bool Mask::test_version(const BasicVersion *ev) const {
 	switch(m_operator) {
 		case maskOpAll:
 			return true;
@@ -316,17 +317,90 @@ bool Mask::test(const ExtendedVersion *ev) const {
 	return false;
 }
 
+/**
+Predicates for std::lower_bound over a sorted version list
+**/
+static bool version_less(const Version *v, const BasicVersion *m);
+static bool version_less_equal(const Version *v, const BasicVersion *m);
+static bool before_revisions(const Version *v, const BasicVersion *m);
+static bool not_after_revisions(const Version *v, const BasicVersion *m);
+
+static bool version_less(const Version *v, const BasicVersion *m) {
+	return (BasicVersion::compare(*v, *m) < 0);
+}
+
+static bool version_less_equal(const Version *v, const BasicVersion *m) {
+	return (BasicVersion::compare(*v, *m) <= 0);
+}
+
+/**
+The versions matching ~m are contiguous: Versions with a suffix smaller
+than a revision (like _alpha) are smaller than m, the others larger
+than all revisions.
+**/
+static bool before_revisions(const Version *v, const BasicVersion *m) {
+	return ((BasicVersion::compare(*v, *m) < 0) &&
+		(BasicVersion::compareTilde(*v, *m) != 0));
+}
+
+static bool not_after_revisions(const Version *v, const BasicVersion *m) {
+	return ((BasicVersion::compare(*v, *m) <= 0) ||
+		(BasicVersion::compareTilde(*v, *m) == 0));
+}
+
+template<typename It> bool Mask::narrow(It *first, It *last) const {
+	const BasicVersion *m(this);
+	switch(m_operator) {
+		case maskOpLess:
+			*last = std::lower_bound(*first, *last, m, version_less);
+			return true;
+
+		case maskOpLessEqual:
+			*last = std::lower_bound(*first, *last, m, version_less_equal);
+			return true;
+
+		case maskOpEqual:
+			*first = std::lower_bound(*first, *last, m, version_less);
+			*last = std::lower_bound(*first, *last, m, version_less_equal);
+			return true;
+
+		case maskOpGreaterEqual:
+			*first = std::lower_bound(*first, *last, m, version_less);
+			return true;
+
+		case maskOpGreater:
+			*first = std::lower_bound(*first, *last, m, version_less_equal);
+			return true;
+
+		case maskOpRevisions:
+			*first = std::lower_bound(*first, *last, m, before_revisions);
+			*last = std::lower_bound(*first, *last, m, not_after_revisions);
+			return true;
+
+		// maskOpGlob is not contiguous: =1.2* matches 1.2.3 and 1.20
+		default:
+			break;
+	}
+	return false;
+}
+
 void Mask::match(Matches *m, Package *pkg) const {
-	for(Package::iterator it(pkg->begin()); likely(it != pkg->end()); ++it) {
-		if(test(*it)) {
-			m->PUSH_BACK(*it);
+	Package::iterator first(pkg->begin());
+	Package::iterator last(pkg->end());
+	bool exact(narrow(&first, &last));
+	for(; likely(first != last); ++first) {
+		if(test(*first, exact)) {
+			m->PUSH_BACK(*first);
 		}
 	}
 }
 
 bool Mask::have_match(const Package& pkg) const {
-	for(Package::const_iterator it(pkg.begin()); likely(it != pkg.end()); ++it) {
-		if(test(*it)) {
+	Package::const_iterator first(pkg.begin());
+	Package::const_iterator last(pkg.end());
+	bool exact(narrow(&first, &last));
+	for(; likely(first != last); ++first) {
+		if(test(*first, exact)) {
 			return true;
 		}
 	}
@@ -339,34 +413,56 @@ Set the stability members of all version in package according to the mask.
 @param check          Redundancy checks which should apply
 **/
 void Mask::checkMask(Package *pkg, Keywords::Redundant check) const {
-	for(Package::iterator i(pkg->begin()); likely(i != pkg->end()); ++i) {
-		apply(*i, true, check);
+	if(m_type == maskInSystem) {
+		// apply() modifies also the versions which do not match
+		for(Package::iterator i(pkg->begin()); likely(i != pkg->end()); ++i) {
+			apply(*i, true, check);
+		}
+		return;
+	}
+	// For the other types, apply() does nothing if the test fails
+	Package::iterator first(pkg->begin());
+	Package::iterator last(pkg->end());
+	bool exact(narrow(&first, &last));
+	for(; likely(first != last); ++first) {
+		if(test(*first, exact)) {
+			apply(*first, false, check);
+		}
 	}
 }
 
 void KeywordMask::applyItem(Package *pkg) const {
-	for(Package::iterator i(pkg->begin()); likely(i != pkg->end()); ++i) {
-		if(test(*i)) {
-			applyItem(*i);
+	Package::iterator first(pkg->begin());
+	Package::iterator last(pkg->end());
+	bool exact(narrow(&first, &last));
+	for(; likely(first != last); ++first) {
+		if(test(*first, exact)) {
+			applyItem(*first);
 		}
 	}
 }
 
 void PKeywordMask::applyItem(Package *pkg) const {
-	for(Package::iterator i(pkg->begin()); likely(i != pkg->end()); ++i) {
-		if(test(*i)) {
-			applyItem(*i);
+	Package::iterator first(pkg->begin());
+	Package::iterator last(pkg->end());
+	bool exact(narrow(&first, &last));
+	for(; likely(first != last); ++first) {
+		if(test(*first, exact)) {
+			applyItem(*first);
 		}
 	}
 }
 
 void SetMask::applyItem(Package *pkg) const {
-	for(Package::iterator i(pkg->begin()); likely(i != pkg->end()); ++i) {
-		if(i->is_in_set(m_set))  // No need to check: Already in set
+	Package::iterator first(pkg->begin());
+	Package::iterator last(pkg->end());
+	bool exact(narrow(&first, &last));
+	for(; likely(first != last); ++first) {
+		if(first->is_in_set(m_set))  // No need to check: Already in set
 			continue;
-		if(!test(*i))
+		if(!test(*first, exact))
 			continue;
-		i->add_to_set(m_set);
+		first->add_to_set(m_set);
 	}
 }
 
@@ -374,11 +470,7 @@ bool Mask::ismatch(const Package& pkg) const {
 	if((fnmatch(m_name.c_str(), pkg.name.c_str(), 0) != 0) ||
 		(fnmatch(m_category.c_str(), pkg.category.c_str(), 0) != 0))
 		return false;
-	for(Package::const_iterator i(pkg.begin()); likely(i != pkg.end()); ++i) {
-		if(test(*i))
-			return true;
-	}
-	return false;
+	return have_match(pkg);
 }
 
 /**
@@ -85,7 +85,34 @@ class Mask : public BasicVersion {
 		@param ev test this version
 		@return true if applies.
 		**/
-		ATTRIBUTE_NONNULL_ bool test(const ExtendedVersion *ev) const;
+		ATTRIBUTE_NONNULL_ bool test(const ExtendedVersion *ev) const {
+			return (test_extra(ev) && test_version(ev));
+		}
+
+		/**
+		Test slot, subslot and repository of ev
+		**/
+		ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE bool test_extra(const ExtendedVersion *ev) const;
+
+		/**
+		Test the version of ev according to the operator
+		**/
+		ATTRIBUTE_NONNULL_ bool test_version(const BasicVersion *ev) const;
+
+		/**
+		Narrow the range [*first, *last) of a sorted version list to the
+		versions which can match by binary search.
+		@return true if all versions of the result match the operator,
+		i.e. if only test_extra() remains to be checked
+		**/
+		template<typename It> bool narrow(It *first, It *last) const;
+
+		/**
+		@return test_extra(ev) if exact, test(ev) otherwise
+		**/
+		ATTRIBUTE_NONNULL_ bool test(const ExtendedVersion *ev, bool exact) const {
+			return (exact ? test_extra(ev) : test(ev));
+		}
 
 	public:
 		typedef eix::ptr_container<std::vector<Version *> > Matches;
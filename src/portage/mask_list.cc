@@ -88,32 +88,25 @@ template<> ATTRIBUTE_NONNULL_ bool MaskList<Mask>::add_file(const char *file, Ma
 
 // return true if some mask matches
 template<> ATTRIBUTE_NONNULL_ bool MaskList<Mask>::MaskMatches(Package *p) const {
-	Get *masks(get(p));
-	if(likely(masks == NULLPTR)) {
-		return false;
-	}
-	bool ret(false);
-	for(Get::const_iterator it(masks->begin());
-		likely(it != masks->end()); ++it) {
+	Get masks(get(p));
+	for(Get::const_iterator it(masks.begin());
+		likely(it != masks.end()); ++it) {
 		if(it->ismatch(*p)) {
-			ret = true;
-			break;
+			return true;
 		}
 	}
-	delete masks;
-	return ret;
+	return false;
 }
 
 // return true if some mask potentially applied
 template<> ATTRIBUTE_NONNULL_ bool MaskList<Mask>::applyMasks(Package *p, Keywords::Redundant check) const {
-	Get *masks(get(p));
-	if(masks == NULLPTR) {
-		return false;
-	}
+	Get masks(get(p));
+	bool applied(false);
 	bool had_mask(false);
 	bool had_unmask(false);
-	for(Get::const_iterator it(masks->begin());
-		likely(it != masks->end()); ++it) {
+	for(Get::const_iterator it(masks.begin());
+		likely(it != masks.end()); ++it) {
+		applied = true;
 		it->checkMask(p, check);
 		switch(it->get_type()) {
 			case Mask::maskMask:
@@ -126,7 +119,9 @@ template<> ATTRIBUTE_NONNULL_ bool MaskList<Mask>::applyMasks(Package *p, Keywor
 				break;
 		}
 	}
-	delete masks;
+	if(!applied) {
+		return false;
+	}
 	if(!(check & Keywords::RED_MASK)) {
 		had_mask = false;
 	}
@@ -150,15 +145,11 @@ template<> ATTRIBUTE_NONNULL_ bool MaskList<Mask>::applyMasks(Package *p, Keywor
 }
 
 template<> ATTRIBUTE_NONNULL_ void MaskList<Mask>::applySetMasks(Version *v, const string& set_name) const {
-	Get *masks(get_setname(set_name));
-	if(masks == NULLPTR) {
-		return;
-	}
-	for(Get::const_iterator it(masks->begin());
-		likely(it != masks->end()); ++it) {
+	Get masks(get_setname(set_name));
+	for(Get::const_iterator it(masks.begin());
+		likely(it != masks.end()); ++it) {
 		it->apply(v, false, Keywords::RED_NOTHING);
 	}
-	delete masks;
 }
 
 PreListFilename::PreListFilename(const string& n, const char *label, bool only_repo) {
@@ -16,6 +16,7 @@
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "eixTk/attribute.h"
@@ -23,9 +24,9 @@
 #include "eixTk/forward_list.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
-#include "eixTk/ptr_container.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
 #include "portage/keywords.h"
 #include "portage/mask.h"
 #include "portage/package.h"
@@ -66,11 +67,167 @@ template<typename m_Type> class MaskList {
 		typedef typename std::map<std::string, Masks<m_Type> > ExactType;
 		typedef typename ExactType::const_iterator exact_const_iterator;
 
+		typedef typename std::vector<const m_Type *> FrozenList;
+		typedef typename FrozenList::size_type FrozenIndex;
+		typedef typename std::pair<FrozenIndex, FrozenIndex> FrozenRange;
+		typedef typename std::pair<std::string, FrozenRange> FrozenPattern;
+		typedef typename std::vector<FrozenPattern> FrozenPatterns;
+		typedef typename FrozenPatterns::size_type PatternIndex;
+		typedef UNORDERED_MAP<std::string, FrozenRange> FrozenExact;
+
 		ExactType exact_name;
 		FullType full_name;
 
+		/**
+		Pointers to all masks in the order in which get() returns them,
+		and the ranges of each pattern and of each exact name therein.
+		This is calculated by freeze() or by the first get() after add().
+		**/
+		mutable FrozenList frozen;
+		mutable FrozenPatterns frozen_patterns;
+		mutable FrozenExact frozen_exact;
+		mutable bool is_frozen;
+
+		ATTRIBUTE_NONNULL_ void push_frozen(FrozenRange *range, const Masks<m_Type>& masks) const {
+			range->first = frozen.size();
+			for(m_const_iterator m(masks.begin()); likely(m != masks.end()); ++m) {
+				frozen.PUSH_BACK(&*m);
+			}
+			range->second = frozen.size();
+		}
+
+		void calc_frozen() const {
+			frozen.clear();
+			frozen_patterns.clear();
+			frozen_exact.clear();
+			for(full_const_iterator it(full_name.begin());
+				likely(it != full_name.end()); ++it) {
+				frozen_patterns.EMPLACE_BACK(FrozenPattern, (it->first, FrozenRange()));
+				push_frozen(&(frozen_patterns.back().second), it->second);
+			}
+			for(exact_const_iterator it(exact_name.begin());
+				likely(it != exact_name.end()); ++it) {
+				push_frozen(&(frozen_exact[it->first]), it->second);
+			}
+			is_frozen = true;
+		}
+
 	public:
-		typedef typename eix::ptr_container<std::vector<const m_Type *> > Get;
+		/**
+		The masks for a name: Those of all matching patterns, followed by
+		those of the exact name. This is only a view into the MaskList:
+		It must not be used after the MaskList is modified.
+		**/
+		class Get {
+				friend class MaskList;
+
+			private:
+				const MaskList *m_list;
+				std::string m_full;
+				FrozenRange m_exact;
+
+				Get(const MaskList *list, const std::string& full) : m_list(list), m_full(full), m_exact(0, 0) {
+					typename FrozenExact::const_iterator it(list->frozen_exact.find(full));
+					if(it != list->frozen_exact.end()) {
+						m_exact = it->second;
+					}
+				}
+
+				/**
+				@return the range of pattern i (or of the exact name if i is
+				the number of patterns); the range is empty if it does not match
+				**/
+				FrozenRange range(PatternIndex i) const {
+					if(i == m_list->frozen_patterns.size()) {
+						return m_exact;
+					}
+					const FrozenPattern& pattern(m_list->frozen_patterns[i]);
+					if(unlikely(match_full(pattern.first, m_full))) {
+						return pattern.second;
+					}
+					return FrozenRange(0, 0);
+				}
+
+			public:
+				class const_iterator {
+						friend class Get;
+
+					private:
+						const Get *m_get;
+						PatternIndex m_pattern;
+						FrozenRange m_range;
+
+						const_iterator(const Get *get, PatternIndex pattern) : m_get(get), m_pattern(pattern), m_range(get->range(pattern)) {
+							settle();
+						}
+
+						explicit const_iterator(const Get *get) : m_get(get), m_pattern(get->m_list->frozen_patterns.size() + 1), m_range(0, 0) {
+						}
+
+						/**
+						Proceed to the next nonempty range unless we are in one
+						**/
+						void settle() {
+							PatternIndex patterns(m_get->m_list->frozen_patterns.size());
+							while(m_range.first == m_range.second) {
+								if(m_pattern >= patterns) {
+									m_pattern = patterns + 1;
+									m_range.first = m_range.second = 0;
+									return;
+								}
+								m_range = m_get->range(++m_pattern);
+							}
+						}
+
+					public:
+						const m_Type& operator*() const {
+							return *(m_get->m_list->frozen[m_range.first]);
+						}
+
+						const m_Type *operator->() const {
+							return m_get->m_list->frozen[m_range.first];
+						}
+
+						const_iterator& operator++() {
+							++(m_range.first);
+							settle();
+							return *this;
+						}
+
+						bool operator==(const const_iterator& other) const {
+							return ((m_pattern == other.m_pattern) &&
+								(m_range.first == other.m_range.first));
+						}
+
+						bool operator!=(const const_iterator& other) const {
+							return !(*this == other);
+						}
+				};
+
+				const_iterator begin() const {
+					return const_iterator(this, 0);
+				}
+
+				const_iterator end() const {
+					return const_iterator(this);
+				}
+		};
+
+		MaskList() : is_frozen(false) {
+		}
+
+		/**
+		The frozen data of a copy must point into the copy
+		**/
+		MaskList(const MaskList& other) : exact_name(other.exact_name), full_name(other.full_name), is_frozen(false) {
+		}
+
+		MaskList& operator=(const MaskList& other) {
+			exact_name = other.exact_name;
+			full_name = other.full_name;
+			is_frozen = false;
+			return *this;
+		}
 
 		bool empty() const {
 			return (exact_name.empty() && full_name.empty());
@@ -79,6 +236,7 @@ template<typename m_Type> class MaskList {
 		void clear() {
 			exact_name.clear();
 			full_name.clear();
+			is_frozen = false;
 		}
 
 		inline static bool match_full(const std::string& mask, const std::string& name) {
@@ -102,35 +260,24 @@ template<typename m_Type> class MaskList {
 			return match_full(p->category + "/" + p->name);
 		}
 
-		ATTRIBUTE_NONNULL_ inline static void push_result(Get **l, const Masks<m_Type>& r) {
-			if(*l == NULLPTR) {
-				*l = new Get;
-			}
-			for(m_const_iterator m(r.begin()); likely(m != r.end()); ++m) {
-				(*l)->PUSH_BACK(&*m);
+		Get get_full(const std::string& full) const {
+			if(unlikely(!is_frozen)) {
+				calc_frozen();
 			}
+			return Get(this, full);
 		}
 
-		Get *get_full(const std::string& full) const {
-			Get *l(NULLPTR);
-			for(full_const_iterator it(full_name.begin());
-				likely(it != full_name.end()); ++it) {
-				if(unlikely(match_full(it->first, full))) {
-					push_result(&l, it->second);
-				}
+		Get get_setname(const std::string& setname) const {
+			if(empty()) {
+				return get_full(std::string());
 			}
-			exact_const_iterator it(exact_name.find(full));
-			if(it != exact_name.end()) {
-				push_result(&l, it->second);
-			}
-			return l;
-		}
-
-		Get *get_setname(const std::string& setname) const {
 			return get_full(std::string(SET_CATEGORY) + "/" + setname);
 		}
 
-		ATTRIBUTE_NONNULL_ Get *get(const Package *p) const {
+		ATTRIBUTE_NONNULL_ Get get(const Package *p) const {
+			if(empty()) {
+				return get_full(std::string());
+			}
 			return get_full(p->category + "/" + p->name);
 		}
 
@@ -140,9 +287,10 @@ template<typename m_Type> class MaskList {
 			full.append(m.getName());
 			if(full.find_first_of("*?[") == std::string::npos) {
 				exact_name[full].add(m);
-				return;
+			} else {
+				full_name[full].add(m);
 			}
-			full_name[full].add(m);
+			is_frozen = false;
 		}
 
 		/**
@@ -160,28 +308,30 @@ template<typename m_Type> class MaskList {
 		void finalize() {
 		}
 
-		ATTRIBUTE_NONNULL_ void applyListItems(Package *p) const {
-			Get *masks(get(p));
-			if(masks == NULLPTR) {
-				return;
+		/**
+		Calculate the data for get() now, so that the const methods
+		do not modify the object anymore
+		**/
+		void freeze() const {
+			if(!is_frozen) {
+				calc_frozen();
 			}
-			for(typename Get::const_iterator it(masks->begin());
-				likely(it != masks->end()); ++it) {
+		}
+
+		ATTRIBUTE_NONNULL_ void applyListItems(Package *p) const {
+			Get masks(get(p));
+			for(typename Get::const_iterator it(masks.begin());
+				likely(it != masks.end()); ++it) {
 				it->applyItem(p);
 			}
-			delete masks;
 		}
 
 		ATTRIBUTE_NONNULL_ void applyListSetItems(Version *v, const std::string& set_name) const {
-			Get *masks(get_setname(set_name));
-			if(masks == NULLPTR) {
-				return;
-			}
-			for(typename Get::const_iterator it(masks->begin());
-				likely(it != masks->end()); ++it) {
+			Get masks(get_setname(set_name));
+			for(typename Get::const_iterator it(masks.begin());
+				likely(it != masks.end()); ++it) {
 				it->applyItem(v);
 			}
-			delete masks;
 		}
 
 		/**
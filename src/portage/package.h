@@ -25,6 +25,7 @@
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/ptr_container.h"
+#include "eixTk/sharedstring.h"
 #include "eixTk/unordered_map.h"
 #include "portage/basicversion.h"
 #include "portage/extendedversion.h"
@@ -453,7 +454,7 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 		Get the name of a slot/subslot of a version.
 		returns true if found.
 		**/
-		bool get_slotsubslot(const ExtendedVersion& v, std::string *slot, std::string *subslot) const;
+		bool get_slotsubslot(const ExtendedVersion& v, SharedString *slot, SharedString *subslot) const;
 
 		/**
 		Get the name of a slot of an installed version,
@@ -495,7 +496,7 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 		This is for caching in guess_slotname
 		**/
 		mutable bool m_has_cached_subslots, m_unique_subslot;
-		mutable std::string m_subslot;
+		mutable SharedString m_subslot;
 
 		/**
 		Create new slotlist. Const because we operate on mutable cache types.
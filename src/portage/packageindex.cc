@@ -0,0 +1,162 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "portage/packageindex.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "eixTk/dialect.h"
+#include "eixTk/likely.h"
+#include "eixTk/sharedstring.h"
+#include "portage/mask.h"
+#include "portage/package.h"
+#include "portage/version.h"
+
+using std::string;
+using std::vector;
+
+/**
+Order of package indices by category and name
+**/
+class PackageIndexLess {
+	public:
+		PackageIndexLess(const vector<SharedString>& categories, const vector<SharedString>& names)
+			: m_categories(categories), m_names(names) {
+		}
+
+		bool operator()(PackageIndex::size_type a, PackageIndex::size_type b) const {
+			int c(m_categories[a].get().compare(m_categories[b].get()));
+			if(c != 0) {
+				return (c < 0);
+			}
+			return (m_names[a].get() < m_names[b].get());
+		}
+
+	private:
+		const vector<SharedString>& m_categories;
+		const vector<SharedString>& m_names;
+};
+
+class SharedStringLess {
+	public:
+		bool operator()(const SharedString& a, const string& b) const {
+			return (a.get() < b);
+		}
+
+		bool operator()(const string& a, const SharedString& b) const {
+			return (a < b.get());
+		}
+};
+
+void PackageIndex::add(const Package& pkg) {
+	if(m_sorted && !m_names.empty()) {
+		int c(m_categories.back().get().compare(pkg.category));
+		if((c > 0) || ((c == 0) && !(m_names.back().get() < pkg.name))) {
+			m_sorted = false;
+		}
+	}
+	m_categories.PUSH_BACK(SharedString(pkg.category));
+	m_names.PUSH_BACK(SharedString(pkg.name));
+	m_first_version.PUSH_BACK(m_versions.size());
+	for(Package::const_iterator it(pkg.begin()); likely(it != pkg.end()); ++it) {
+		m_versions.PUSH_BACK(SharedString(it->getFull()));
+		m_slots.PUSH_BACK(it->slotname);
+		m_subslots.PUSH_BACK(it->subslotname);
+		m_repos.PUSH_BACK(SharedString(it->reponame));
+	}
+}
+
+void PackageIndex::sort() const {
+	if(likely(m_sorted)) {
+		return;
+	}
+	m_sorted = true;
+	size_type n(m_names.size());
+	vector<size_type> order(n);
+	for(size_type i(0); likely(i != n); ++i) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), PackageIndexLess(m_categories, m_names));
+	vector<SharedString> categories(n), names(n);
+	vector<size_type> first_version(n);
+	vector<SharedString> versions, slots, subslots, repos;
+	versions.reserve(m_versions.size());
+	slots.reserve(m_versions.size());
+	subslots.reserve(m_versions.size());
+	repos.reserve(m_versions.size());
+	for(size_type i(0); likely(i != n); ++i) {
+		size_type j(order[i]);
+		categories[i] = m_categories[j];
+		names[i] = m_names[j];
+		first_version[i] = versions.size();
+		for(size_type v(m_first_version[j]); likely(v != end_version(j)); ++v) {
+			versions.PUSH_BACK(m_versions[v]);
+			slots.PUSH_BACK(m_slots[v]);
+			subslots.PUSH_BACK(m_subslots[v]);
+			repos.PUSH_BACK(m_repos[v]);
+		}
+	}
+	m_categories.swap(categories);
+	m_names.swap(names);
+	m_first_version.swap(first_version);
+	m_versions.swap(versions);
+	m_slots.swap(slots);
+	m_subslots.swap(subslots);
+	m_repos.swap(repos);
+}
+
+void PackageIndex::find_category(const string& cat, size_type *first, size_type *last) const {
+	sort();
+	std::pair<vector<SharedString>::const_iterator, vector<SharedString>::const_iterator>
+		range(std::equal_range(m_categories.begin(), m_categories.end(), cat, SharedStringLess()));
+	*first = range.first - m_categories.begin();
+	*last = range.second - m_categories.begin();
+}
+
+PackageIndex::size_type PackageIndex::find(const string& cat, const string& name) const {
+	size_type first, last;
+	find_category(cat, &first, &last);
+	vector<SharedString>::const_iterator it(std::lower_bound(
+		m_names.begin() + first, m_names.begin() + last, name, SharedStringLess()));
+	size_type i(it - m_names.begin());
+	if((i != last) && (it->get() == name)) {
+		return i;
+	}
+	return size();
+}
+
+void PackageIndex::get_package(size_type i, Package *pkg) const {
+	sort();
+	pkg->category = m_categories[i].get();
+	pkg->name = m_names[i].get();
+	for(size_type v(m_first_version[i]); likely(v != end_version(i)); ++v) {
+		Version *version(new Version);
+		string errtext;
+		version->parseVersion(m_versions[v].get(), &errtext);
+		version->slotname = m_slots[v];
+		version->subslotname = m_subslots[v];
+		version->reponame = m_repos[v].get();
+		pkg->addVersion(version);
+	}
+}
+
+bool PackageIndex::ismatch(const Mask& m, size_type i) const {
+	sort();
+	if((fnmatch(m.getName(), m_names[i].c_str(), 0) != 0) ||
+		(fnmatch(m.getCategory(), m_categories[i].c_str(), 0) != 0)) {
+		return false;
+	}
+	Package pkg;
+	get_package(i, &pkg);
+	return m.have_match(pkg);
+}
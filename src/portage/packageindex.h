@@ -0,0 +1,100 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_PORTAGE_PACKAGEINDEX_H_
+#define SRC_PORTAGE_PACKAGEINDEX_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/sharedstring.h"
+
+class Mask;
+class Package;
+
+/**
+A compact index of all packages of a tree, e.g. for --test-non-matching.
+Only the data needed to test a Mask are kept: category and name, and for
+each version the version string, slot, subslot, and repository.
+The data are stored as arrays (one per field) of pooled strings; the
+versions of all packages are kept in one array, and each package refers
+to a range of it. Package objects are only created for testing a mask.
+**/
+class PackageIndex {
+	public:
+		typedef std::vector<SharedString>::size_type size_type;
+
+		PackageIndex() : m_sorted(true) {
+		}
+
+		/**
+		Add the data of pkg; pkg itself is not stored
+		**/
+		void add(const Package& pkg);
+
+		size_type size() const {
+			return m_names.size();
+		}
+
+		const std::string& category(size_type i) const {
+			sort();
+			return m_categories[i].get();
+		}
+
+		const std::string& name(size_type i) const {
+			sort();
+			return m_names[i].get();
+		}
+
+		/**
+		Let [*first, *last) be the indices of the packages of category cat
+		**/
+		ATTRIBUTE_NONNULL_ void find_category(const std::string& cat, size_type *first, size_type *last) const;
+
+		/**
+		@return the index of the package or size() if there is no such package
+		**/
+		size_type find(const std::string& cat, const std::string& name) const;
+
+		/**
+		Add the category, name, and versions of package i to pkg
+		**/
+		ATTRIBUTE_NONNULL_ void get_package(size_type i, Package *pkg) const;
+
+		/**
+		@return true if m matches package i
+		**/
+		bool ismatch(const Mask& m, size_type i) const;
+
+	private:
+		/**
+		The packages; if m_sorted, they are sorted by category and name.
+		The versions of package i are m_first_version[i] up to (excluding)
+		m_first_version[i + 1] or the end of the version arrays.
+		**/
+		mutable std::vector<SharedString> m_categories, m_names;
+		mutable std::vector<size_type> m_first_version;
+
+		/**
+		The versions
+		**/
+		mutable std::vector<SharedString> m_versions, m_slots, m_subslots, m_repos;
+
+		mutable bool m_sorted;
+
+		void sort() const;
+
+		size_type end_version(size_type i) const {
+			++i;
+			return ((i == m_first_version.size()) ? m_versions.size() : m_first_version[i]);
+		}
+};
+
+#endif  // SRC_PORTAGE_PACKAGEINDEX_H_
@@ -10,10 +10,10 @@
 #include "portage/packagetree.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
-#include "eixTk/assert.h"
 #include "eixTk/eixint.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
@@ -23,36 +23,28 @@
 using std::pair;
 using std::string;
 
-PackagePtr *comparer = NULLPTR;
-
-void Category::init_static() {
-	eix_assert_static(comparer == NULLPTR);
-	comparer = new PackagePtr(new Package);
-}
-
-Category::iterator Category::find(const std::string& pkg_name) {
-	eix_assert_static(comparer != NULLPTR);
-	(*comparer)->name = pkg_name;
-	return static_cast<const_iterator>(super::find(*comparer));
-}
-
-Category::const_iterator Category::find(const std::string& pkg_name) const {
-	eix_assert_static(comparer != NULLPTR);
-	(*comparer)->name = pkg_name;
-	return static_cast<const_iterator>(super::find(*comparer));
+/**
+Sort the vector once after packages were added out of order.
+This does not change the content of the category, so we allow it for const.
+**/
+void Category::sort() const {
+	if(likely(m_sorted)) {
+		return;
+	}
+	m_sorted = true;
+	Category *self(const_cast<Category *>(this));
+	std::sort(self->super::begin(), self->super::end());
 }
 
-#if 0
-bool Category::deletePackage(const std::string& pkg_name) {
-	iterator i(find(pkg_name));
-	if(i == end()) {
-		return false;
+void Category::addPackage(Package *pkg) {
+	if(unlikely(!m_index.insert(Index::value_type(pkg->name, pkg)).second)) {
+		return;
 	}
-	delete *i;
-	erase(i);
-	return true;
+	if(m_sorted && !empty() && !(back()->name < pkg->name)) {
+		m_sorted = false;
+	}
+	push_back(PackagePtr(pkg));
 }
-#endif
 
 Package *Category::addPackage(const string cat_name, const string& pkg_name) {
 	Package *p(new Package(cat_name, pkg_name));
@@ -13,41 +13,76 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <map>
-#include <set>
 #include <string>
+#include <vector>
 
 #include "eixTk/attribute.h"
 #include "eixTk/eixint.h"
+#include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/ptr_container.h"
 #include "eixTk/stringtypes.h"
+#include "eixTk/unordered_map.h"
 #include "portage/package.h"
 
-class Category : public eix::ptr_container<std::set<PackagePtr> > {
+/**
+The packages of a category. Packages are found by a hashed index of their
+names, and they are appended to a vector which is sorted by name only when
+it is iterated. Thus adding packages costs neither string compares nor
+tree nodes, and the iteration order (e.g. for the database) is still sorted.
+Adding a package invalidates the iterators.
+**/
+class Category : public eix::ptr_container<std::vector<PackagePtr> > {
 	public:
-		typedef eix::ptr_container<std::set<PackagePtr> > super;
+		typedef eix::ptr_container<std::vector<PackagePtr> > super;
 
-		static void init_static();
+	private:
+		typedef UNORDERED_MAP<std::string, Package *> Index;
+		Index m_index;
 
-		Category() {
+		/**
+		Are the packages in the vector sorted?
+		**/
+		mutable bool m_sorted;
+
+		void sort() const;
+
+	public:
+		Category() : m_sorted(true) {
 		}
 
 		~Category() {
 			delete_and_clear();
 		}
 
-		iterator find(const std::string& pkg_name);
-		const_iterator find(const std::string& pkg_name) const;
+		iterator begin() {
+			sort();
+			return iterator(super::begin());
+		}
 
-		Package *findPackage(const std::string& pkg_name) const {
-			const_iterator i(find(pkg_name));
-			return ((i == end()) ? NULLPTR : static_cast<Package *>(*i));
+		const_iterator begin() const {
+			sort();
+			return const_iterator(super::begin());
 		}
 
-		ATTRIBUTE_NONNULL_ void addPackage(Package *pkg) {
-			insert(PackagePtr(pkg));
+		iterator end() {
+			return iterator(super::end());
 		}
 
+		const_iterator end() const {
+			return const_iterator(super::end());
+		}
+
+		Package *findPackage(const std::string& pkg_name) const {
+			Index::const_iterator i(m_index.find(pkg_name));
+			return ((i == m_index.end()) ? NULLPTR : i->second);
+		}
+
+		/**
+		Add pkg unless a package of the same name exists already
+		**/
+		ATTRIBUTE_NONNULL_ void addPackage(Package *pkg);
+
 		Package *addPackage(const std::string cat_name, const std::string& pkg_name);
 };
 
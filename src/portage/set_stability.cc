@@ -15,6 +15,7 @@
 #ifdef EIX_PARANOIC_ASSERT
 #include <cstdlib>
 
+#include "eixTk/eixint.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
 #endif
@@ -62,7 +63,11 @@ Version::SavedMaskIndex SetStability::mask_index(bool get_local) const {
 
 #endif
 
+eix::UNumber SetStability::recalculations = 0;
+eix::UNumber SetStability::reused = 0;
+
 void SetStability::set_stability(bool get_local, Package *package) const {
+	++recalculations;
 	if(get_local) {
 		portagesettings->user_config->setMasks(package, m_filemask_is_profile);
 		portagesettings->user_config->setKeyflags(package);
@@ -78,6 +83,7 @@ void SetStability::calc_version_flags(bool get_local, MaskFlags *maskflags, Keyw
 	Version::SavedMaskIndex mi(mask_index(get_local));
 	Version::SavedKeyIndex ki(keyword_index(get_local));
 	if(likely(v->have_saved_masks[mi] && v->have_saved_keywords[ki])) {
+		++reused;
 		if(maskflags != NULLPTR) {
 			*maskflags = v->saved_masks[mi];
 		}
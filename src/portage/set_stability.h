@@ -13,6 +13,7 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include "eixTk/attribute.h"
+#include "eixTk/eixint.h"
 #include "portage/version.h"
 
 class Category;
@@ -55,6 +56,12 @@ class SetStability {
 #endif
 
 	public:
+		/**
+		Statistics for eix --stats: How often was the stability
+		of a package calculated or could saved flags be used instead?
+		**/
+		static eix::UNumber recalculations, reused;
+
 		ATTRIBUTE_NONNULL_ SetStability(const PortageSettings *psettings, bool localsettings, bool filemask_is_profile, bool always_accept_keywords) {
 			portagesettings = psettings;
 			m_local = localsettings;
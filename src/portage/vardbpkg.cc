@@ -274,10 +274,9 @@ bool VarDbPkg::readUse(const Package& p, InstVersion *v) const {
 		}
 	}
 
-	IUseSet::IUseStd iuse_std(iuse_set.asStd());
 	for(WordVec::iterator it(alluse.begin());
 		likely(it != alluse.end()); ++it) {
-		if(iuse_std.count(IUse(*it)) != 0) {
+		if(iuse_set.has(IUse(*it).name())) {
 			v->usedUse.INSERT(MOVE(*it));
 		}
 	}
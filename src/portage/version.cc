@@ -10,14 +10,18 @@
 #include "portage/version.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <algorithm>
+#include <set>
 #include <string>
 
+#include "eixTk/assert.h"
 #include "eixTk/dialect.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringlist.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
 
 using std::string;
 
@@ -102,11 +106,58 @@ string IUse::asString() const {
 	return ret;
 }
 
+/**
+Order of the pool: by name, then by flags
+**/
+class IUsePoolLess {
+	public:
+		bool operator()(const IUse& a, const IUse& b) const {
+			int c(a.name().compare(b.name()));
+			if(c != 0) {
+				return (c < 0);
+			}
+			return (a.flags < b.flags);
+		}
+};
+
+/**
+Order of IUseSet: by name only
+**/
+class IUseNameLess {
+	public:
+		bool operator()(const IUse *a, const string& b) const {
+			return (a->name() < b);
+		}
+};
+
+typedef std::set<IUse, IUsePoolLess> IUsePool;
+typedef UNORDERED_MAP<string, const IUse *> IUseTokens;
+static IUsePool *iuse_pool(NULLPTR);
+static IUseTokens *iuse_tokens(NULLPTR);
+
+static const IUse *pooled_iuse(const string& name, IUse::Flags flags);
+
+static const IUse *pooled_iuse(const string& name, IUse::Flags flags) {
+	eix_assert_static(iuse_pool != NULLPTR);
+	return &(*(iuse_pool->EMPLACE(IUse, (name, flags)).first));
+}
+
+void IUseSet::init_static() {
+	eix_assert_static(iuse_pool == NULLPTR);
+	iuse_pool = new IUsePool;
+	iuse_tokens = new IUseTokens;
+}
+
+bool IUseSet::has(const string& name) const {
+	IUseStd::const_iterator it(std::lower_bound(m_iuse.begin(), m_iuse.end(), name, IUseNameLess()));
+	return ((it != m_iuse.end()) && ((*it)->name() == name));
+}
+
 IUseSet::IUseNaturalOrder IUseSet::asNaturalOrder() const {
 	IUseNaturalOrder ret;
 	for(IUseStd::const_iterator it(m_iuse.begin());
 		likely(it != m_iuse.end()); ++it) {
-		ret.insert(&(*it));
+		ret.insert(*it);
 	}
 	return ret;
 }
@@ -134,11 +185,38 @@ WordVec IUseSet::asVector() const {
 	return ret;
 }
 
-void IUseSet::insert(const IUseStd& iuse) {
-	for(IUseStd::const_iterator it(iuse.begin());
-		likely(it != iuse.end()); ++it) {
-		insert(*it);
+/**
+Merge the two sorted vectors; flags of equal names are or-ed
+**/
+void IUseSet::insert(const IUseSet& iuse) {
+	if(iuse.m_iuse.empty()) {
+		return;
 	}
+	if(m_iuse.empty()) {
+		m_iuse = iuse.m_iuse;
+		return;
+	}
+	IUseStd res;
+	res.reserve(m_iuse.size() + iuse.m_iuse.size());
+	IUseStd::const_iterator a(m_iuse.begin());
+	IUseStd::const_iterator b(iuse.m_iuse.begin());
+	while((a != m_iuse.end()) && (b != iuse.m_iuse.end())) {
+		int c((*a)->name().compare((*b)->name()));
+		if(c < 0) {
+			res.PUSH_BACK(*a++);
+		} else if(c > 0) {
+			res.PUSH_BACK(*b++);
+		} else {
+			IUse::Flags flags((*a)->flags | (*b)->flags);
+			res.PUSH_BACK((flags == (*a)->flags) ? *a :
+				((flags == (*b)->flags) ? *b : pooled_iuse((*a)->name(), flags)));
+			++a;
+			++b;
+		}
+	}
+	res.insert(res.end(), a, IUseStd::const_iterator(m_iuse.end()));
+	res.insert(res.end(), b, iuse.m_iuse.end());
+	m_iuse.swap(res);
 }
 
 void IUseSet::insert(const string& iuse) {
@@ -150,19 +228,31 @@ void IUseSet::insert(const string& iuse) {
 	}
 }
 
-void IUseSet::insert(const IUse& iuse) {
-	IUseStd::iterator it(m_iuse.find(iuse));
-	if(it == m_iuse.end()) {
-		m_iuse.insert(iuse);
+void IUseSet::insert_fast(const string& iuse) {
+	eix_assert_static(iuse_tokens != NULLPTR);
+	IUseTokens::const_iterator it(iuse_tokens->find(iuse));
+	if(likely(it != iuse_tokens->end())) {
+		insert(it->second);
+		return;
+	}
+	IUse parsed(iuse);
+	const IUse *pooled(pooled_iuse(parsed.name(), parsed.flags));
+	(*iuse_tokens)[iuse] = pooled;
+	insert(pooled);
+}
+
+void IUseSet::insert(const IUse *iuse) {
+	IUseStd::iterator it(std::lower_bound(m_iuse.begin(), m_iuse.end(), iuse->name(), IUseNameLess()));
+	if((it == m_iuse.end()) || ((*it)->name() != iuse->name())) {
+		m_iuse.insert(it, iuse);
 		return;
 	}
-	IUse::Flags oriflags(it->flags);
-	IUse::Flags newflags(oriflags | (iuse.flags));
+	IUse::Flags oriflags((*it)->flags);
+	IUse::Flags newflags(oriflags | (iuse->flags));
 	if(newflags == oriflags) {
 		return;
 	}
-	m_iuse.erase(it);
-	m_iuse.EMPLACE(IUse, (iuse.name(), newflags));
+	*it = ((newflags == iuse->flags) ? iuse : pooled_iuse(iuse->name(), newflags));
 }
 
 const Version::EffectiveState
@@ -181,13 +271,13 @@ Version::Version() :
 
 void Version::modify_effective_keywords(const string& modify_keys) {
 	if(effective_state == EFFECTIVE_UNUSED) {
-		if(!modify_keywords(&effective_keywords, full_keywords, modify_keys)) {
+		if(!modify_keywords(&effective_keywords, full_keywords.get(), modify_keys)) {
 			return;
 		}
 	} else if(!modify_keywords(&effective_keywords, effective_keywords, modify_keys)) {
 		return;
 	}
-	if(likely(effective_keywords == full_keywords)) {
+	if(likely(effective_keywords == full_keywords.get())) {
 		effective_state = EFFECTIVE_UNUSED;
 		effective_keywords.clear();
 	} else {
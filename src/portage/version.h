@@ -21,6 +21,7 @@
 #include "eixTk/dialect.h"
 #include "eixTk/eixarray.h"
 #include "eixTk/eixint.h"
+#include "eixTk/sharedstring.h"
 #include "eixTk/stringlist.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
@@ -125,11 +126,19 @@ class IUseNatural {
 		const IUse *m_iuse;
 };
 
+/**
+Set of IUSE flags, sorted by name.
+The entries point into a global pool which holds every combination of
+name and flags only once; also each token (e.g. from the database) is
+parsed only once.
+**/
 class IUseSet {
 	public:
-		typedef std::set<IUse> IUseStd;
+		typedef std::vector<const IUse *> IUseStd;
 		typedef std::set<IUseNatural> IUseNaturalOrder;
 
+		static void init_static();  // must be called exactly once
+
 		bool empty() const {
 			return m_iuse.empty();
 		}
@@ -142,19 +151,18 @@ class IUseSet {
 			return m_iuse;
 		}
 
-		IUseNaturalOrder asNaturalOrder() const;
+		/**
+		@return true if the set contains a flag with the given name
+		**/
+		ATTRIBUTE_PURE bool has(const std::string& name) const;
 
-		void insert(const IUseStd& iuse);
+		IUseNaturalOrder asNaturalOrder() const;
 
-		void insert(const IUseSet& iuse) {
-			insert(iuse.asStd());
-		}
+		void insert(const IUseSet& iuse);
 
 		void insert(const std::string& iuse);
 
-		void insert_fast(const std::string& iuse) {
-			insert(IUse(iuse));
-		}
+		void insert_fast(const std::string& iuse);
 
 		std::string asString() const;
 
@@ -163,7 +171,7 @@ class IUseSet {
 	protected:
 		IUseStd m_iuse;
 
-		void insert(const IUse& iuse);
+		void insert(const IUse *iuse);
 };
 
 /**
@@ -211,7 +219,7 @@ class Version FINAL : public ExtendedVersion, public Keywords {
 
 		static bool use_required_use;
 
-		std::string required_use;
+		SharedWords required_use;
 
 		Version();
 
@@ -255,7 +263,7 @@ class Version FINAL : public ExtendedVersion, public Keywords {
 
 		void set_required_use(const char *s) {
 			if(use_required_use) {
-				required_use.assign(s);
+				required_use.assign(std::string(s));
 			}
 		}
 
@@ -290,13 +298,21 @@ class Version FINAL : public ExtendedVersion, public Keywords {
 		}
 
 		void set_full_keywords(const std::string& keywords) {
+			full_keywords.assign(keywords);
+		}
+
+		void set_full_keywords(const SharedWords& keywords) {
 			full_keywords = keywords;
 		}
 
-		std::string get_full_keywords() const {
+		const SharedWords& get_shared_keywords() const {
 			return full_keywords;
 		}
 
+		const std::string& get_full_keywords() const {
+			return full_keywords.get();
+		}
+
 		void reset_accepted_effective_keywords() {
 			effective_state = EFFECTIVE_UNUSED;
 			m_accepted_keywords.clear();
@@ -312,17 +328,17 @@ class Version FINAL : public ExtendedVersion, public Keywords {
 		void add_accepted_keywords(const std::string& accepted_keywords);
 
 		const std::string get_effective_keywords() const {
-			return ((effective_state == EFFECTIVE_USED) ? effective_keywords : full_keywords);
+			return ((effective_state == EFFECTIVE_USED) ? effective_keywords : full_keywords.get());
 		}
 
-		KeywordsFlags::KeyType get_keyflags(const WordSet& accepted_keywords) const {
+		KeywordsFlags::KeyType get_keyflags(const AcceptedKeywords& accepted_keywords) const {
 			if(effective_state == EFFECTIVE_USED) {
-				return KeywordsFlags::get_keyflags(accepted_keywords, effective_keywords);
+				return accepted_keywords.get_keyflags(effective_keywords);
 			}
-			return KeywordsFlags::get_keyflags(accepted_keywords, full_keywords);
+			return accepted_keywords.get_keyflags(full_keywords.get());
 		}
 
-		void set_keyflags(const WordSet& accepted_keywords) {
+		void set_keyflags(const AcceptedKeywords& accepted_keywords) {
 			keyflags.set_keyflags(get_keyflags(accepted_keywords));
 		}
 
@@ -340,7 +356,8 @@ class Version FINAL : public ExtendedVersion, public Keywords {
 
 	protected:
 		Reasons reasons;
-		std::string full_keywords, effective_keywords;
+		SharedWords full_keywords;
+		std::string effective_keywords;
 		EffectiveState effective_state;
 };
 
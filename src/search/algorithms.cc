@@ -14,11 +14,15 @@
 
 #include <cstring>
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "eixTk/assert.h"
+#include "eixTk/dialect.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/stringutils.h"
 #include "portage/package.h"
 #include "search/levenshtein.h"
 
@@ -36,27 +40,31 @@ using std::string;
 
 FuzzyAlgorithm::LevenshteinMap *FuzzyAlgorithm::levenshtein_map = NULLPTR;
 
-bool BaseAlgorithm::operator()(const char *s, Package *p, bool simplify) {
-	if(can_simplify() && unlikely(!have_simplified) && likely(simplify)) {
-		have_simplified = true;
-		// cut out the first nonempty valid search string
-		for(string::size_type i = 0; i < search_string.length(); ++i) {
-			if(likely(is_valid_pkgpath(search_string[i]))) {
-				if(unlikely(i > 0)) {
-					search_string.erase(0, i);
-				}
-				break;
+void BaseAlgorithm::simplify(string *s) {
+	for(string::size_type i = 0; i < s->length(); ++i) {
+		if(likely(is_valid_pkgpath((*s)[i]))) {
+			if(unlikely(i > 0)) {
+				s->erase(0, i);
 			}
+			break;
 		}
-		for(string::size_type i = 0; i < search_string.length(); ++i) {
-			if(unlikely(!is_valid_pkgpath(search_string[i]))) {
-				if(likely(i > 0)) {
-					search_string.erase(i);
-				}
-				break;
+	}
+	for(string::size_type i = 0; i < s->length(); ++i) {
+		if(unlikely(!is_valid_pkgpath((*s)[i]))) {
+			if(likely(i > 0)) {
+				s->erase(i);
 			}
+			break;
 		}
 	}
+}
+
+bool BaseAlgorithm::operator()(const char *s, Package *p, bool simplify_string) {
+	if(can_simplify() && unlikely(!have_simplified) && likely(simplify_string)) {
+		have_simplified = true;
+		// cut out the first nonempty valid search string
+		simplify(&search_string);
+	}
 	return (*this)(s, p);
 }
 
@@ -103,3 +111,116 @@ bool EndAlgorithm::operator()(const char *s, Package * /* p */) const {
 bool PatternAlgorithm::operator()(const char *s, Package * /* p */) const {
 	return (fnmatch(search_string.c_str(), s, FNMATCH_FLAGS) == 0);
 }
+
+/**
+@return the node reached from node by c or 0 (the root) if there is none
+**/
+MultiAlgorithm::Index MultiAlgorithm::step(Index node, char c) const {
+	const std::vector<TrieEdge>& edges(trie[node].edges);
+	std::vector<TrieEdge>::const_iterator it(std::lower_bound(edges.begin(), edges.end(), TrieEdge(c, 0)));
+	if((it != edges.end()) && (it->c == c)) {
+		return it->next;
+	}
+	return 0;
+}
+
+void MultiAlgorithm::add(const string& s) {
+	if(mode == FOLD_EXACT) {
+		exact.INSERT(s);
+		return;
+	}
+	Index node(0);
+	for(string::size_type i(0); likely(i < s.size()); ++i) {
+		// For end-of-string matching the trie is built from the reversed strings
+		char c((mode == FOLD_END) ? s[s.size() - 1 - i] : s[i]);
+		Index next(step(node, c));
+		if(next == 0) {
+			next = trie.size();
+			std::vector<TrieEdge>& edges(trie[node].edges);
+			edges.insert(std::upper_bound(edges.begin(), edges.end(), TrieEdge(c, next)), TrieEdge(c, next));
+			trie.PUSH_BACK(TrieNode());
+		}
+		node = next;
+	}
+	trie[node].terminal = true;
+}
+
+/**
+Calculate the failure links of the Aho-Corasick automaton by breadth first
+search; a node is terminal if some suffix of its string is a search string.
+**/
+void MultiAlgorithm::finalize() {
+	if(mode != FOLD_SUBSTRING) {
+		return;
+	}
+	std::vector<Index> queue;
+	for(std::vector<TrieEdge>::const_iterator it(trie[0].edges.begin());
+		likely(it != trie[0].edges.end()); ++it) {
+		queue.PUSH_BACK(it->next);
+	}
+	for(std::vector<Index>::size_type q(0); likely(q < queue.size()); ++q) {
+		Index node(queue[q]);
+		for(std::vector<TrieEdge>::const_iterator it(trie[node].edges.begin());
+			likely(it != trie[node].edges.end()); ++it) {
+			Index f(trie[node].fail);
+			Index next;
+			while(((next = step(f, it->c)) == 0) && (f != 0)) {
+				f = trie[f].fail;
+			}
+			TrieNode& child(trie[it->next]);
+			child.fail = next;
+			if(trie[next].terminal) {
+				child.terminal = true;
+			}
+			queue.PUSH_BACK(it->next);
+		}
+	}
+}
+
+bool MultiAlgorithm::operator()(const char *s, Package * /* p */) const {
+	if(trie[0].terminal) {
+		return true;
+	}
+	switch(mode) {
+		case FOLD_EXACT:
+			return (exact.count(s) != 0);
+		case FOLD_BEGIN: {
+				Index node(0);
+				for(; likely(*s != '\0'); ++s) {
+					if((node = step(node, *s)) == 0) {
+						return false;
+					}
+					if(trie[node].terminal) {
+						return true;
+					}
+				}
+				return false;
+			}
+		case FOLD_END: {
+				Index node(0);
+				for(const char *e(s + std::strlen(s)); likely(e != s); ) {
+					if((node = step(node, *(--e))) == 0) {
+						return false;
+					}
+					if(trie[node].terminal) {
+						return true;
+					}
+				}
+				return false;
+			}
+		default: {
+				Index node(0);
+				for(; likely(*s != '\0'); ++s) {
+					Index next;
+					while(((next = step(node, *s)) == 0) && (node != 0)) {
+						node = trie[node].fail;
+					}
+					node = next;
+					if(trie[node].terminal) {
+						return true;
+					}
+				}
+				return false;
+			}
+	}
+}
@@ -13,16 +13,30 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <string>
+#include <vector>
 
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
 #include "eixTk/regexp.h"
 #include "eixTk/unordered_map.h"
+#include "eixTk/unordered_set.h"
 #include "search/levenshtein.h"
 
 class Package;
 class matchtree;
 
+/**
+The algorithms whose alternatives can be folded into a MultiAlgorithm
+**/
+enum FoldMode {
+	FOLD_NONE,
+	FOLD_EXACT,
+	FOLD_BEGIN,
+	FOLD_END,
+	FOLD_SUBSTRING
+};
+
 /**
 That's how every algorithm will look like.
 **/
@@ -49,6 +63,44 @@ class BaseAlgorithm {
 		ATTRIBUTE_NONNULL((2)) virtual bool operator()(const char *s, Package *p) const = 0;
 
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package *p, bool simplify);
+
+		/**
+		@return a rough estimate of the time for one comparison
+		**/
+		virtual eix::UNumber cost() const {
+			return 1;
+		}
+
+		/**
+		@return a rough estimate of the percentage of strings which match
+		**/
+		virtual eix::UNumber selectivity() const {
+			return (search_string.empty() ? 100 : 10);
+		}
+
+		/**
+		@return true if the matches are recorded for later use so that
+		the algorithm must not be skipped when reordering an "or"
+		**/
+		virtual bool keep_order() const {
+			return false;
+		}
+
+		/**
+		@return the kind of MultiAlgorithm to which we can be folded
+		**/
+		virtual FoldMode fold_mode() const {
+			return FOLD_NONE;
+		}
+
+		const std::string& get_string() const {
+			return search_string;
+		}
+
+		/**
+		Cut out the first nonempty valid part of a package name
+		**/
+		ATTRIBUTE_NONNULL_ static void simplify(std::string *s);
 };
 
 /**
@@ -71,6 +123,10 @@ class RegexAlgorithm FINAL : public BaseAlgorithm {
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE {
 			return re.match(s);
 		}
+
+		eix::UNumber cost() const OVERRIDE {
+			return 4;
+		}
 };
 
 /**
@@ -79,6 +135,14 @@ exact string matching
 class ExactAlgorithm FINAL : public BaseAlgorithm {
 	public:
 		ATTRIBUTE_NONNULL((2)) ATTRIBUTE_PURE bool operator()(const char *s, Package * /* p */) const OVERRIDE;
+
+		FoldMode fold_mode() const OVERRIDE {
+			return FOLD_EXACT;
+		}
+
+		eix::UNumber selectivity() const OVERRIDE {
+			return 1;
+		}
 };
 
 /**
@@ -89,6 +153,10 @@ class SubstringAlgorithm FINAL : public BaseAlgorithm {
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE {
 			return (std::string(s).find(search_string) != std::string::npos);
 		}
+
+		FoldMode fold_mode() const OVERRIDE {
+			return FOLD_SUBSTRING;
+		}
 };
 
 /**
@@ -97,6 +165,10 @@ begin-of-string matching
 class BeginAlgorithm FINAL : public BaseAlgorithm {
 	public:
 		ATTRIBUTE_NONNULL((2)) ATTRIBUTE_PURE bool operator()(const char *s, Package * /* p */) const OVERRIDE;
+
+		FoldMode fold_mode() const OVERRIDE {
+			return FOLD_BEGIN;
+		}
 };
 
 /**
@@ -105,6 +177,10 @@ end-of-string matching
 class EndAlgorithm FINAL : public BaseAlgorithm {
 	public:
 		ATTRIBUTE_NONNULL((2)) ATTRIBUTE_PURE bool operator()(const char *s, Package * /* p */) const OVERRIDE;
+
+		FoldMode fold_mode() const OVERRIDE {
+			return FOLD_END;
+		}
 };
 
 /**
@@ -135,6 +211,14 @@ class FuzzyAlgorithm FINAL : public BaseAlgorithm {
 
 		ATTRIBUTE_NONNULL_ static bool compare(Package *p1, Package *p2);
 
+		eix::UNumber cost() const OVERRIDE {
+			return 8;
+		}
+
+		bool keep_order() const OVERRIDE {
+			return true;
+		}
+
 		static bool sort_by_levenshtein() {
 			return (!levenshtein_map->empty());
 		}
@@ -153,6 +237,79 @@ class PatternAlgorithm FINAL : public BaseAlgorithm {
 
 	public:
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE;
+
+		eix::UNumber cost() const OVERRIDE {
+			return 2;
+		}
+};
+
+/**
+Several "or"ed search strings of the same FoldMode.
+Exact strings are looked up in a hash set; for the other modes a trie
+(an Aho-Corasick automaton for substrings) is used so that the time
+does not grow with the number of search strings.
+**/
+class MultiAlgorithm FINAL : public BaseAlgorithm {
+	protected:
+		typedef std::vector<std::string>::size_type Index;
+
+		class TrieEdge {
+			public:
+				char c;
+				Index next;
+
+				TrieEdge(char ch, Index n) : c(ch), next(n) {
+				}
+
+				bool operator<(const TrieEdge& e) const {
+					return (c < e.c);
+				}
+		};
+
+		class TrieNode {
+			public:
+				std::vector<TrieEdge> edges;  ///< sorted by c
+				Index fail;
+				bool terminal;
+
+				TrieNode() NOEXCEPT : fail(0), terminal(false) {
+				}
+		};
+
+		FoldMode mode;
+		UNORDERED_SET<std::string> exact;
+		std::vector<TrieNode> trie;
+
+		bool can_simplify() const OVERRIDE {
+			return false;
+		}
+
+		ATTRIBUTE_PURE Index step(Index node, char c) const;
+
+	public:
+		explicit MultiAlgorithm(FoldMode m) : mode(m), trie(1) {
+		}
+
+		void setString(const std::string& s) OVERRIDE {
+			add(s);
+		}
+
+		void add(const std::string& s);
+
+		/**
+		Must be called after the last add()
+		**/
+		void finalize();
+
+		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE;
+
+		eix::UNumber cost() const OVERRIDE {
+			return 2;
+		}
+
+		FoldMode fold_mode() const OVERRIDE {
+			return mode;
+		}
 };
 
 #endif  // SRC_SEARCH_ALGORITHMS_H_
@@ -14,14 +14,26 @@
 #include <cstdlib>
 #endif
 
+#include <algorithm>
 #include <stack>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
+#include "eixTk/inttypes.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/phasestats.h"
 #include "search/packagetest.h"
 
+using std::string;
+
+bool MatchTree::collect_stats = false;
+
 bool MatchAtom::match(PackageReader * /* p */) {
 #ifdef DEBUG_MATCHTREE
 	eix::print(m_negate ? " '!' " : " '' ");
@@ -30,6 +42,37 @@ bool MatchAtom::match(PackageReader * /* p */) {
 	return !m_negate;
 }
 
+eix::UNumber MatchAtom::plan(bool * /* keep_order */) {
+	return 0;
+}
+
+void MatchAtom::collect_tests(std::vector<const MatchAtomTest *> * /* tests */) const {
+}
+
+/**
+An operand of an operator together with its estimates
+**/
+class PlannedAtom {
+	public:
+		/**
+		The cost of the operand per chance that it decides the result
+		**/
+		eix::UNumber rank;
+		eix::UNumber cost, selectivity;
+		MatchAtom *atom;
+
+		PlannedAtom(eix::UNumber r, eix::UNumber c, eix::UNumber s, MatchAtom *a)
+			: rank(r), cost(c), selectivity(s), atom(a) {
+		}
+};
+
+static bool cheaper(const PlannedAtom& a, const PlannedAtom& b) {
+	if(a.rank != b.rank) {
+		return (a.rank < b.rank);
+	}
+	return (a.cost < b.cost);
+}
+
 MatchAtomOperator::~MatchAtomOperator() {
 	delete m_left;
 	delete m_right;
@@ -68,6 +111,174 @@ bool MatchAtomOperator::match(PackageReader *p) {
 	return is_match;
 }
 
+void MatchAtomOperator::collect_tests(std::vector<const MatchAtomTest *> *tests) const {
+	if(m_left != NULLPTR) {
+		m_left->collect_tests(tests);
+	}
+	if(m_right != NULLPTR) {
+		m_right->collect_tests(tests);
+	}
+}
+
+void MatchAtomOperator::collect(std::vector<MatchAtom *> *operands, std::vector<MatchAtomOperator *> *nodes) {
+	nodes->PUSH_BACK(this);
+	MatchAtom *children[2] = { m_left, m_right };
+	for(eix::TinyUnsigned i(0); i != 2; ++i) {
+		MatchAtomOperator *o((children[i] == NULLPTR) ? NULLPTR : children[i]->as_operator());
+		if((o != NULLPTR) && (o->m_operator == m_operator) && !(o->m_negate)) {
+			o->collect(operands, nodes);
+		} else {
+			operands->PUSH_BACK(children[i]);
+		}
+	}
+}
+
+/**
+@return atom as a test which can be folded, setting *mode; or NULLPTR
+**/
+static MatchAtomTest *foldable_test(MatchAtom *atom, FoldMode *mode);
+static MatchAtomTest *foldable_test(MatchAtom *atom, FoldMode *mode) {
+	MatchAtomTest *test((atom == NULLPTR) ? NULLPTR : atom->as_test());
+	if((test == NULLPTR) || !test->can_fold()) {
+		return NULLPTR;
+	}
+	*mode = test->get_test()->fold_mode();
+	return ((*mode == FOLD_NONE) ? NULLPTR : test);
+}
+
+void MatchAtomOperator::fold(std::vector<MatchAtom *> *operands) {
+	std::vector<bool> removed(operands->size(), false);
+	bool have_removed(false);
+	for(std::vector<MatchAtom *>::size_type i(0); likely(i < operands->size()); ++i) {
+		FoldMode mode;
+		MatchAtomTest *test;
+		if(removed[i] || ((test = foldable_test((*operands)[i], &mode)) == NULLPTR)) {
+			continue;
+		}
+		PackageTest::MatchField field(test->get_test()->get_field());
+		std::vector<const PackageTest *> alternatives;
+		for(std::vector<MatchAtom *>::size_type j(i + 1); likely(j < operands->size()); ++j) {
+			FoldMode other_mode;
+			MatchAtomTest *other;
+			if(removed[j] ||
+				((other = foldable_test((*operands)[j], &other_mode)) == NULLPTR) ||
+				(other_mode != mode) ||
+				(other->get_test()->get_field() != field)) {
+				continue;
+			}
+			alternatives.PUSH_BACK(other->get_test());
+			test->m_label.append(" | ").append(other->m_label);
+			removed[j] = true;
+		}
+		if(!alternatives.empty()) {
+			test->m_test->fold(alternatives);
+			have_removed = true;
+		}
+	}
+	if(!have_removed) {
+		return;
+	}
+	std::vector<MatchAtom *>::size_type k(0);
+	for(std::vector<MatchAtom *>::size_type j(0); likely(j < operands->size()); ++j) {
+		if(removed[j]) {
+			delete (*operands)[j];
+		} else {
+			(*operands)[k++] = (*operands)[j];
+		}
+	}
+	operands->resize(k);
+}
+
+/**
+Since "and" and "or" are associative and commutative, we can evaluate the
+operands of nested operators of the same type in any order.
+Operands which are NULLPTR count as true and are thus evaluated first.
+An "and" stops at the first operand which fails, an "or" at the first which
+succeeds. Hence we sort by the cost divided by the chance that the operand
+stops the evaluation, and the expected cost is the sum of the costs weighted
+with the chance that the evaluation reaches the operand.
+**/
+eix::UNumber MatchAtomOperator::plan(bool *keep_order) {
+	std::vector<MatchAtom *> operands;
+	std::vector<MatchAtomOperator *> nodes;
+	collect(&operands, &nodes);
+	if(m_operator == AtomOr) {
+		fold(&operands);
+		// Delete the operators which are not needed anymore (but not this)
+		while((nodes.size() > 1) && (nodes.size() >= operands.size())) {
+			MatchAtomOperator *node(nodes.back());
+			nodes.pop_back();
+			node->m_left = node->m_right = NULLPTR;
+			delete node;
+		}
+		if(operands.size() == 1) {
+			// "x and true" is x
+			m_operator = AtomAnd;
+			m_left = operands[0];
+			m_right = NULLPTR;
+			if(m_left == NULLPTR) {
+				m_selectivity = (m_negate ? 0 : 100);
+				return 0;
+			}
+			eix::UNumber cost(m_left->plan(keep_order));
+			m_selectivity = m_left->selectivity();
+			if(m_negate) {
+				m_selectivity = 100 - m_selectivity;
+			}
+			return cost;
+		}
+	}
+	std::vector<PlannedAtom> planned;
+	bool keep(false);
+	for(std::vector<MatchAtom *>::const_iterator it(operands.begin());
+		likely(it != operands.end()); ++it) {
+		eix::UNumber c(0), s(100);
+		if(*it != NULLPTR) {
+			c = (*it)->plan(&keep);
+			s = (*it)->selectivity();
+		}
+		// The percentage of packages for which the operand stops
+		eix::UNumber stop((m_operator == AtomAnd) ? (100 - s) : s);
+		eix::UNumber rank;
+		if(c == 0) {
+			rank = 0;
+		} else if(stop == 0) {
+			rank = static_cast<eix::UNumber>(-1);
+		} else {
+			rank = c * 100 / stop;
+		}
+		planned.PUSH_BACK(PlannedAtom(rank, c, s, *it));
+	}
+	if(keep) {
+		*keep_order = true;
+	}
+	// In an "or", an atom which must be evaluated must not be skipped
+	if(likely((m_operator == AtomAnd) || !keep)) {
+		std::stable_sort(planned.begin(), planned.end(), cheaper);
+	}
+	// The percentage of packages for which the evaluation goes on
+	eix::UNumber cost(0), reach(100);
+	for(std::vector<PlannedAtom>::const_iterator it(planned.begin());
+		likely(it != planned.end()); ++it) {
+		cost += (it->cost * reach + 99) / 100;
+		reach = reach * ((m_operator == AtomAnd) ?
+			it->selectivity : (100 - it->selectivity)) / 100;
+	}
+	m_selectivity = ((m_operator == AtomAnd) ? reach : (100 - reach));
+	if(m_negate) {
+		m_selectivity = 100 - m_selectivity;
+	}
+	// Rebuild the nested operators; this must become the outermost one
+	MatchAtom *left(planned[0].atom);
+	for(std::vector<PlannedAtom>::size_type i(1); likely(i < planned.size()); ++i) {
+		MatchAtomOperator *node((i + 1 == planned.size()) ? this : nodes[i]);
+		node->m_left = left;
+		node->m_right = planned[i].atom;
+		left = node;
+	}
+	return cost;
+}
+
 MatchAtomTest::~MatchAtomTest() {
 #ifndef DEBUG_MATCHTREE
 	delete m_test;
@@ -88,6 +299,21 @@ bool MatchAtomTest::match(PackageReader *p) {
 	eix::print("] ");
 	return false;
 #else
+	if(likely(!MatchTree::collect_stats)) {
+		return match_test(p);
+	}
+	int64_t start(PhaseStats::now());
+	bool is_match(match_test(p));
+	m_time += PhaseStats::now() - start;
+	++m_calls;
+	if(is_match) {
+		++m_matches;
+	}
+	return is_match;
+#endif
+}
+
+bool MatchAtomTest::match_test(PackageReader *p) {
 	bool is_match((likely(m_pipe == NULLPTR)) ||
 		(((*m_pipe) != NULLPTR) && (*m_pipe)->match(p)));
 	if(is_match && ((likely(m_test != NULLPTR)) && !(m_test->match(p)))) {
@@ -97,7 +323,36 @@ bool MatchAtomTest::match(PackageReader *p) {
 		return !is_match;
 	}
 	return is_match;
-#endif
+}
+
+void MatchAtomTest::collect_tests(std::vector<const MatchAtomTest *> *tests) const {
+	tests->PUSH_BACK(this);
+}
+
+void MatchAtomTest::print_stats() const {
+	eix::say_error(_("test %s: %s calls, %s matches, %s rejected, %s ms"))
+		% (m_negate ? (string("! ") + m_label) : m_label)
+		% m_calls % m_matches % (m_calls - m_matches)
+		% PhaseStats::milliseconds(m_time);
+}
+
+eix::UNumber MatchAtomTest::plan(bool *keep_order) {
+	eix::UNumber cost(0);
+	if(m_pipe != NULLPTR) {
+		cost = 1;
+	}
+	m_selectivity = 100;
+	if(likely(m_test != NULLPTR)) {
+		cost += m_test->cost();
+		m_selectivity = m_test->selectivity();
+		if(unlikely(m_test->keep_order())) {
+			*keep_order = true;
+		}
+	}
+	if(m_negate) {
+		m_selectivity = 100 - m_selectivity;
+	}
+	return cost;
 }
 
 void MatchAtomTest::set_test(PackageTest *gtest) {
@@ -117,6 +372,7 @@ void MatchAtomTest::set_test(PackageTest *gtest) {
 
 MatchTree::MatchTree(bool default_is_or) {
 	root = piperoot = NULLPTR;
+	m_tests = m_examined = m_matched = 0;
 	default_operator = (default_is_or ? MatchAtomOperator::AtomOr : MatchAtomOperator::AtomAnd);
 	local_negate = local_finished = false;
 	parser_stack.push(MatchParseData(&root));
@@ -129,7 +385,15 @@ MatchTree::~MatchTree() {
 }
 
 bool MatchTree::match(PackageReader *p) {
-	return ((root == NULLPTR) || root->match(p));
+	if(likely(!collect_stats)) {
+		return ((root == NULLPTR) || root->match(p));
+	}
+	++m_examined;
+	if((root == NULLPTR) || root->match(p)) {
+		++m_matched;
+		return true;
+	}
+	return false;
 }
 
 void MatchTree::set_pipetest(PackageTest *gtest) {
@@ -210,8 +474,18 @@ void MatchTree::parse_test(PackageTest *gtest, bool with_pipe) {
 	local_finished = true;
 	MatchAtomTest *at(parse_new_leaf());
 	at->set_test(gtest);
+	at->m_label = eix::format("#%s") % (++m_tests);
+#ifndef DEBUG_MATCHTREE
+	if(gtest != NULLPTR) {
+		string pattern(gtest->get_pattern());
+		if(!pattern.empty()) {
+			at->m_label.append(eix::format(" \"%s\"") % pattern);
+		}
+	}
+#endif
 	if(with_pipe) {
 		at->m_pipe = &piperoot;
+		at->m_label.append(" (pipe)");
 	}
 	parse_local_negate();
 }
@@ -271,10 +545,19 @@ void MatchTree::parse_close() {
 }
 
 void MatchTree::end_parse() {
+	if(parser_stack.empty()) {
+		return;
+	}
 	parse_local_negate();
 	while(!parser_stack.empty()) {
 		parse_closeforce();
 	}
+#ifndef DEBUG_MATCHTREE
+	if(root != NULLPTR) {
+		bool keep_order(false);
+		root->plan(&keep_order);
+	}
+#endif
 #ifdef DEBUG_MATCHTREE
 	if(root == NULLPTR) {
 		eix::say("root=NULLPTR");
@@ -286,3 +569,16 @@ void MatchTree::end_parse() {
 #endif
 }
 
+void MatchTree::print_stats() const {
+	eix::say_error(_("packages: %s examined, %s matched, %s rejected"))
+		% m_examined % m_matched % (m_examined - m_matched);
+	if(root == NULLPTR) {
+		return;
+	}
+	std::vector<const MatchAtomTest *> tests;
+	root->collect_tests(&tests);
+	for(std::vector<const MatchAtomTest *>::const_iterator it(tests.begin());
+		likely(it != tests.end()); ++it) {
+		(*it)->print_stats();
+	}
+}
@@ -11,9 +11,13 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <stack>
+#include <string>
+#include <vector>
 
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/inttypes.h"
 #include "eixTk/null.h"
 
 class MatchAtomOperator;
@@ -27,11 +31,16 @@ class MatchAtom {
 	protected:
 		bool m_negate;
 
+		/**
+		Estimated percentage of packages which match; set by plan()
+		**/
+		eix::UNumber m_selectivity;
+
 	public:
-		MatchAtom() : m_negate(false) {
+		MatchAtom() : m_negate(false), m_selectivity(100) {
 		}
 
-		explicit MatchAtom(bool negate) : m_negate(negate) {
+		explicit MatchAtom(bool negate) : m_negate(negate), m_selectivity(100) {
 		}
 
 		/**
@@ -47,6 +56,26 @@ class MatchAtom {
 		**/
 		ATTRIBUTE_PURE virtual bool match(PackageReader *p);
 
+		/**
+		Reorder (recursively if necessary) the operands so that the
+		tests which decide the result most cheaply are evaluated first.
+		@param keep_order set to true if the atom must not be skipped
+		@return estimated cost of match()
+		**/
+		ATTRIBUTE_CONST ATTRIBUTE_NONNULL_ virtual eix::UNumber plan(bool *keep_order);
+
+		/**
+		Append (recursively if necessary) the tests in evaluation order
+		**/
+		ATTRIBUTE_NONNULL_ virtual void collect_tests(std::vector<const MatchAtomTest *> *tests) const;
+
+		/**
+		@return estimated percentage of packages which match; set by plan()
+		**/
+		eix::UNumber selectivity() const {
+			return m_selectivity;
+		}
+
 		virtual MatchAtomOperator *as_operator() {
 			return NULLPTR;
 		}
@@ -56,13 +85,23 @@ class MatchAtom {
 		}
 };
 
-class MatchAtomOperator : public MatchAtom {
+class MatchAtomOperator FINAL : public MatchAtom {
 		friend class MatchTree;
 	private:
 		enum AtomOperator { AtomAnd, AtomOr };
 		AtomOperator m_operator;
 		MatchAtom *m_left, *m_right;
 
+		/**
+		Collect the operands of all nested operators of our type
+		**/
+		ATTRIBUTE_NONNULL_ void collect(std::vector<MatchAtom *> *operands, std::vector<MatchAtomOperator *> *nodes);
+
+		/**
+		Fold string tests of an "or" into one test if possible
+		**/
+		ATTRIBUTE_NONNULL_ static void fold(std::vector<MatchAtom *> *operands);
+
 	public:
 		explicit MatchAtomOperator(AtomOperator op)
 			: m_operator(op), m_left(NULLPTR), m_right(NULLPTR) {
@@ -72,27 +111,62 @@ class MatchAtomOperator : public MatchAtom {
 
 		bool match(PackageReader *p) OVERRIDE;
 
+		ATTRIBUTE_NONNULL_ eix::UNumber plan(bool *keep_order) OVERRIDE;
+
+		ATTRIBUTE_NONNULL_ void collect_tests(std::vector<const MatchAtomTest *> *tests) const OVERRIDE;
+
 		MatchAtomOperator *as_operator() OVERRIDE {
 			return this;
 		}
 };
 
 class MatchAtomTest : public MatchAtom {
+		friend class MatchAtomOperator;
 		friend class MatchTree;
 	private:
 		PackageTest *m_test;
 		MatchAtom **m_pipe;
 
+		/**
+		Statistics for MatchTree::collect_stats
+		**/
+		std::string m_label;
+		eix::UNumber m_calls, m_matches;
+		int64_t m_time;
+
+		bool match_test(PackageReader *p);
+
 	public:
-		MatchAtomTest() : m_test(NULLPTR), m_pipe(NULLPTR) {
+		MatchAtomTest() : m_test(NULLPTR), m_pipe(NULLPTR),
+			m_calls(0), m_matches(0), m_time(0) {
 		}
 
 		~MatchAtomTest();
 
 		bool match(PackageReader *p) OVERRIDE;
 
+		ATTRIBUTE_NONNULL_ eix::UNumber plan(bool *keep_order) OVERRIDE;
+
+		ATTRIBUTE_NONNULL_ void collect_tests(std::vector<const MatchAtomTest *> *tests) const OVERRIDE;
+
+		/**
+		Print the statistics of this test to stderr
+		**/
+		void print_stats() const;
+
 		void set_test(PackageTest *gtest);
 
+		/**
+		@return true if the test is not negated and has no pipe
+		**/
+		bool can_fold() const {
+			return (!m_negate && (m_pipe == NULLPTR) && (m_test != NULLPTR));
+		}
+
+		const PackageTest *get_test() const {
+			return m_test;
+		}
+
 		MatchAtomTest *as_test() OVERRIDE {
 			return this;
 		}
@@ -132,6 +206,11 @@ class MatchTree {
 		MatchAtom *root, *piperoot;
 		MatchAtomOperator::AtomOperator default_operator;
 
+		/**
+		Number of tests for the labels; statistics for collect_stats
+		**/
+		eix::UNumber m_tests, m_examined, m_matched;
+
 		/**
 		The following flags must be carefully honoured and updated
 		in every public parse_* function
@@ -170,6 +249,11 @@ class MatchTree {
 		void parse_closeforce();
 
 	public:
+		/**
+		Count calls, matches, and time of every test and of match()
+		**/
+		static bool collect_stats;
+
 		explicit MatchTree(bool default_is_or);
 
 		~MatchTree();
@@ -191,6 +275,11 @@ class MatchTree {
 		void parse_close();
 
 		void end_parse();
+
+		/**
+		Print the statistics (if collect_stats) to stderr
+		**/
+		void print_stats() const;
 };
 
 #endif  // SRC_SEARCH_MATCHTREE_H_
@@ -112,14 +112,11 @@ void NowarnMask::init_nowarn(const WordVec& flagstrings) {
 }
 
 void NowarnMaskList::apply(Package *p, Keywords::Redundant *r, PackageTest::TestInstalled *i, PortageSettings *portagesettings) const {
-	super::Get *masks(get(p));
-	if(masks == NULLPTR) {
-		return;
-	}
+	super::Get masks(get(p));
 	bool found(false);
 	NowarnFlags set_flags, clear_flags;
-	for(super::Get::const_iterator it(masks->begin());
-		likely(it != masks->end()); ++it) {
+	for(super::Get::const_iterator it(masks.begin());
+		likely(it != masks.end()); ++it) {
 		if(!it->have_match(*p)) {
 			continue;
 		}
@@ -127,7 +124,6 @@ void NowarnMaskList::apply(Package *p, Keywords::Redundant *r, PackageTest::Test
 		set_flags.setbits(it->set_flags);
 		clear_flags.setbits(it->clear_flags);
 	}
-	delete masks;
 	// Now we also apply the set-items...
 	typedef set<SetsIndex> MySets;
 	MySets my_sets;
@@ -144,17 +140,13 @@ void NowarnMaskList::apply(Package *p, Keywords::Redundant *r, PackageTest::Test
 	if(unlikely(!my_sets.empty())) {
 		for(MySets::const_iterator sit(my_sets.begin());
 			unlikely(sit != my_sets.end()); ++sit) {
-			super::Get *setmasks(get_setname(portagesettings->set_names[*sit]));
-			if(setmasks == NULLPTR) {
-				continue;
-			}
-			for(super::Get::const_iterator m(setmasks->begin());
-				likely(m != setmasks->end()); ++m) {
+			super::Get setmasks(get_setname(portagesettings->set_names[*sit]));
+			for(super::Get::const_iterator m(setmasks.begin());
+				likely(m != setmasks.end()); ++m) {
 				found = true;
 				set_flags.setbits(m->set_flags);
 				clear_flags.setbits(m->clear_flags);
 			}
-			delete setmasks;
 		}
 	}
 	if(!found) {
@@ -11,9 +11,11 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <string>
+#include <vector>
 
 #include "database/package_reader.h"
 #include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
 #include "eixTk/eixint.h"
 #include "eixTk/filenames.h"
 #include "eixTk/likely.h"
@@ -113,7 +115,9 @@ PackageTest::PackageTest(VarDbPkg *vdb, PortageSettings *p, const PrintFormat *f
 	marked_list = NULLPTR;
 
 	field = NONE;
-	need = PackageReader::NONE;
+	need = string_need = PackageReader::NONE;
+	match_cost = 0;
+	match_selectivity = 100;
 	overlay = obsolete = upgrade = installed = multi_installed =
 		slotted = multi_slot =
 		world = world_only_selected = world_only_file =
@@ -140,7 +144,10 @@ PackageTest::~PackageTest() {
 
 void PackageTest::calculateNeeds() {
 	need = PackageReader::NONE;
-	if((field & (SRC_URI | EAPI | SLOT | FULLSLOT | SET)) != NONE) {
+	if(!Depend::use_depend) {
+		field &= ~DEPSA;
+	}
+	if((field & (SRC_URI | EAPI | SLOT | FULLSLOT | SET | IUSE | DEPSA)) != NONE) {
 		setNeeds(PackageReader::VERSIONS);
 	}
 	if((field & HOMEPAGE) != NONE) {
@@ -161,14 +168,12 @@ void PackageTest::calculateNeeds() {
 	if((field & (USE_ENABLED | USE_DISABLED | INST_EAPI | INST_SLOT | INST_FULLSLOT | DEPSI)) != NONE) {
 		setNeeds(PackageReader::NAME);
 	}
+	// The string test can be done before the rest is read
+	string_need = need;
 	if(installed) {
 		setNeeds(PackageReader::NAME);
 	}
-	if(!Depend::use_depend) {
-		field &= ~DEPSA;
-	}
-	if(((field & (IUSE | DEPSA)) != NONE) ||
-		dup_packages || dup_versions || slotted ||
+	if(dup_packages || dup_versions || slotted ||
 		upgrade || overlay || obsolete ||
 		world || worldset ||
 		have_virtual || have_nonvirtual ||
@@ -187,11 +192,168 @@ void PackageTest::calculateNeeds() {
 		setNeeds(PackageReader::VERSIONS);
 }
 
+/**
+Reading the versions decodes the largest part of a database record
+**/
+static CONSTEXPR const eix::UNumber cost_versions = 32;
+/**
+SRC_URI, EAPI, SLOT and IUSE require a walk over all versions
+**/
+static CONSTEXPR const eix::UNumber cost_version_fields = 4;
+/**
+USE flags, installed EAPI/SLOT and sets require the installed database
+**/
+static CONSTEXPR const eix::UNumber cost_installed_fields = 8;
+/**
+Dependency strings are long and may have to be joined first
+**/
+static CONSTEXPR const eix::UNumber cost_deps = 16;
+/**
+Looking up the package in the installed database
+**/
+static CONSTEXPR const eix::UNumber cost_installed = 8;
+/**
+The stability has to apply all masks and keywords of the profile
+**/
+static CONSTEXPR const eix::UNumber cost_stability = 64;
+/**
+Binary packages require reading the files below PKGDIR
+**/
+static CONSTEXPR const eix::UNumber cost_binary = 128;
+
+/**
+Only a small part of the tree is usually installed
+**/
+static CONSTEXPR const eix::UNumber select_installed = 5;
+/**
+Upgrade and stability tests are true only for a minority of packages
+**/
+static CONSTEXPR const eix::UNumber select_stability = 20;
+/**
+Binary packages exist only for a few installed packages
+**/
+static CONSTEXPR const eix::UNumber select_binary = 5;
+
+/**
+The numbers are only rough guesses: reading the versions from the database
+is expensive, and most expensive are tests which need the stability or
+have to look at installed packages or binary packages.
+The selectivity is the product of the percentages of the subtests; tests
+which we cannot estimate count as always true.
+**/
+void PackageTest::calculateCost() {
+	match_cost = ((need >= PackageReader::VERSIONS) ?
+		cost_versions : static_cast<eix::UNumber>(need));
+	match_selectivity = 100;
+	if(algorithm != NULLPTR) {
+		eix::UNumber fields(0);
+		for(MatchField f(field); f != NONE; f &= f - 1) {
+			++fields;
+		}
+		if((field & (SRC_URI | EAPI | SLOT | FULLSLOT | IUSE)) != NONE) {
+			fields += cost_version_fields;
+		}
+		if((field & (USE_ENABLED | USE_DISABLED | INST_EAPI | INST_SLOT | INST_FULLSLOT | SET)) != NONE) {
+			fields += cost_installed_fields;
+		}
+		if((field & DEPS) != NONE) {
+			fields += cost_deps;
+		}
+		match_cost += fields * algorithm->cost();
+		match_selectivity = algorithm->selectivity();
+	}
+	if(installed || (in_overlay_inst_list != NULLPTR) ||
+		(from_overlay_inst_list != NULLPTR) ||
+		(from_foreign_overlay_inst_list != NULLPTR)) {
+		match_cost += cost_installed;
+		match_selectivity = match_selectivity * select_installed / 100;
+	}
+	if(upgrade || obsolete || (test_installed != INS_NONE) ||
+		(test_instability != STABLE_NONE) ||
+		(test_stability_default != STABLE_NONE) ||
+		(test_stability_local != STABLE_NONE) ||
+		(test_stability_nonlocal != STABLE_NONE)) {
+		match_cost += cost_stability;
+		match_selectivity = match_selectivity * select_stability / 100;
+	}
+	if(binarynum != 0) {
+		match_cost += cost_binary;
+		match_selectivity = match_selectivity * select_binary / 100;
+	}
+}
+
 void PackageTest::finalize() {
 	if(!know_pattern) {
 		setPattern("");
 	}
 	calculateNeeds();
+	calculateCost();
+}
+
+bool PackageTest::keep_order() const {
+	return ((algorithm != NULLPTR) && algorithm->keep_order());
+}
+
+string PackageTest::get_pattern() const {
+	if(algorithm == NULLPTR) {
+		return "";
+	}
+	return algorithm->get_string();
+}
+
+FoldMode PackageTest::fold_mode() const {
+	if(algorithm == NULLPTR) {
+		return FOLD_NONE;
+	}
+	// The search string is simplified only for some fields
+	MatchField simplified(field & (NAME | CATEGORY | CATEGORY_NAME));
+	if((simplified != NONE) && (simplified != field)) {
+		return FOLD_NONE;
+	}
+	if(overlay || obsolete || upgrade || installed || slotted ||
+		world || worldset || have_virtual || have_nonvirtual ||
+		dup_versions || dup_packages ||
+		(binarynum != 0) ||
+		(restrictions != ExtendedVersion::RESTRICT_NONE) ||
+		(properties != ExtendedVersion::PROPERTIES_NONE) ||
+		(overlay_list != NULLPTR) || (overlay_only_list != NULLPTR) ||
+		(in_overlay_inst_list != NULLPTR) ||
+		(from_overlay_inst_list != NULLPTR) ||
+		(from_foreign_overlay_inst_list != NULLPTR) ||
+		(marked_list != NULLPTR) ||
+		(test_installed != INS_NONE) ||
+		(test_instability != STABLE_NONE) ||
+		(test_stability_default != STABLE_NONE) ||
+		(test_stability_local != STABLE_NONE) ||
+		(test_stability_nonlocal != STABLE_NONE)) {
+		return FOLD_NONE;
+	}
+	return algorithm->fold_mode();
+}
+
+/**
+Add the search string of algorithm to multi, simplified if necessary
+**/
+ATTRIBUTE_NONNULL_ static void fold_string(MultiAlgorithm *multi, const BaseAlgorithm *algorithm, PackageTest::MatchField field);
+static void fold_string(MultiAlgorithm *multi, const BaseAlgorithm *algorithm, PackageTest::MatchField field) {
+	string s(algorithm->get_string());
+	if(field != PackageTest::NONE) {
+		BaseAlgorithm::simplify(&s);
+	}
+	multi->add(s);
+}
+
+void PackageTest::fold(const std::vector<const PackageTest *>& alternatives) {
+	MultiAlgorithm *multi(new MultiAlgorithm(algorithm->fold_mode()));
+	MatchField simplified(field & (NAME | CATEGORY | CATEGORY_NAME));
+	fold_string(multi, algorithm, simplified);
+	for(std::vector<const PackageTest *>::const_iterator it(alternatives.begin());
+		likely(it != alternatives.end()); ++it) {
+		fold_string(multi, (*it)->algorithm, simplified);
+	}
+	multi->finalize();
+	setAlgorithm(multi);
+	calculateCost();
 }
 
 /**
@@ -243,7 +405,7 @@ bool PackageTest::stringMatch(Package *pkg) const {
 		const IUseSet::IUseStd& s(pkg->iuse.asStd());
 		for(IUseSet::IUseStd::const_iterator it(s.begin());
 			it != s.end(); ++it) {
-			if((*algorithm)(it->name().c_str(), NULLPTR))
+			if((*algorithm)((*it)->name().c_str(), NULLPTR))
 				return true;
 		}
 	}
@@ -530,6 +692,14 @@ inline static void get_p(Package **p, PackageReader *pkg) {
 bool PackageTest::match(PackageReader *pkg) const {
 	Package *p(NULLPTR);
 
+	// The string test is cheap and often fails: check it before reading more
+	if(unlikely(algorithm != NULLPTR)) {
+		pkg->read(string_need);
+		get_p(&p, pkg);
+		if(!stringMatch(p)) {
+			return false;
+		}
+	}
 	pkg->read(need);
 
 	/* Test the local options.
@@ -559,13 +729,6 @@ bool PackageTest::match(PackageReader *pkg) const {
 	3. Once more: remember to modify "need" in CalculateNeeds() to
 	   ensure the versions really have been read for the package. */
 
-	if(unlikely(algorithm != NULLPTR)) {
-		get_p(&p, pkg);
-		if(!stringMatch(p)) {
-			return false;
-		}
-	}
-
 	if(unlikely(slotted)) {
 		// -1 or -2
 		get_p(&p, pkg);
@@ -19,6 +19,7 @@
 #include "database/package_reader.h"
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
 #include "eixTk/inttypes.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
@@ -26,9 +27,9 @@
 #include "portage/keywords.h"
 #include "portage/package.h"
 #include "portage/set_stability.h"
+#include "search/algorithms.h"
 #include "search/redundancy.h"
 
-class BaseAlgorithm;
 class Mask;
 class MatcherAlgorithm;
 class MatcherField;
@@ -136,6 +137,47 @@ class PackageTest {
 		**/
 		void finalize();
 
+		/**
+		@return a rough estimate of the time for match(); set by finalize()
+		**/
+		eix::UNumber cost() const {
+			return match_cost;
+		}
+
+		/**
+		@return a rough estimate of the percentage of packages for which
+		match() is true; set by finalize()
+		**/
+		eix::UNumber selectivity() const {
+			return match_selectivity;
+		}
+
+		/**
+		@return true if the test must not be skipped when reordering an "or"
+		**/
+		bool keep_order() const;
+
+		/**
+		@return the FoldMode if the test is only a string test which can be
+		folded with others of the same FoldMode and fields
+		**/
+		FoldMode fold_mode() const;
+
+		MatchField get_field() const {
+			return field;
+		}
+
+		/**
+		@return the search string (empty if there is none)
+		**/
+		std::string get_pattern() const;
+
+		/**
+		Let our string test also succeed for the search strings of
+		alternatives which must have the same fold_mode() and fields
+		**/
+		void fold(const std::vector<const PackageTest *>& alternatives);
+
 		/*
 		The constructor of the class *must* set the least restrictive choice.
 		Since --selected --world must act like --selected, the less restrictive
@@ -332,6 +374,18 @@ class PackageTest {
 		**/
 		PackageReader::Attributes need;
 		/**
+		What we need to read for the string test only
+		**/
+		PackageReader::Attributes string_need;
+		/**
+		The estimate for cost()
+		**/
+		eix::UNumber match_cost;
+		/**
+		The estimate for selectivity()
+		**/
+		eix::UNumber match_selectivity;
+		/**
 		Our string matching algorithm
 		**/
 		BaseAlgorithm *algorithm;
@@ -397,6 +451,11 @@ class PackageTest {
 		**/
 		void calculateNeeds();
 
+		/**
+		Estimate match_cost and match_selectivity; must be called after calculateNeeds()
+		**/
+		void calculateCost();
+
 		bool have_redundant(const Package& p, Keywords::Redundant r, const RedAtom& t) const;
 		bool have_redundant(const Package& p, Keywords::Redundant r) const;
 		ATTRIBUTE_NONNULL_ bool instabilitytest(const Package *p, TestStability what) const;
@@ -0,0 +1,93 @@
+#!/usr/bin/env sh
+# This file is part of the eix project and distributed under the
+# terms of the GNU General Public License v2.
+#
+# Copyright (c)
+#   Martin Väth <martin@mvath.de>
+#
+# Read an overlay from a compressed eix database and check that the
+# categories without that overlay are skipped without being decoded.
+set -u
+
+Echo() {
+	printf '%s\n' "$*" >&2
+}
+
+Die() {
+	Echo "$*"
+	exit 1
+}
+
+tmp=`mktemp -d` || Die 'cannot create temporary directory'
+trap 'rm -rf -- "$tmp"' EXIT
+trap 'exit 1' HUP INT TERM
+
+# The eix binary may serve as eix-update if called with that name
+eix_update=${EIX_UPDATE:-./eix-update}
+case $eix_update in
+/*)	:;;
+*)	eix_update=`pwd`/$eix_update;;
+esac
+if [ "${eix_update##*/}" != eix-update ]
+then	ln -s -- "$eix_update" "$tmp/eix-update" || Die 'cannot link eix-update'
+	eix_update=$tmp/eix-update
+fi
+
+# Write the md5-cache entry of a package $3 in category $2 of the repository $1
+Package() {
+	mkdir -p -- "$tmp/$1/metadata/md5-cache/$2" "$tmp/$1/$2/$3" || Die 'mkdir failed'
+	: >"$tmp/$1/$2/$3/$3-1.0.ebuild"
+	printf '%s\n' \
+		'EAPI=8' \
+		"DESCRIPTION=$3 in $2" \
+		'KEYWORDS=amd64' \
+		'LICENSE=GPL-2' \
+		'SLOT=0' \
+		>"$tmp/$1/metadata/md5-cache/$2/$3-1.0"
+}
+
+mkdir -p -- "$tmp/tree/profiles/base" "$tmp/overlay/profiles" \
+	"$tmp/root/etc/portage" || Die 'mkdir failed'
+printf '%s\n' app-misc dev-libs sys-apps >"$tmp/tree/profiles/categories"
+echo gentoo >"$tmp/tree/profiles/repo_name"
+echo 'ARCH="amd64"' >"$tmp/tree/profiles/base/make.defaults"
+echo app-misc >"$tmp/overlay/profiles/categories"
+echo myov >"$tmp/overlay/profiles/repo_name"
+for category in app-misc dev-libs sys-apps
+do	for package in foo bar baz
+	do	Package tree $category $package
+	done
+done
+Package overlay app-misc ovpkg
+printf '%s\n' "PORTDIR=\"$tmp/tree\"" "PORTDIR_OVERLAY=\"$tmp/overlay\"" \
+	>"$tmp/root/etc/portage/make.conf"
+ln -s -- "$tmp/tree/profiles/base" "$tmp/root/etc/portage/make.profile" \
+	|| Die 'cannot link make.profile'
+: >"$tmp/eixrc"
+
+PORTAGE_CONFIGROOT=$tmp/root
+EIXRC=$tmp/eixrc
+EIX_USER=
+EIX_GROUP=
+EIX_UID=0
+EIX_GID=0
+PORTDIR_CACHE_METHOD=metadata-md5
+OVERLAY_CACHE_METHOD=metadata-md5
+export PORTAGE_CONFIGROOT EIXRC EIX_USER EIX_GROUP EIX_UID EIX_GID \
+	PORTDIR_CACHE_METHOD OVERLAY_CACHE_METHOD
+
+COMPRESS_DATABASE=true "$eix_update" -q -o "$tmp/source.eix" \
+	|| Die 'cannot create the compressed database'
+OVERLAY_CACHE_METHOD="eix:$tmp/source.eix:myov" "$eix_update" -q \
+	-o "$tmp/result.eix" --phase-stats "$tmp/stats.json" \
+	|| Die 'cannot read the compressed database'
+
+# The phase reading the overlay from the database must have skipped
+# the categories dev-libs and sys-apps
+stats=`sed -n -e 's/.*"name":"read \[1\] myov"[^}]*"categories_skipped":"\([0-9]*\)","bytes_skipped":"\([0-9]*\)".*/\1 \2/p' \
+	-- "$tmp/stats.json"`
+[ -n "$stats" ] || Die "no skip statistics in `cat -- "$tmp/stats.json"`"
+set -- $stats
+[ "$1" -eq 2 ] || Die "$1 categories skipped instead of 2"
+[ "$2" -gt 0 ] || Die 'no bytes skipped'
+exit 0
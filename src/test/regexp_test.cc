@@ -0,0 +1,91 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+// Compare Regex::match() (which rejects most strings by a literal which
+// every match must contain) with a plain regexec() of the same regex.
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <regex.h>
+
+#include <cstdlib>
+
+#include <string>
+
+#include "eixTk/dialect.h"
+#include "eixTk/formated.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/regexp.h"
+#include "eixTk/stringtypes.h"
+
+using std::string;
+
+static const char *const regexes[] = {
+	"x+?", "x+*", "x+{0,1}", "x+{2}", "x+", "x++", "x+?y", "xy+?z",
+	"ab+*c", "a+?b+?c", "1+?", "x1+?", "x1+{0,1}", "x1+{1}",
+	"x?y", "x*y", "x{0}y", "x{1,2}y", "xy+z", "xy*z", "(xy)+?z",
+	"[xy]+?1", "\\++?", "\\.+*x", "x\\.+?y", "^x+?$", "x|y+?",
+	"Xy+?", "x+?Y",
+	NULLPTR
+};
+
+static const char alphabet[] = "xyz1.+";
+
+/**
+All strings of at most 3 characters of alphabet
+**/
+static void subjects(WordVec *words) {
+	words->PUSH_BACK("");
+	for(string::size_type len(1); len <= 3; ++len) {
+		string::size_type n(1);
+		for(string::size_type i(0); i < len; ++i) {
+			n *= sizeof(alphabet) - 1;
+		}
+		for(string::size_type k(0); k < n; ++k) {
+			string s;
+			for(string::size_type i(0), m(k); i < len; ++i) {
+				s.append(1, alphabet[m % (sizeof(alphabet) - 1)]);
+				m /= sizeof(alphabet) - 1;
+			}
+			words->PUSH_BACK(s);
+		}
+	}
+	words->PUSH_BACK("pkg");
+	words->PUSH_BACK("pkg1");
+	words->PUSH_BACK("pkg11");
+	words->PUSH_BACK("XY");
+}
+
+int main() {
+	WordVec words;
+	subjects(&words);
+	int status(EXIT_SUCCESS);
+	for(int icase(0); icase < 2; ++icase) {
+		int eflags(REG_EXTENDED | (icase ? REG_ICASE : 0));
+		for(const char *const *r(regexes); likely(*r != NULLPTR); ++r) {
+			regex_t plain;
+			if(regcomp(&plain, *r, eflags) != 0) {
+				// Not every system accepts stacked quantifiers
+				continue;
+			}
+			Regex regex(*r, eflags);
+			for(WordVec::const_iterator it(words.begin());
+				likely(it != words.end()); ++it) {
+				bool expected(regexec(&plain, it->c_str(), 0, NULLPTR, 0) == 0);
+				if(likely(regex.match(it->c_str()) == expected)) {
+					continue;
+				}
+				eix::say_error("regex %s (icase %s) on \"%s\": expected %s")
+					% *r % icase % *it % expected;
+				status = EXIT_FAILURE;
+			}
+			regfree(&plain);
+		}
+	}
+	return status;
+}
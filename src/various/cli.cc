@@ -589,13 +589,14 @@ void parse_cli(MatchTree *matchtree, EixRc *eixrc, VarDbPkg *varpkg_db, PortageS
 			if(m.parseMask(word->c_str(), &errtext, -1) != BasicVersion::parsedError) {
 				if(unlikely(*marked_list == NULLPTR)) {
 					*marked_list = new MaskList<Mask>;
+
+					// A single test checks all masks of the marked_list
+					NEW_TEST;
+					*test = PackageTest::CATEGORY_NAME;
+					test->SetMarkedList(*marked_list);
+					matchtree->set_pipetest(test);
 				}
 				(*marked_list)->add(m);
-
-				NEW_TEST;
-				*test = PackageTest::CATEGORY_NAME;
-				test->SetMarkedList(*marked_list);
-				matchtree->set_pipetest(test);
 			}
 		}
 	}
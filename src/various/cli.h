@@ -40,6 +40,7 @@ enum cli_options {
 	O_FMT = 256,
 	O_XML,
 	O_PROTO,
+	O_PROTO_STREAM,
 	O_PRINT_VAR,
 	O_PIPE_MASK,
 	O_ANSI,
@@ -67,6 +68,9 @@ enum cli_options {
 	O_HASH_LICENSE,
 	O_HASH_DEPEND,
 	O_PROFILE_PATHS,
+	O_SERVER,
+	O_BATCH,
+	O_STATS,
 	O_WORLD_SETS,
 	O_STABLE_DEFAULT,
 	O_TESTING_DEFAULT,
@@ -0,0 +1,377 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "various/server.h"
+#include <config.h>  // IWYU pragma: keep
+
+#ifdef HAVE_SYS_UN_H
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "eixTk/diagnostics.h"
+#include "eixTk/dialect.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
+#include "main/main.h"
+
+using std::string;
+using std::vector;
+
+#ifdef HAVE_SYS_UN_H
+
+extern char **environ;
+
+/**
+The client passes its stdin, stdout, and stderr
+**/
+#define SERVER_FDS 3
+
+/**
+Space for the file descriptors in the control message
+**/
+union ServerControl {
+	struct cmsghdr align;
+	char buf[CMSG_SPACE(SERVER_FDS * sizeof(int))];
+};
+
+ATTRIBUTE_NONNULL_ static bool server_address(struct sockaddr_un *addr, const char *path);
+ATTRIBUTE_NONNULL_ static bool write_all(int fd, const char *data, string::size_type len);
+ATTRIBUTE_NONNULL_ static void get_environment(WordVec *env);
+ATTRIBUTE_NONNULL_ static void server_answer(int fd, ServerQuery query, const WordVec& environment);
+
+static bool server_address(struct sockaddr_un *addr, const char *path) {
+	std::memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	if(unlikely(std::strlen(path) >= sizeof(addr->sun_path))) {
+		errno = ENAMETOOLONG;
+		return false;
+	}
+	std::strcpy(addr->sun_path, path);
+	return true;
+}
+
+static bool write_all(int fd, const char *data, string::size_type len) {
+	while(len != 0) {
+		ssize_t r(write(fd, data, len));
+		if(unlikely(r < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += r;
+GCC_DIAG_OFF(sign-conversion)
+		len -= r;
+GCC_DIAG_ON(sign-conversion)
+	}
+	return true;
+}
+
+/**
+The sorted environment without the variables which usually differ
+between the shells of the server and of the client
+**/
+static void get_environment(WordVec *env) {
+	static const char *const ignore[] = { "_=", "PWD=", "OLDPWD=", "SHLVL=", NULLPTR };
+	for(char **e(environ); likely(*e != NULLPTR); ++e) {
+		const char *const *i(ignore);
+		for(; likely(*i != NULLPTR); ++i) {
+			if(std::strncmp(*e, *i, std::strlen(*i)) == 0) {
+				break;
+			}
+		}
+		if(likely(*i == NULLPTR)) {
+			env->PUSH_BACK(*e);
+		}
+	}
+	std::sort(env->begin(), env->end());
+}
+
+bool server_client(const char *path, int argc, char *argv[], int *status) {
+	struct sockaddr_un addr;
+	if(unlikely(!server_address(&addr, path))) {
+		return false;
+	}
+	int fd(socket(AF_UNIX, SOCK_STREAM, 0));
+	if(unlikely(fd < 0)) {
+		return false;
+	}
+	if(connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+		close(fd);
+		return false;
+	}
+
+	// The first byte of the request carries our file descriptors
+	char marker('\0');
+	struct iovec iov;
+	iov.iov_base = &marker;
+	iov.iov_len = 1;
+	ServerControl control;
+	std::memset(&control, 0, sizeof(control));
+	struct msghdr msg;
+	std::memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+	struct cmsghdr *cmsg(CMSG_FIRSTHDR(&msg));
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(SERVER_FDS * sizeof(int));
+	int fds[SERVER_FDS] = { 0, 1, 2 };
+	std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	// Then our working directory, our environment, an empty string,
+	// and the arguments follow, each terminated by '\0'
+	string request;
+	{
+		vector<char> cwd(4096);
+		while(getcwd(&(cwd[0]), cwd.size()) == NULLPTR) {
+			if(unlikely(errno != ERANGE)) {
+				close(fd);
+				return false;
+			}
+			cwd.resize(2 * cwd.size());
+		}
+		request.append(&(cwd[0]));
+		request.append(1, '\0');
+	}
+	WordVec env;
+	get_environment(&env);
+	for(WordVec::const_iterator it(env.begin()); likely(it != env.end()); ++it) {
+		request.append(*it);
+		request.append(1, '\0');
+	}
+	request.append(1, '\0');
+	for(int i(1); likely(i < argc); ++i) {
+		request.append(argv[i]);
+		request.append(1, '\0');
+	}
+	if(unlikely(sendmsg(fd, &msg, 0) != 1) ||
+		unlikely(!write_all(fd, request.c_str(), request.size())) ||
+		unlikely(shutdown(fd, SHUT_WR) != 0)) {
+		close(fd);
+		return false;
+	}
+
+	// We get back the exit status when the command has finished.
+	// If we get nothing, the server has not executed the command,
+	// e.g. because our environment differs.
+	unsigned char c;
+	ssize_t r;
+	while(unlikely((r = read(fd, &c, 1)) < 0) && (errno == EINTR)) {
+	}
+	close(fd);
+	if(unlikely(r != 1)) {
+		return false;
+	}
+	*status = static_cast<int>(c);
+	return true;
+}
+
+static void server_answer(int fd, ServerQuery query, const WordVec& environment) {
+	char marker;
+	struct iovec iov;
+	iov.iov_base = &marker;
+	iov.iov_len = 1;
+	ServerControl control;
+	struct msghdr msg;
+	std::memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+	ssize_t r;
+	while(unlikely((r = recvmsg(fd, &msg, 0)) < 0) && (errno == EINTR)) {
+	}
+	if(unlikely(r != 1)) {
+		return;
+	}
+	struct cmsghdr *cmsg(CMSG_FIRSTHDR(&msg));
+	if(unlikely((cmsg == NULLPTR) ||
+		(cmsg->cmsg_level != SOL_SOCKET) ||
+		(cmsg->cmsg_type != SCM_RIGHTS) ||
+		(cmsg->cmsg_len != CMSG_LEN(SERVER_FDS * sizeof(int))))) {
+		return;
+	}
+	int fds[SERVER_FDS];
+	std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+
+	string request;
+	for(;;) {
+		char buf[4096];
+		r = read(fd, buf, sizeof(buf));
+		if(r > 0) {
+GCC_DIAG_OFF(sign-conversion)
+			request.append(buf, r);
+GCC_DIAG_ON(sign-conversion)
+			continue;
+		}
+		if(likely(r == 0)) {
+			break;
+		}
+		if(errno != EINTR) {
+			return;
+		}
+	}
+
+	vector<char *> words;
+	for(string::size_type pos(0); likely(pos < request.size()); ) {
+		words.PUSH_BACK(&(request[pos]));
+		pos = request.find('\0', pos);
+		if(unlikely(pos == string::npos)) {
+			break;
+		}
+		++pos;
+	}
+	// We answer only if the environment is ours: The resident data
+	// and our eixrc depend on it.
+	vector<char *>::const_iterator it(words.begin());
+	if(unlikely(it == words.end())) {
+		return;
+	}
+	const char *cwd(*it);
+	for(WordVec::const_iterator env(environment.begin()); ; ++env) {
+		if(unlikely(++it == words.end())) {
+			return;
+		}
+		if(**it == '\0') {
+			if(likely(env == environment.end())) {
+				break;
+			}
+			return;
+		}
+		if((env == environment.end()) || (*env != *it)) {
+			return;
+		}
+	}
+	if(unlikely(chdir(cwd) != 0)) {
+		return;
+	}
+	vector<char *> args;
+	args.PUSH_BACK(const_cast<char *>(program_name));
+	args.insert(args.end(), ++it, vector<char *>::const_iterator(words.end()));
+	int argc(static_cast<int>(args.size()));
+	args.PUSH_BACK(NULLPTR);
+
+	for(int i(0); likely(i < SERVER_FDS); ++i) {
+		dup2(fds[i], i);
+	}
+	for(int i(0); likely(i < SERVER_FDS); ++i) {
+		if(fds[i] >= SERVER_FDS) {
+			close(fds[i]);
+		}
+	}
+
+	// The query runs in a further process: Whether it returns or calls
+	// std::exit() (e.g. for --version or for errors), we get its status.
+	pid_t pid(fork());
+	if(pid == 0) {
+		close(fd);
+		int status((*query)(argc, &(args[0])));
+		std::fflush(NULLPTR);
+		_exit(status);
+	}
+	if(unlikely(pid < 0)) {
+		return;
+	}
+	int wstatus;
+	pid_t w;
+	while(unlikely((w = waitpid(pid, &wstatus, 0)) < 0) && (errno == EINTR)) {
+	}
+	unsigned char status(EXIT_FAILURE);
+	if(likely(w == pid) && likely(WIFEXITED(wstatus))) {
+		status = static_cast<unsigned char>(WEXITSTATUS(wstatus));
+	}
+	write_all(fd, reinterpret_cast<const char *>(&status), 1);
+}
+
+bool server_run(const char *path, ServerPrepare prepare, ServerQuery query, string *errtext) {
+	struct sockaddr_un addr;
+	if(unlikely(!server_address(&addr, path))) {
+		*errtext = eix::format(_("cannot use socket %s: %s")) % path % std::strerror(errno);
+		return false;
+	}
+	// Remove the socket of a previous server, but no other file
+	struct stat st;
+	if((lstat(path, &st) == 0) && S_ISSOCK(st.st_mode)) {
+		unlink(path);
+	}
+	// Only our user may connect to the socket
+	int fd(socket(AF_UNIX, SOCK_STREAM, 0));
+	bool bound(false);
+	if(likely(fd >= 0)) {
+		mode_t old_umask(umask(0177));
+		bound = (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0);
+		umask(old_umask);
+	}
+	if(unlikely(!bound) ||
+		unlikely(listen(fd, 16) != 0)) {
+		*errtext = eix::format(_("cannot use socket %s: %s")) % path % std::strerror(errno);
+		if(fd >= 0) {
+			close(fd);
+		}
+		return false;
+	}
+	WordVec environment;
+	get_environment(&environment);
+	// We do not wait for the children
+	std::signal(SIGCHLD, SIG_IGN);
+	for(;;) {
+		int conn(accept(fd, NULLPTR, NULLPTR));
+		if(unlikely(conn < 0)) {
+			if((errno == EINTR) || (errno == ECONNABORTED)) {
+				continue;
+			}
+			*errtext = eix::format(_("cannot use socket %s: %s")) % path % std::strerror(errno);
+			close(fd);
+			return false;
+		}
+		(*prepare)();
+		// Do not output our buffers twice
+		std::fflush(NULLPTR);
+		if(fork() == 0) {
+			close(fd);
+			std::signal(SIGCHLD, SIG_DFL);
+			server_answer(conn, query, environment);
+			_exit(EXIT_SUCCESS);
+		}
+		// If fork() failed, the client gets EOF and assumes failure
+		close(conn);
+	}
+}
+
+#else  /* HAVE_SYS_UN_H */
+
+bool server_client(const char * /* path */, int /* argc */, char * /* argv */ [], int * /* status */) {
+	return false;
+}
+
+bool server_run(const char * /* path */, ServerPrepare /* prepare */, ServerQuery /* query */, string *errtext) {
+	errtext->assign(_("unix sockets are not supported on this system"));
+	return false;
+}
+
+#endif  /* HAVE_SYS_UN_H */
@@ -0,0 +1,48 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_VARIOUS_SERVER_H_
+#define SRC_VARIOUS_SERVER_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+
+#include "eixTk/attribute.h"
+
+/**
+Called by the server before each request, e.g. to reload changed data
+**/
+typedef void (*ServerPrepare)();
+
+/**
+Called by the server in a forked process for each request.
+stdin, stdout, and stderr are those of the client.
+@return the exit status for the client
+**/
+typedef int (*ServerQuery)(int argc, char *argv[]);
+
+/**
+Let the server listening on the unix socket path run our command line.
+Our stdin, stdout, stderr, and working directory are passed to the server.
+@return false if no server is available or if it does not answer us
+since our environment differs from that of the server.
+Otherwise status is set to the exit status of the command.
+**/
+ATTRIBUTE_NONNULL_ bool server_client(const char *path, int argc, char *argv[], int *status);
+
+/**
+Listen on the unix socket path and answer requests of server_client().
+Each request is executed by query in a forked process so that the
+data loaded before (or by prepare) is kept unchanged.
+Only requests from clients with the same environment are answered,
+and only our user can connect to the socket.
+@return only in case of an error
+**/
+ATTRIBUTE_NONNULL_ bool server_run(const char *path, ServerPrepare prepare, ServerQuery query, std::string *errtext);
+
+#endif  // SRC_VARIOUS_SERVER_H_